@@ -0,0 +1,248 @@
+"""
+    DSGE ADPCM Converter
+    Turns a WAV or Ogg file into a .adpcm file, which dsge::Sound and dsge::SoundEffect play without decoding it on the CPU.
+
+    Usage: python adpcm.py input.wav output.adpcm [--rate 32000] [--loop START END]
+
+    - Anything but a 16-bit WAV (and any file with --rate) goes through ffmpeg first, so it has to be installed for those.
+    - Stereo is mixed down to mono, the DSP only decodes ADPCM on mono channels.
+    - Loop points are in samples, END not included. Without --loop the ones in the WAV's "smpl" chunk are used, if any.
+"""
+import argparse
+import os
+import struct
+import subprocess
+import sys
+import tempfile
+
+FRAME_SAMPLES = 14
+SEEK_INTERVAL = 64  # Frames per seek table entry.
+PREDICTORS = 8
+
+
+def read_wav(path):
+    """Returns (rate, mono samples, loop) from a 16-bit PCM WAV, or None if it's something else."""
+    with open(path, "rb") as f:
+        data = f.read()
+
+    if data[0:4] != b"RIFF" or data[8:12] != b"WAVE":
+        return None
+
+    fmt = None
+    pcm = None
+    loop = None
+    pos = 12
+    while pos + 8 <= len(data):
+        chunk, size = struct.unpack_from("<4sI", data, pos)
+        body = data[pos + 8:pos + 8 + size]
+        if chunk == b"fmt ":
+            fmt = struct.unpack_from("<HHIIHH", body)
+        elif chunk == b"data":
+            pcm = body
+        elif chunk == b"smpl" and len(body) >= 60 and struct.unpack_from("<I", body, 28)[0] > 0:
+            start, end = struct.unpack_from("<II", body, 44)
+            loop = (start, end + 1)  # The end is included in WAV files.
+        pos += 8 + size + (size & 1)
+
+    if not fmt or pcm is None or fmt[0] != 1 or fmt[5] != 16:
+        return None
+
+    channels = fmt[1]
+    count = len(pcm) // (2 * channels)
+    values = struct.unpack("<%dh" % (count * channels), pcm[:count * 2 * channels])
+    if channels == 1:
+        return fmt[2], list(values), loop
+
+    samples = [sum(values[i * channels:(i + 1) * channels]) // channels for i in range(count)]
+    return fmt[2], samples, loop
+
+
+def load(path, rate):
+    if rate is None and path.lower().endswith(".wav"):
+        wav = read_wav(path)
+        if wav:
+            return wav
+
+    # Everything else is turned into a mono 16-bit WAV first.
+    fd, temp = tempfile.mkstemp(suffix=".wav")
+    os.close(fd)
+    try:
+        command = ["ffmpeg", "-y", "-v", "error", "-i", path, "-ac", "1", "-acodec", "pcm_s16le"]
+        if rate:
+            command += ["-ar", str(rate)]
+        subprocess.run(command + [temp], check=True)
+        return read_wav(temp)
+    finally:
+        os.remove(temp)
+
+
+def clamp16(value):
+    return -32768 if value < -32768 else 32767 if value > 32767 else value
+
+
+def frame_sums(samples, start, h1, h2):
+    """Autocorrelation of a frame with it's two samples before, R[i][j] = sum of x[n - i] * x[n - j]."""
+    r00 = r01 = r02 = r11 = r12 = r22 = 0
+    for x in samples[start:start + FRAME_SAMPLES]:
+        r00 += x * x
+        r01 += x * h1
+        r02 += x * h2
+        r11 += h1 * h1
+        r12 += h1 * h2
+        r22 += h2 * h2
+        h2 = h1
+        h1 = x
+    return r00, r01, r02, r11, r12, r22
+
+
+def find_coefs(samples):
+    """8 predictor pairs in 4.11 fixed point, from the best predictor of every frame grouped together with k-means."""
+    frames = len(samples) // FRAME_SAMPLES
+    step = max(1, frames // 20000)
+    points = []
+
+    for frame in range(1, frames, step):
+        start = frame * FRAME_SAMPLES
+        r00, r01, r02, r11, r12, r22 = frame_sums(samples, start, samples[start - 1], samples[start - 2])
+        det = r11 * r22 - r12 * r12
+        if r00 == 0 or det == 0:
+            continue
+
+        c1 = (r01 * r22 - r02 * r12) / det
+        c2 = (r02 * r11 - r01 * r12) / det
+        points.append((max(-4.0, min(4.0, c1)), max(-4.0, min(4.0, c2))))
+
+    # Silence and the usual first and second order predictors to start from, the first one never moves.
+    centers = [(0.0, 0.0), (1.0, 0.0), (2.0, -1.0), (1.8, -0.85), (1.5, -0.6), (1.2, -0.3), (0.9, 0.0), (0.5, 0.2)]
+    for _ in range(10):
+        sums = [[0.0, 0.0, 0] for _ in centers]
+        for c1, c2 in points:
+            best = min(range(PREDICTORS), key=lambda i: (centers[i][0] - c1) ** 2 + (centers[i][1] - c2) ** 2)
+            sums[best][0] += c1
+            sums[best][1] += c2
+            sums[best][2] += 1
+        for i in range(1, PREDICTORS):
+            if sums[i][2]:
+                centers[i] = (sums[i][0] / sums[i][2], sums[i][1] / sums[i][2])
+
+    coefs = []
+    for c1, c2 in centers:
+        coefs += [clamp16(round(c1 * 2048)), clamp16(round(c2 * 2048))]
+    return coefs
+
+
+def encode(samples, coefs):
+    """Returns the frames and the seek table, decoding every frame the same way the DSP does as it goes."""
+    pairs = [(coefs[i * 2], coefs[i * 2 + 1]) for i in range(PREDICTORS)]
+    frames = (len(samples) + FRAME_SAMPLES - 1) // FRAME_SAMPLES
+    padded = samples + [0] * (frames * FRAME_SAMPLES - len(samples))
+    out = bytearray()
+    seek = []
+    h1 = h2 = 0
+
+    for frame in range(frames):
+        if frame % SEEK_INTERVAL == 0:
+            seek += [h1, h2]
+        if frame % 2000 == 0:
+            print("\rEncoding: %d%%" % (frame * 100 // frames), end="", flush=True)
+
+        start = frame * FRAME_SAMPLES
+        r00, r01, r02, r11, r12, r22 = frame_sums(padded, start, h1, h2)
+
+        # Squared error of every predictor, without encoding the frame with each of them.
+        def error(pair):
+            c1 = pair[0] / 2048
+            c2 = pair[1] / 2048
+            return r00 - 2 * c1 * r01 - 2 * c2 * r02 + c1 * c1 * r11 + 2 * c1 * c2 * r12 + c2 * c2 * r22
+
+        predictor = min(range(PREDICTORS), key=lambda i: error(pairs[i]))
+        c1, c2 = pairs[predictor]
+
+        # Smallest scale that fits the biggest difference, one more if the decoded samples drift too far.
+        biggest = 0
+        p1, p2 = h1, h2
+        for x in padded[start:start + FRAME_SAMPLES]:
+            biggest = max(biggest, abs(x - ((c1 * p1 + c2 * p2 + 1024) >> 11)))
+            p2 = p1
+            p1 = x
+
+        scale = 0
+        while scale < 12 and biggest > 7 << scale:
+            scale += 1
+
+        while True:
+            nibbles = []
+            d1, d2 = h1, h2
+            clipped = False
+            for x in padded[start:start + FRAME_SAMPLES]:
+                base = c1 * d1 + c2 * d2 + 1024
+                nibble = round(((x << 11) - base) / (2048 << scale))
+                if nibble < -8 or nibble > 7:
+                    clipped = True
+                    nibble = max(-8, min(7, nibble))
+                decoded = clamp16((((nibble << scale) << 11) + base) >> 11)
+                nibbles.append(nibble & 15)
+                d2 = d1
+                d1 = decoded
+            if not clipped or scale == 12:
+                break
+            scale += 1
+
+        out.append(predictor << 4 | scale)
+        for i in range(0, FRAME_SAMPLES, 2):
+            out.append(nibbles[i] << 4 | nibbles[i + 1])
+        h1, h2 = d1, d2
+
+    # dsge reads one entry more than there are full intervals.
+    while len(seek) < ((len(samples) // FRAME_SAMPLES) // SEEK_INTERVAL + 1) * 2:
+        seek += [h1, h2]
+
+    print("\rEncoding: 100%")
+    return out, seek
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Converts a WAV or Ogg file into a DSGE ADPCM file.")
+    parser.add_argument("input")
+    parser.add_argument("output")
+    parser.add_argument("--rate", type=int, help="Sample rate to resample to, 32000 or less saves a lot of space")
+    parser.add_argument("--loop", type=int, nargs=2, metavar=("START", "END"), help="Loop points in samples")
+    args = parser.parse_args()
+
+    wav = load(args.input, args.rate)
+    if not wav:
+        sys.exit("Could not read " + args.input)
+
+    rate, samples, loop = wav
+    if args.loop:
+        loop = tuple(args.loop)
+    if not samples:
+        sys.exit("No samples in " + args.input)
+
+    loop_start = loop_end = 0
+    if loop:
+        loop_start, loop_end = loop
+        if not 0 <= loop_start < loop_end <= len(samples):
+            sys.exit("The loop points have to be within the %d samples of the file." % len(samples))
+
+        # The DSP can only jump back to the start of a frame, a bit of silence in front moves the loop start on one.
+        pad = (FRAME_SAMPLES - loop_start % FRAME_SAMPLES) % FRAME_SAMPLES
+        samples = [0] * pad + samples
+        loop_start += pad
+        loop_end += pad
+
+    coefs = find_coefs(samples)
+    frames, seek = encode(samples, coefs)
+
+    header = struct.pack("<4sBBHIIII16hI", b"DSGA", 1, 1, SEEK_INTERVAL, rate, len(samples), loop_start, loop_end, *coefs, len(seek) // 2)
+    with open(args.output, "wb") as f:
+        f.write(header)
+        f.write(struct.pack("<%dh" % len(seek), *seek))
+        f.write(frames)
+
+    size = len(header) + len(seek) * 2 + len(frames)
+    print("%s: %d Hz, %.2f seconds, %d KB" % (args.output, rate, len(samples) / rate, size // 1024))
+
+
+if __name__ == "__main__":
+    main()
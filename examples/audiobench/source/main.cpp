@@ -0,0 +1,51 @@
+/*
+    DSGE Audio Benchmark
+    Compares how much CPU time a second of audio costs as Ogg Vorbis and as DSP-ADPCM.
+
+    Set it up like examples/template (same Makefile and run.bat, dsge in source/dsge), then put the same song twice in romfs:
+    - romfs/bench.ogg, for example from: ffmpeg -i song.wav -c:a libvorbis -ar 32000 -ac 1 bench.ogg
+    - romfs/bench.adpcm, from: python adpcm.py song.wav bench.adpcm --rate 32000
+*/
+#include "dsge/dsge.hpp"
+
+// Prints the CPU time of every second of audio so far, for both formats.
+void report(const char* name, const dsge::Sound& sound) {
+    soundStats s = sound.getStats();
+    if (s.audioSeconds <= 0) return;
+
+    trace(std::string(name) + ": " + TSA(s.decodeMs / s.audioSeconds) + " ms per second of audio (" + TSA(s.audioSeconds) + "s so far)");
+}
+
+int main() {
+    dsge::init();
+
+    dsge::Sound ogg("bench.ogg");
+    dsge::Sound adpcm("bench.adpcm");
+
+    // Both loop, so they keep going for as long as it runs. Silent since it's the same song twice.
+    ogg.loop = adpcm.loop = true;
+    ogg.volume = adpcm.volume = 0;
+    ogg.preload();
+    adpcm.preload();
+
+    while (dsge::render() && !(ogg.isReady() && adpcm.isReady())) {}
+
+    ogg.play();
+    adpcm.play();
+    trace("Playing both, results every 5 seconds. Press START to exit.");
+
+    u64 last = osGetTime();
+    while (dsge::render()) {
+        if (dsge::Input::isDown(KEY_START)) {
+            break;
+        }
+
+        if (osGetTime() - last >= 5000) {
+            last = osGetTime();
+            report("Ogg Vorbis", ogg);
+            report("ADPCM", adpcm);
+        }
+    }
+
+    return dsge::exit();
+}
@@ -0,0 +1,90 @@
+/*
+    DSGE Collision Benchmark
+    Compares dsge::overlapAll() and dsge::collide() with checking every pair with dsge::overlap(), at 100, 1000 and
+    5000 moving sprites.
+
+    Set it up like examples/template (same Makefile and run.bat, dsge in source/dsge), no romfs needed. The results
+    are also written to sdmc:/collisionbench.log.
+*/
+#include "dsge/dsge.hpp"
+
+const int COUNTS[] = {100, 1000, 5000};
+const int FRAMES = 10; // Checks per count, checking every pair of 5000 sprites takes a while.
+
+float msSince(u64 start) {
+    return (svcGetSystemTick() - start) / CPU_TICKS_PER_MSEC;
+}
+
+int main() {
+    dsge::init();
+    dsge::Log::startFileSink("collisionbench.log");
+    trace("Checking " + TSA(FRAMES) + " frames per count. Press START to exit.");
+
+    for (int count : COUNTS) {
+        // 8x8 sprites spread over the top screen, the first half are "bullets" and the other half "enemies".
+        std::vector<dsge::Sprite> sprites(count);
+        dsge::Group all(count), bullets(count / 2), enemies(count / 2);
+        for (int i = 0; i < count; i++) {
+            sprites[i].x = rand() % 392;
+            sprites[i].y = rand() % 232;
+            sprites[i].makeGraphic(8, 8);
+            all.add(sprites[i]);
+            (i < count / 2 ? bullets : enemies).add(sprites[i]);
+        }
+
+        u64 bruteCandidates = 0, gridCandidates = 0, bruteSplit = 0, gridSplit = 0;
+        u32 brutePairs = 0, gridPairs = 0, bruteHits = 0, gridHits = 0;
+        float bruteMs = 0, gridMs = 0, bruteSplitMs = 0, gridSplitMs = 0;
+
+        for (int frame = 0; frame < FRAMES; frame++) {
+            // Everything moves, so the spatial hash gets built again every frame like in a game.
+            for (auto &&sprite : sprites) {
+                sprite.x = (int)(sprite.x + 3) % 392;
+            }
+            if (!dsge::render() || dsge::Input::isDown(KEY_START)) {
+                return dsge::exit();
+            }
+
+            u64 start = svcGetSystemTick();
+            for (int i = 0; i < count; i++) {
+                for (int j = i + 1; j < count; j++) {
+                    brutePairs += dsge::overlap(&sprites[i], &sprites[j]);
+                }
+            }
+            bruteMs += msSince(start);
+            bruteCandidates += (u64)count * (count - 1) / 2;
+
+            start = svcGetSystemTick();
+            gridPairs += dsge::overlapAll(all);
+            gridMs += msSince(start);
+            gridCandidates += dsge::Group::lastCandidates;
+
+            start = svcGetSystemTick();
+            for (int i = 0; i < count / 2; i++) {
+                for (int j = count / 2; j < count; j++) {
+                    bruteHits += dsge::overlap(&sprites[i], &sprites[j]);
+                }
+            }
+            bruteSplitMs += msSince(start);
+            bruteSplit += (u64)(count / 2) * (count - count / 2);
+
+            start = svcGetSystemTick();
+            gridHits += dsge::collide(bullets, enemies);
+            gridSplitMs += msSince(start);
+            gridSplit += dsge::Group::lastCandidates;
+        }
+
+        trace(TSA(count) + " sprites, overlapAll: " + TSA(gridMs / FRAMES) + " ms, " + TSA(gridCandidates / FRAMES) + " pairs compared, " + TSA(gridPairs / FRAMES) + " overlapping");
+        trace("  every pair: " + TSA(bruteMs / FRAMES) + " ms, " + TSA(bruteCandidates / FRAMES) + " pairs compared, " + TSA(brutePairs / FRAMES) + " overlapping");
+        trace("  collide half with half: " + TSA(gridSplitMs / FRAMES) + " ms, " + TSA(gridSplit / FRAMES) + " pairs compared, " + TSA(gridHits / FRAMES) + " overlapping");
+        trace("  every pair: " + TSA(bruteSplitMs / FRAMES) + " ms, " + TSA(bruteSplit / FRAMES) + " pairs compared, " + TSA(bruteHits / FRAMES) + " overlapping");
+    }
+
+    while (dsge::render()) {
+        if (dsge::Input::isDown(KEY_START)) {
+            break;
+        }
+    }
+
+    return dsge::exit();
+}
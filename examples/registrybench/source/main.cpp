@@ -0,0 +1,85 @@
+/*
+    DSGE Registry Benchmark
+    Adds and destroys 10,000 sprites per second, like bullets in a shooter, and times what it costs.
+
+    Set it up like examples/template (same Makefile and run.bat, dsge in source/dsge), no romfs needed. The results
+    are also written to sdmc:/registrybench.log.
+
+    Before the registry, members sat in a vector that render() walked once per screen, erasing the destroyed ones
+    from the middle of it. The same walk is done on a plain vector next to it and printed as "before".
+*/
+#include "dsge/dsge.hpp"
+#include <optional>
+
+const int PER_SECOND = 10000;
+const int ALIVE = 3000; // Bullets on screen at once, the oldest one gets destroyed for every new one.
+
+int main() {
+    dsge::init();
+    dsge::Log::startFileSink("registrybench.log");
+    trace("Adding and destroying " + TSA(PER_SECOND) + " sprites per second, results every 5 seconds. Press START to exit.");
+
+    std::vector<std::optional<dsge::Sprite>> bullets(ALIVE);
+    size_t next = 0;
+
+    // The old way, serials of every bullet added, the ones that aren't in the last ALIVE are destroyed.
+    std::vector<u64> oldList;
+    u64 spawned = 0;
+
+    u64 addTicks = 0, renderTicks = 0, oldTicks = 0, cycles = 0, frames = 0;
+    u64 last = osGetTime();
+
+    while (true) {
+        u64 start = svcGetSystemTick();
+        bool running = dsge::render(); // Removed members get compacted in here.
+        renderTicks += svcGetSystemTick() - start;
+
+        if (!running || dsge::Input::isDown(KEY_START)) {
+            break;
+        }
+
+        // An even amount every frame, 10k per second at 60 FPS.
+        int count = PER_SECOND / 60;
+
+        start = svcGetSystemTick();
+        for (int i = 0; i < count; i++) {
+            std::optional<dsge::Sprite>& bullet = bullets[next];
+            next = (next + 1) % ALIVE;
+
+            bullet.reset(); // The destructor removes it.
+            bullet.emplace(rand() % 400, rand() % 240);
+            bullet->makeGraphic(2, 2);
+            dsge::add(*bullet);
+        }
+        addTicks += svcGetSystemTick() - start;
+
+        start = svcGetSystemTick();
+        for (int i = 0; i < count; i++) {
+            oldList.push_back(spawned++);
+        }
+        for (int screen = 0; screen < 2; screen++) {
+            for (size_t j = 0; j < oldList.size();) {
+                if (oldList[j] + ALIVE <= spawned) {
+                    oldList.erase(oldList.begin() + j);
+                } else {
+                    j++;
+                }
+            }
+        }
+        oldTicks += svcGetSystemTick() - start;
+
+        cycles += count;
+        frames++;
+
+        if (osGetTime() - last >= 5000) {
+            float seconds = (osGetTime() - last) / 1000.0f;
+            trace(TSA((u32)(cycles / seconds)) + " adds and destroys per second, " + TSA(addTicks / CPU_TICKS_PER_MSEC / frames) + " ms per frame (render " + TSA(renderTicks / CPU_TICKS_PER_MSEC / frames) + " ms), before " + TSA(oldTicks / CPU_TICKS_PER_MSEC / frames) + " ms");
+
+            addTicks = renderTicks = oldTicks = cycles = frames = 0;
+            last = osGetTime();
+        }
+    }
+
+    bullets.clear();
+    return dsge::exit();
+}
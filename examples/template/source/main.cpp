@@ -14,9 +14,8 @@ int main() {
 
     // Current loop, always render first.
     while (dsge::render()) {
-        // Checking if the key START is touched.
-        hidScanInput();
-        if (hidKeysDown() & KEY_START) {
+        // Checking if the key START is pressed, dsge::render() already read the input for this frame.
+        if (dsge::Input::isDown(KEY_START)) {
             break;
         }
     }
@@ -0,0 +1,73 @@
+/*
+    DSGE Text Benchmark
+    Counts the glyph parses (C2D_TextFontParse) done per frame with static, changing and many Texts.
+
+    Set it up like examples/template (same Makefile and run.bat, dsge in source/dsge), no romfs needed. The results
+    are also written to sdmc:/textbench.log.
+
+    Before every Text kept it's own parse, createText() parsed it again from isOnScreen() and again from _render(),
+    so every Text on screen cost 2 parses per frame even if it never changed. That number is printed as "before".
+*/
+#include "dsge/dsge.hpp"
+#include <deque>
+
+const int FRAMES = 300; // Per case, 5 seconds at 60 FPS.
+
+// Runs a case for FRAMES frames, `change` gets called every frame to change what it wants, then prints the average.
+bool run(const char* name, std::deque<dsge::Text>& texts, std::function<void(int frame)> change) {
+    for (auto &&text : texts) {
+        dsge::add(text);
+    }
+
+    u64 parses = 0;
+    u64 start = svcGetSystemTick();
+    for (int frame = 0; frame < FRAMES; frame++) {
+        change(frame);
+        if (!dsge::render() || dsge::Input::isDown(KEY_START)) return false;
+
+        // Counted at the end of render() for the frame that just got drawn.
+        parses += dsge::Text::parsesLastFrame;
+    }
+
+    float frameMs = (svcGetSystemTick() - start) / CPU_TICKS_PER_MSEC / FRAMES;
+    trace(std::string(name) + ": " + TSA((float)parses / FRAMES) + " parses per frame, before " + TSA(texts.size() * 2) + " (" + TSA(frameMs) + " ms per frame)");
+
+    for (auto &&text : texts) {
+        dsge::remove(text);
+    }
+    return true;
+}
+
+int main() {
+    dsge::init();
+    dsge::Log::startFileSink("textbench.log");
+    trace("Running every case for " + TSA(FRAMES) + " frames. Press START to exit.");
+
+    while (true) {
+        // A single HUD line that never changes.
+        std::deque<dsge::Text> hud;
+        hud.emplace_back(10, 10, "Score: 0");
+        if (!run("Static", hud, [](int) {})) break;
+
+        // A single line that changes every frame, like a timer.
+        std::deque<dsge::Text> timer;
+        timer.emplace_back(10, 10, "0");
+        if (!run("Changing", timer, [&](int frame) { timer[0].text = TSA(frame); })) break;
+
+        // A full screen of labels, one in ten changes every frame.
+        std::deque<dsge::Text> labels;
+        for (int i = 0; i < 200; i++) {
+            labels.emplace_back(10 + (i % 8) * 48, 10 + (i / 8) * 9, "Item " + TSA(i));
+            labels.back().scale = {0.4f, 0.4f};
+        }
+
+        bool ok = run("Many", labels, [&](int frame) {
+            for (size_t i = frame % 10; i < labels.size(); i += 10) {
+                labels[i].text = "Item " + TSA(frame);
+            }
+        });
+        if (!ok) break;
+    }
+
+    return dsge::exit();
+}
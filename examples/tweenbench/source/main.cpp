@@ -0,0 +1,91 @@
+/*
+    DSGE Tween Benchmark
+    Runs thousands of tweens at once, each one starting the next from it's completion callback, and measures the time
+    Tween::_update() takes per frame and how many heap allocations happen while they run.
+
+    Set it up like examples/template (same Makefile and run.bat, dsge in source/dsge), no romfs needed. The results
+    are also written to sdmc:/tweenbench.log.
+*/
+#include "dsge/dsge.hpp"
+#include <atomic>
+#include <new>
+
+const int COUNTS[] = {1000, 2000, 4000}; // Sprites, with 2 tweens each.
+const int FRAMES = 600;                  // Updates measured per count, 10 seconds worth at 60 FPS.
+
+// Every heap allocation of the whole program, from any thread.
+std::atomic<u64> allocations{0};
+
+void* operator new(size_t size) {
+    allocations++;
+    void* p = malloc(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+// Goes back the other way once it's done, with a different easing every time.
+void bounce(void* userData) {
+    dsge::Sprite* sprite = (dsge::Sprite*)userData;
+    easeType ease = (easeType)(rand() % EASE_COUNT);
+    dsge::Tween::to(*sprite, TWEEN_X, sprite->x < 200 ? 380 : 20, 0.25f + (rand() % 100) / 100.0f, ease, bounce, sprite);
+}
+
+void fade(void* userData) {
+    dsge::Sprite* sprite = (dsge::Sprite*)userData;
+    dsge::Tween::to(*sprite, TWEEN_ALPHA, sprite->alpha < 0.5f ? 1 : 0, 0.25f + (rand() % 100) / 100.0f, EASE_SINE_IN_OUT, fade, sprite);
+}
+
+int main() {
+    dsge::init();
+    dsge::Log::startFileSink("tweenbench.log");
+    trace("Measuring " + TSA(FRAMES) + " updates per count. Press START to exit.");
+
+    for (int count : COUNTS) {
+        std::vector<dsge::Sprite> sprites(count);
+        for (auto &&sprite : sprites) {
+            sprite.x = rand() % 400;
+            sprite.makeGraphic(4, 4);
+            bounce(&sprite);
+            fade(&sprite);
+        }
+
+        // Warms up the pool, it only grows while tweens get started for the first time.
+        for (int frame = 0; frame < 60; frame++) {
+            dsge::Tween::_update(1000 / 60.0f);
+        }
+
+        u64 before = allocations;
+        u64 start = svcGetSystemTick();
+        for (int frame = 0; frame < FRAMES; frame++) {
+            dsge::Tween::_update(1000 / 60.0f);
+        }
+        float ms = (svcGetSystemTick() - start) / CPU_TICKS_PER_MSEC / FRAMES;
+        u64 allocated = allocations - before;
+
+        trace(TSA(dsge::Tween::activeCount()) + " tweens: " + TSA(ms) + " ms per update, " + TSA(allocated) + " allocations in " + TSA(FRAMES) + " updates");
+
+        for (auto &&sprite : sprites) {
+            dsge::Tween::cancelAll(sprite);
+        }
+
+        if (!dsge::render() || dsge::Input::isDown(KEY_START)) {
+            break;
+        }
+    }
+
+    while (dsge::render()) {
+        if (dsge::Input::isDown(KEY_START)) {
+            break;
+        }
+    }
+
+    return dsge::exit();
+}
@@ -0,0 +1,94 @@
+#include "adpcm.hpp"
+#include <cstring>
+
+namespace {
+    constexpr u8 MAGIC[4] = {'D', 'S', 'G', 'A'};
+    constexpr u8 VERSION = 1;
+    constexpr size_t HEADER_SIZE = 60;
+
+    u16 read16(const u8* p) {
+        return p[0] | (p[1] << 8);
+    }
+
+    u32 read32(const u8* p) {
+        return p[0] | (p[1] << 8) | (p[2] << 16) | ((u32)p[3] << 24);
+    }
+}
+
+namespace dsge {
+namespace _internal {
+bool readAdpcmHeader(FILE* file, AdpcmHeader& out) {
+    u8 h[HEADER_SIZE];
+    if (fread(h, 1, HEADER_SIZE, file) != HEADER_SIZE) return false;
+    if (memcmp(h, MAGIC, sizeof(MAGIC)) != 0 || h[4] != VERSION || h[5] != 1) return false;
+
+    out.seekInterval = read16(h + 6);
+    out.rate = read32(h + 8);
+    out.samples = read32(h + 12);
+    out.loopStart = read32(h + 16);
+    out.loopEnd = read32(h + 20);
+    for (int i = 0; i < 16; i++) out.coefs[i] = read16(h + 24 + i * 2);
+
+    u32 entries = read32(h + 56);
+    if (out.rate == 0 || out.seekInterval == 0 || out.loopEnd > out.samples) return false;
+    if (out.loopEnd != 0 && (out.loopStart >= out.loopEnd || out.loopStart % ADPCM_FRAME_SAMPLES != 0)) return false;
+    if (entries != (out.samples / ADPCM_FRAME_SAMPLES) / out.seekInterval + 1) return false;
+
+    std::vector<u8> table(entries * 4);
+    if (fread(table.data(), 1, table.size(), file) != table.size()) return false;
+
+    out.seekTable.resize(entries * 2);
+    for (u32 i = 0; i < entries * 2; i++) out.seekTable[i] = (s16)read16(table.data() + i * 2);
+
+    out.dataOffset = HEADER_SIZE + entries * 4;
+    return true;
+}
+
+void decodeAdpcmFrame(const u8* frame, const u16* coefs, s16& hist1, s16& hist2, s16* out) {
+    int scale = 1 << (frame[0] & 0xF);
+    int predictor = frame[0] >> 4;
+    s32 coef1 = (s16)coefs[predictor * 2];
+    s32 coef2 = (s16)coefs[predictor * 2 + 1];
+
+    for (u32 i = 0; i < ADPCM_FRAME_SAMPLES; i++) {
+        u8 byte = frame[1 + i / 2];
+        s32 nibble = (i & 1) ? (byte & 0xF) : (byte >> 4);
+        if (nibble >= 8) nibble -= 16;
+
+        // Same as the DSP, 11 bits of fraction with rounding.
+        s32 sample = ((nibble * scale) << 11) + 1024 + coef1 * hist1 + coef2 * hist2;
+        sample >>= 11;
+        if (sample > 32767) sample = 32767;
+        if (sample < -32768) sample = -32768;
+
+        hist2 = hist1;
+        hist1 = (s16)sample;
+        if (out) out[i] = hist1;
+    }
+}
+
+bool adpcmContext(FILE* file, const AdpcmHeader& header, u32 frame, ndspAdpcmData& out) {
+    u32 entry = frame / header.seekInterval;
+    if (entry * 2 >= header.seekTable.size()) return false;
+
+    s16 hist1 = header.seekTable[entry * 2];
+    s16 hist2 = header.seekTable[entry * 2 + 1];
+
+    // At most a seek interval of frames to decode, the DSP takes it from there.
+    u32 first = entry * header.seekInterval;
+    u32 count = frame - first + 1;
+    std::vector<u8> frames(count * ADPCM_FRAME_BYTES);
+
+    if (fseek(file, header.dataOffset + first * ADPCM_FRAME_BYTES, SEEK_SET) != 0) return false;
+    size_t read = fread(frames.data(), 1, frames.size(), file);
+    if (read < (count - 1) * ADPCM_FRAME_BYTES + 1) return false;
+
+    for (u32 i = 0; i + 1 < count; i++) decodeAdpcmFrame(&frames[i * ADPCM_FRAME_BYTES], header.coefs, hist1, hist2, nullptr);
+
+    out.index = frames[(count - 1) * ADPCM_FRAME_BYTES];
+    out.history0 = hist1;
+    out.history1 = hist2;
+    return true;
+}
+}
+} // namespace dsge
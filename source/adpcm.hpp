@@ -0,0 +1,51 @@
+#ifndef DSGE_ADPCM_HPP
+#define DSGE_ADPCM_HPP
+
+#include <3ds.h>
+#include <cstdio>
+#include <vector>
+
+namespace dsge {
+namespace _internal {
+    constexpr u32 ADPCM_FRAME_SAMPLES = 14; // Samples in a frame.
+    constexpr u32 ADPCM_FRAME_BYTES = 8;    // A predictor and scale byte, then 14 4-bit samples.
+
+    /**
+     * A DSGE ADPCM file (.adpcm), made by `adpcm.py` from a WAV or Ogg file.
+     *
+     * It's mono DSP-ADPCM, the format the 3DS's DSP decodes by itself, so playing it costs no CPU besides reading
+     * the file. Every field is little endian:
+     *
+     * - 0: "DSGA", version (1), channels (1), u16 frames per seek table entry
+     * - 8: u32 sample rate, u32 samples, u32 loop start (on a frame), u32 loop end (0 if there's no loop points)
+     * - 24: 16 s16 coefficients, 8 pairs the predictor byte of every frame picks from
+     * - 56: u32 seek table entries, then every entry as two s16, the last two samples before it's frame
+     * - After that the frames.
+     */
+    struct AdpcmHeader {
+        u32 rate;
+        u32 samples;
+        u32 loopStart;
+        u32 loopEnd;
+        u16 coefs[16];
+        u16 seekInterval;
+        std::vector<s16> seekTable; // Two per entry.
+        u32 dataOffset;
+    };
+
+    inline u32 adpcmBytes(u32 samples) {
+        return (samples + ADPCM_FRAME_SAMPLES - 1) / ADPCM_FRAME_SAMPLES * ADPCM_FRAME_BYTES;
+    }
+
+    // Reads the header and the seek table, leaves the file right at the first frame.
+    bool readAdpcmHeader(FILE* file, AdpcmHeader& out);
+
+    // Decodes a frame on the CPU, `hist1` and `hist2` are the last two samples before it and get moved on.
+    void decodeAdpcmFrame(const u8* frame, const u16* coefs, s16& hist1, s16& hist2, s16* out);
+
+    // What the DSP needs to start decoding at `frame`, found from the closest seek table entry before it.
+    bool adpcmContext(FILE* file, const AdpcmHeader& header, u32 frame, ndspAdpcmData& out);
+}
+} // namespace dsge
+
+#endif
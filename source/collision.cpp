@@ -0,0 +1,246 @@
+#include "collision.hpp"
+#include <algorithm>
+
+namespace {
+    // Objects covering more cells than this skip the hash and are checked against everything.
+    constexpr int MAX_CELLS = 16;
+    constexpr float MIN_CELL_SIZE = 8;
+
+    u32 epoch = 1;
+
+    std::vector<dsge::Group*>& groups() {
+        // Never freed so groups and sprites destroyed after main() can still remove themselves.
+        static auto* g = new std::vector<dsge::Group*>();
+        return *g;
+    }
+
+    u32 hashCell(int cx, int cy) {
+        return ((u32)cx * 73856093u) ^ ((u32)cy * 19349663u);
+    }
+
+    bool intersects(const dsge::_internal::Bounds& a, const dsge::_internal::Bounds& b) {
+        return a.left < b.right && a.right > b.left && a.top < b.bottom && a.bottom > b.top;
+    }
+
+    struct CellRange {
+        int x0, y0, x1, y1;
+
+        int count() const { return (x1 - x0 + 1) * (y1 - y0 + 1); }
+    };
+
+    CellRange cellsOf(const dsge::_internal::Bounds& box, float inv) {
+        return {(int)floorf(box.left * inv), (int)floorf(box.top * inv), (int)floorf(box.right * inv), (int)floorf(box.bottom * inv)};
+    }
+
+    // The boxes already overlap, only sprites with a hitbox shape or a rotation need a closer look.
+    bool narrowPhase(dsge::Sprite& a, dsge::Sprite& b) {
+        if (a._isPlainBox() && b._isPlainBox()) return true;
+        if (!dsge::_internal::intersect(a._collider(), b._collider(), nullptr)) return false;
+        if (!a._private.hitbox.pixels && !b._private.hitbox.pixels) return true;
+        return dsge::_internal::overlapMasks(a, b);
+    }
+
+    // Calls `visit` once for every object of the group from index `first` on whose hit box overlaps `box`.
+    template<typename F>
+    void query(dsge::Group& g, const dsge::_internal::Bounds& box, u32 first, F visit) {
+        auto& p = g._private;
+        if (p.objects.size() <= first) return;
+
+        u32 q = ++p.query;
+        auto test = [&](u32 j) {
+            if (j < first || p.stamp[j] == q) return;
+            p.stamp[j] = q;
+            dsge::Group::lastCandidates++;
+            if (p.objects[j] && intersects(box, p.boxes[j])) visit(j);
+        };
+
+        CellRange r = cellsOf(box, p.invCellSize);
+        if (r.count() > MAX_CELLS) {
+            for (u32 j = first; j < p.objects.size(); j++) test(j);
+            return;
+        }
+
+        for (int cy = r.y0; cy <= r.y1; cy++) {
+            for (int cx = r.x0; cx <= r.x1; cx++) {
+                u32 bucket = hashCell(cx, cy) & p.mask;
+                for (u32 k = p.cellStart[bucket]; k < p.cellStart[bucket + 1]; k++) test(p.cellItems[k]);
+            }
+        }
+
+        for (u32 j : p.large) test(j);
+    }
+}
+
+namespace dsge {
+u32 Group::lastCandidates = 0;
+
+Group::Group(size_t reserve) {
+    _private.members.reserve(reserve);
+    _private.query = 0;
+    _private.mask = 0;
+    _private.invCellSize = 1 / MIN_CELL_SIZE;
+    _private.epoch = 0;
+    _private.dirty = true;
+    groups().push_back(this);
+}
+
+Group::~Group() {
+    clear();
+    auto& all = groups();
+    all.erase(std::remove(all.begin(), all.end(), this), all.end());
+}
+
+void Group::add(Sprite& spr) {
+    auto& m = _private.members;
+    if (std::find(m.begin(), m.end(), &spr) != m.end()) return;
+
+    m.push_back(&spr);
+    spr._private.groups++;
+    _private.dirty = true;
+}
+
+bool Group::remove(Sprite& spr) {
+    auto& m = _private.members;
+    auto it = std::find(m.begin(), m.end(), &spr);
+    if (it == m.end()) return false;
+
+    *it = m.back();
+    m.pop_back();
+    spr._private.groups--;
+    _private.dirty = true;
+
+    // It may be removed from inside of a collide callback, the pair loop skips it from now on.
+    std::replace(_private.objects.begin(), _private.objects.end(), &spr, (Sprite*)nullptr);
+    return true;
+}
+
+void Group::clear() {
+    for (auto &&spr : _private.members) spr->_private.groups--;
+    _private.members.clear();
+    std::fill(_private.objects.begin(), _private.objects.end(), nullptr);
+    _private.dirty = true;
+}
+
+void Group::_build() {
+    auto& p = _private;
+    if (!p.dirty && p.epoch == epoch) return;
+
+    DSGE_PROFILE_ZONE("Group::_build");
+
+    p.objects.clear();
+    p.boxes.clear();
+    p.large.clear();
+
+    float total = 0;
+    for (auto &&spr : p.members) {
+        if (spr->_private.destroyed || !spr->visible) continue;
+
+        _internal::Bounds box = spr->_hitBox();
+        p.objects.push_back(spr);
+        p.boxes.push_back(box);
+        total += std::max(box.right - box.left, box.bottom - box.top);
+    }
+
+    size_t count = p.objects.size();
+    p.stamp.assign(count, 0);
+    p.query = 0;
+    p.epoch = epoch;
+    p.dirty = false;
+
+    // Cells twice the average size, so most objects only cover one to four cells.
+    float cellSize = count != 0 ? std::max(MIN_CELL_SIZE, 2 * total / count) : MIN_CELL_SIZE;
+    p.invCellSize = 1 / cellSize;
+
+    u32 buckets = 1;
+    while (buckets < count * 2) buckets <<= 1;
+    p.mask = buckets - 1;
+
+    // Counting sort of every (cell, object) pair into it's bucket.
+    p.cellStart.assign(buckets + 1, 0);
+    for (u32 i = 0; i < count; i++) {
+        CellRange r = cellsOf(p.boxes[i], p.invCellSize);
+        if (r.count() > MAX_CELLS) {
+            p.large.push_back(i);
+            continue;
+        }
+
+        for (int cy = r.y0; cy <= r.y1; cy++) {
+            for (int cx = r.x0; cx <= r.x1; cx++) p.cellStart[hashCell(cx, cy) & p.mask]++;
+        }
+    }
+
+    // End of every bucket first, filling it backwards leaves `cellStart` at the start of it.
+    for (u32 b = 1; b <= buckets; b++) p.cellStart[b] += p.cellStart[b - 1];
+    p.cellItems.resize(p.cellStart[buckets]);
+
+    for (u32 i = 0; i < count; i++) {
+        CellRange r = cellsOf(p.boxes[i], p.invCellSize);
+        if (r.count() > MAX_CELLS) continue;
+
+        for (int cy = r.y0; cy <= r.y1; cy++) {
+            for (int cx = r.x0; cx <= r.x1; cx++) p.cellItems[--p.cellStart[hashCell(cx, cy) & p.mask]] = i;
+        }
+    }
+}
+
+void Group::_nextFrame() {
+    if (++epoch == 0) epoch = 1;
+}
+
+void Group::_removeEverywhere(Sprite* spr) {
+    auto& all = groups();
+    for (size_t i = 0; i < all.size() && spr->_private.groups != 0; i++) {
+        all[i]->remove(*spr);
+    }
+}
+
+u32 collide(Group& a, Group& b, collideCallback callback) {
+    if (&a == &b) return overlapAll(a, callback);
+
+    DSGE_PROFILE_ZONE("dsge::collide");
+
+    Group::lastCandidates = 0;
+    a._build();
+    b._build();
+
+    u32 pairs = 0;
+    auto& objects = a._private.objects;
+    for (size_t i = 0; i < objects.size(); i++) {
+        if (!objects[i]) continue;
+
+        query(b, a._private.boxes[i], 0, [&](u32 j) {
+            if (!objects[i]) return; // Removed by an earlier callback.
+            if (!narrowPhase(*objects[i], *b._private.objects[j])) return;
+
+            pairs++;
+            if (callback) callback(*objects[i], *b._private.objects[j]);
+        });
+    }
+
+    return pairs;
+}
+
+u32 overlapAll(Group& group, collideCallback callback) {
+    DSGE_PROFILE_ZONE("dsge::overlapAll");
+
+    Group::lastCandidates = 0;
+    group._build();
+
+    u32 pairs = 0;
+    auto& objects = group._private.objects;
+    for (size_t i = 0; i < objects.size(); i++) {
+        if (!objects[i]) continue;
+
+        // Only the ones after it, so every pair is checked once and never with itself.
+        query(group, group._private.boxes[i], i + 1, [&](u32 j) {
+            if (!objects[i] || !objects[j]) return;
+            if (!narrowPhase(*objects[i], *objects[j])) return;
+
+            pairs++;
+            if (callback) callback(*objects[i], *objects[j]);
+        });
+    }
+
+    return pairs;
+}
+} // namespace dsge
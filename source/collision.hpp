@@ -0,0 +1,138 @@
+#ifndef DSGE_COLLISION_HPP
+#define DSGE_COLLISION_HPP
+
+#include "dsge.hpp"
+
+namespace dsge {
+/**
+ * @brief A list of sprites that are checked for collisions together, like every bullet or every enemy.
+ *
+ * The hit boxes of the sprites are put in a spatial hash the first time the group is checked in a frame
+ * (or fixed step), so a check only compares sprites that are close to each other instead of every pair.
+ *
+ * Sprites leave every group they're in once they're destroyed.
+ *
+ * #### Example Usage:
+ * ```
+ * dsge::Group bullets;
+ * dsge::Group enemies;
+ *
+ * bullets.add(bullet);
+ * enemies.add(enemy);
+ *
+ * dsge::collide(bullets, enemies, [](dsge::Sprite& bullet, dsge::Sprite& enemy) {
+ *     enemy.destroy();
+ * });
+ * ```
+ */
+class Group {
+public:
+    struct {
+        std::vector<Sprite*> members;
+
+        // Spatial hash, rebuilt once per frame from the hit boxes of the visible members.
+        std::vector<Sprite*> objects;          // Visible members, nulled if removed while being checked.
+        std::vector<_internal::Bounds> boxes;  // Hit box of every object.
+        std::vector<u32> cellStart;            // First entry of every bucket in `cellItems`, plus the end.
+        std::vector<u32> cellItems;            // Object indices, grouped by bucket.
+        std::vector<u32> large;                // Objects covering too many cells, checked with everything.
+        std::vector<u32> stamp;                // Last query that reached every object, so pairs are reported once.
+        u32 query;
+        u32 mask;                              // Bucket count - 1.
+        float invCellSize;
+        u32 epoch;                             // Frame the hash got built on.
+        bool dirty;
+    } _private;
+
+    /**
+     * @brief Constructor: Creates an empty group.
+     * @param reserve Amount of sprites to allocate room for.
+     */
+    Group(size_t reserve = 0);
+    ~Group();
+
+    // Sprites point back to the groups they're in, so it can't be copied.
+    Group(const Group&) = delete;
+    Group& operator=(const Group&) = delete;
+
+    /**
+     * @brief Adds a sprite to the group, adding it twice does nothing.
+     */
+    void add(Sprite& spr);
+
+    /**
+     * @brief Removes a sprite from the group.
+     * @return `true` if the sprite was in the group.
+     */
+    bool remove(Sprite& spr);
+
+    /**
+     * @brief Removes every sprite from the group.
+     */
+    void clear();
+
+    /**
+     * @brief Amount of sprites in the group, including invisible ones.
+     */
+    size_t size() const { return _private.members.size(); }
+
+    /**
+     * @brief Rebuilds the spatial hash on the next check.
+     *
+     * Only needed if members moved since the group has been checked in the same frame.
+     */
+    void refresh() { _private.dirty = true; }
+
+    /**
+     * @brief Pairs of hit boxes the spatial hash compared in the last `collide()` or `overlapAll()`.
+     *
+     * Checking every pair instead would be `a.size() * b.size()`, or `size() * (size() - 1) / 2` for `overlapAll()`.
+     *
+     * #### Example Usage:
+     * ```
+     * dsge::overlapAll(asteroids);
+     * trace(TSA(dsge::Group::lastCandidates) + " pairs compared");
+     * ```
+     */
+    static u32 lastCandidates;
+
+    void _build();
+    static void _nextFrame();
+    static void _removeEverywhere(Sprite* spr);
+};
+
+typedef std::function<void(Sprite&, Sprite&)> collideCallback;
+
+/**
+ * @brief Checks every sprite of a group against every sprite of another one.
+ * @param a The first group, it's sprites are the first argument of `callback`.
+ * @param b The second group.
+ * @param callback Called once for every pair that overlaps. Optional.
+ * @return The amount of overlapping pairs.
+ *
+ * Overlapping is the same as `dsge::overlap()`, invisible sprites never collide.
+ *
+ * #### Example Usage:
+ * ```
+ * int hits = dsge::collide(bullets, enemies);
+ * ```
+ */
+u32 collide(Group& a, Group& b, collideCallback callback = nullptr);
+
+/**
+ * @brief Checks every sprite of a group against each other.
+ * @param group The group to check.
+ * @param callback Called once for every pair that overlaps. Optional.
+ * @return The amount of overlapping pairs.
+ *
+ * #### Example Usage:
+ * ```
+ * dsge::overlapAll(asteroids, [](dsge::Sprite& a, dsge::Sprite& b) {
+ *     std::swap(a.acceleration, b.acceleration); // Bounce
+ * });
+ * ```
+ */
+u32 overlapAll(Group& group, collideCallback callback = nullptr);
+} // namespace dsge
+
+#endif
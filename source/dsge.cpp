@@ -3,18 +3,16 @@
 #include <thread>
 #include <typeinfo>
 
-#define col(a) 255 | (255 << (u32)8) | (255 << (u32)16) | (a << (u32)24)
-
 namespace dsge {
 color dsgeColor;
 u64 elapsed;
+float deltaTime;
 u32 bgColor;
 int FPS;
+drawStats renderStats;
 
 namespace _internal {
     // Implementation details
-    std::vector<Text> _debugText = {};
-    std::vector<u8> _debugCol = {};
     std::vector<u64> fpsCtr = {};
     C3D_RenderTarget* top = nullptr;
     C3D_RenderTarget* bot = nullptr;
@@ -23,99 +21,155 @@ namespace _internal {
     dsge::Text fpsText(-4, 4, "");
     #endif
 
-    void _logger(const std::string& message) {
-        std::cout << message << std::endl;
+    void _submitMember(Sprite& spr) {
+        primitiveType type = spr._private.image.tex != NULL ? PRIM_IMAGE : PRIM_RECT;
+        renderQueue().push(spr.bottom, spr.layer, spr.z, type, spr._private.image.tex, &spr);
+    }
 
-        Text d(2, 2 + (11 * _debugText.size()), message);
-        d.scale.set(0.4, 0.4);
-        d._private.debug = true; // Set debug mode for this 
-        _debugText.insert(_debugText.begin(), d);
-        _debugCol.insert(_debugCol.begin(), 255);
+    void _submitMember(Text& txt) {
+        renderQueue().push(txt.bottom, txt.layer, txt.z, PRIM_TEXT, txt.font, &txt);
     }
 
-    void _renderDebugText() {
-        int _index = 0;
-        for (auto &&texts : _debugText) {
-            texts.y = 2 + (11 * _index);
-            texts.color = col(_debugCol[_index]);
-            if (texts.width > 398) {
-                texts.scale.x -= 0.01;
-            }
-            texts._render();
-            _debugCol[_index]--;
-
-            if (_debugCol[_index] == 0) {
-                _debugText.erase(_debugText.begin() + _index);
-                _debugCol.erase(_debugCol.begin() + _index);
-                // Don't increase _index, continue with next item at this index
-                continue;
-            }
+    void _submitMember(EntityStore& store) {
+        renderQueue().push(store.bottom, store.layer, store.z, PRIM_ENTITIES, store._private.image.tex, &store);
+    }
 
-            if (_index == 22) {
-                break;
-            }
-            _index++;
+    template<typename T>
+    void _collectMember(Member& member) {
+        T& conc = *static_cast<T*>(member.object);
+
+        if (conc._private.destroyed) {
+            members().remove(member.handle); // Compacted at the end of the frame.
+            return;
         }
 
-        // Remove any extra entries beyond 22 for lag prevention
-        if (_debugText.size() > 22) {
-            _debugText.resize(22);
-            _debugCol.resize(22);
+        if (conc._prepare()) {
+            _submitMember(conc);
         }
     }
 
-    std::vector<std::reference_wrapper<Sprite>> spriteMembers = {};
-    std::vector<std::reference_wrapper<Text>> textMembers = {};
-    void _proceedRender(bool top) {
-        for (size_t i = 0; i < spriteMembers.size();) {
-            Sprite& conc = spriteMembers[i].get(); // Use reference here
+    // Moves every member by it's acceleration, visible or not, before anything gets collected for drawing.
+    void _integrateMembers(float steps) {
+        DSGE_PROFILE_ZONE("dsge::_integrateMembers");
 
-            if (conc._private.destroyed) {
-                spriteMembers.erase(spriteMembers.begin() + i);
-                continue;
-            }
+        for (auto &&member : members().list()) {
+            if (member.removed) continue;
 
-            if (conc.bottom != top) {
-                conc._render();
+            switch (member.type) {
+                case MEMBER_SPRITE:   static_cast<Sprite*>(member.object)->_integrate(steps);      break;
+                case MEMBER_TEXT:     static_cast<Text*>(member.object)->_integrate(steps);        break;
+                case MEMBER_ENTITIES: static_cast<EntityStore*>(member.object)->_integrate(steps); break;
             }
-            i++;
         }
+    }
+
+    // Saves the state every member is blended from, right before a fixed step.
+    void _snapshotMembers() {
+        DSGE_PROFILE_ZONE("dsge::_snapshotMembers");
 
-        for (size_t i = 0; i < textMembers.size();) {
-            Text& conc = textMembers[i].get(); // Use reference here
+        for (auto &&member : members().list()) {
+            if (member.removed) continue;
 
-            if (conc._private.destroyed) {
-                textMembers.erase(textMembers.begin() + i); // Also fixed: was erasing from spriteMembers
-                continue;
+            switch (member.type) {
+                case MEMBER_SPRITE:   static_cast<Sprite*>(member.object)->_snapshot();      break;
+                case MEMBER_TEXT:     static_cast<Text*>(member.object)->_snapshot();        break;
+                case MEMBER_ENTITIES: static_cast<EntityStore*>(member.object)->_snapshot(); break;
             }
+        }
+    }
 
-            if (conc.bottom != top) {
-                conc._render();
+    // Runs the fixed steps owed for this frame, or just moves members once if there's no fixed update.
+    void _simulate() {
+        if (!Loop::isFixed()) {
+            _integrateMembers(1);
+            return;
+        }
+
+        int steps = Loop::_steps();
+        for (int i = 0; i < steps && Loop::isFixed(); i++) {
+            Loop::_nextTick();
+            Group::_nextFrame();
+            _snapshotMembers();
+            Loop::_update();
+            _integrateMembers(1);
+        }
+    }
+
+    void _collectMembers() {
+        DSGE_PROFILE_ZONE("dsge::_collectMembers");
+
+        for (auto &&member : members().list()) {
+            if (member.removed) continue;
+
+            switch (member.type) {
+                case MEMBER_SPRITE: _collectMember<Sprite>(member); break;
+                case MEMBER_TEXT:   _collectMember<Text>(member);   break;
+                case MEMBER_ENTITIES: {
+                    EntityStore& store = *static_cast<EntityStore*>(member.object);
+                    if (store._prepare()) _submitMember(store);
+                    break;
+                }
             }
-            i++;
         }
+
+        renderQueue().sort();
+    }
+}
+
+MemberHandle add(Sprite& spr) {
+    if (!_internal::members().isValid(spr._private.handle)) {
+        spr._private.handle = _internal::members().add(_internal::MEMBER_SPRITE, &spr);
     }
+    return spr._private.handle;
 }
 
-void add(Sprite& spr) {
-    _internal::spriteMembers.push_back(spr);
+MemberHandle add(Text& txt) {
+    if (!_internal::members().isValid(txt._private.handle)) {
+        txt._private.handle = _internal::members().add(_internal::MEMBER_TEXT, &txt);
+    }
+    return txt._private.handle;
 }
 
-void add(Text& txt) {
-    _internal::textMembers.push_back(txt);
+MemberHandle add(EntityStore& store) {
+    if (!_internal::members().isValid(store._private.handle)) {
+        store._private.handle = _internal::members().add(_internal::MEMBER_ENTITIES, &store);
+    }
+    return store._private.handle;
 }
 
-void init() {
+bool remove(MemberHandle handle) {
+    return _internal::members().remove(handle);
+}
+
+bool remove(Sprite& spr) {
+    return _internal::members().remove(spr._private.handle);
+}
+
+bool remove(Text& txt) {
+    return _internal::members().remove(txt._private.handle);
+}
+
+bool remove(EntityStore& store) {
+    return _internal::members().remove(store._private.handle);
+}
+
+bool isValid(MemberHandle handle) {
+    return _internal::members().isValid(handle);
+}
+
+void init(u32 maxObjects) {
     gfxInitDefault();
     cfguInit();
     newsInit();
     romfsInit();
     ndspInit();
-    C2D_Init(C2D_DEFAULT_MAX_OBJECTS);
+    Sound::_init();
+    C2D_Init(maxObjects);
     C3D_Init(C3D_DEFAULT_CMDBUF_SIZE);
     C2D_Prepare();
 
     osSetSpeedupEnable(true);
+    DSGE_PROFILE_THREAD("Main");
 
     #if defined(DEBUG)
     _internal::fpsText.scale.set(0.5, 0.5);
@@ -143,73 +197,118 @@ void init() {
     dsgeColor.yellow      = 0xff00ffff;
 
     elapsed = 0;
+    deltaTime = 0;
     bgColor = 0xFF000000;
     
     srand(time(NULL));
 }
 
 bool render() {
+    Profiler::_mark(PHASE_UPDATE);
     u64 start = osGetTime();
 
     while (_internal::fpsCtr.size() != 0 && _internal::fpsCtr[0] < start) {
         _internal::fpsCtr.erase(_internal::fpsCtr.begin());
     }
 
-    C3D_FrameBegin(C3D_FRAME_SYNCDRAW);
-    C2D_TargetClear(_internal::top, 0xFF000000);
-    C2D_SceneBegin(_internal::top);
-    C2D_DrawRectSolid(0, 0, 0, 400, 240, bgColor);
-
-    _internal::_proceedRender(true);
-    
-    #if defined(DEBUG)
-    _internal::fpsText.text = "FPS: " + std::to_string(FPS);
-    _internal::fpsText._render();
-
-    _internal::_renderDebugText();
-    #endif
-
-    C2D_TargetClear(_internal::bot, 0xFF000000);
-    C2D_SceneBegin(_internal::bot);
-    C2D_DrawRectSolid(0, 0, 0, 400, 240, bgColor);
+    renderStats = {0, 0};
+    deltaTime = Loop::_beginFrame();
+    Input::_scan();
+    Touch::_dispatch();
+    Group::_nextFrame();
+    Timer::_update();
+    Sound::_update();
+    Tween::_update(deltaTime * 1000);
+    _internal::_simulate();
+
+    // Everything from here on is drawn between the last two fixed steps.
+    _internal::interpolating = Loop::isFixed();
+    _internal::_collectMembers();
+    Profiler::_mark(PHASE_UPDATE); // The fixed steps run the game's update, it's part of it.
+
+    // Fast forwarding a replay only places the members (collecting them does), nothing waits for the GPU or the screen.
+    if (!Replay::isFastForward()) {
+        C3D_FrameBegin(C3D_FRAME_SYNCDRAW);
+        C2D_TargetClear(_internal::top, 0xFF000000);
+        C2D_SceneBegin(_internal::top);
+        C2D_DrawRectSolid(0, 0, 0, 400, 240, bgColor);
+
+        _internal::renderQueue().flush(false);
+        Profiler::_mark(PHASE_TOP);
+        
+        #if defined(DEBUG)
+        _internal::fpsText.text = "FPS: " + std::to_string(FPS);
+        _internal::fpsText._render();
+
+        Log::_renderOverlay();
+        Profiler::_renderOverlay();
+        #endif
+        Profiler::_mark(PHASE_DEBUG);
+
+        C2D_TargetClear(_internal::bot, 0xFF000000);
+        C2D_SceneBegin(_internal::bot);
+        C2D_DrawRectSolid(0, 0, 0, 400, 240, bgColor);
+
+        _internal::renderQueue().flush(true);
+        Profiler::_mark(PHASE_BOTTOM);
+        
+        C3D_FrameEnd(0);
+        Profiler::_mark(PHASE_FRAME_END);
+    }
 
-    _internal::_proceedRender(false);
-    
-    C3D_FrameEnd(0);
+    _internal::interpolating = false;
+    _internal::renderQueue().clear();
 
     _internal::fpsCtr.push_back(osGetTime() + 1000);
     FPS = _internal::fpsCtr.size() < 60 ? _internal::fpsCtr.size() : 60;
 
     elapsed = osGetTime() - start;
+    Text::_endFrame();
+    _internal::members().compact();
+    Profiler::_endFrame();
 
     return aptMainLoop();
 }
 
-bool overlap(dsge::Sprite* obj1, dsge::Sprite* obj2) {
+bool overlap(dsge::Sprite* obj1, dsge::Sprite* obj2, Penetration* out) {
     if (!obj1->visible || !obj2->visible) {
         return false;
     }
 
-    float width1 = obj1->width * fabsf(obj1->scale.x);
-    float height1 = obj1->height * fabsf(obj1->scale.y);
-    float width2 = obj2->width * fabsf(obj2->scale.x);
-    float height2 = obj2->height * fabsf(obj2->scale.y);
+    // Plain unrotated boxes, no need to go through the shapes.
+    if (!out && obj1->_isPlainBox() && obj2->_isPlainBox()) {
+        _internal::Bounds a = obj1->_hitBox();
+        _internal::Bounds b = obj2->_hitBox();
+        return a.left < b.right && a.right > b.left && a.top < b.bottom && a.bottom > b.top;
+    }
+
+    if (!_internal::intersect(obj1->_collider(), obj2->_collider(), out)) return false;
+    if (!obj1->_private.hitbox.pixels && !obj2->_private.hitbox.pixels) return true;
+    return _internal::overlapMasks(*obj1, *obj2);
+}
 
-    float left1 = obj1->flipX ? obj1->x - width1 : obj1->x;
-    float top1 = obj1->flipY ? obj1->y - height1 : obj1->y;
-    float right1 = left1 + width1;
-    float bottom1 = top1 + height1;
+bool overlap(dsge::Sprite* obj1, dsge::Text* obj2, Penetration* out) {
+    if (!obj1->visible || !obj2->visible) return false;
+    return _internal::intersect(obj1->_collider(), obj2->_collider(), out);
+}
+
+bool overlap(dsge::Text* obj1, dsge::Sprite* obj2, Penetration* out) {
+    if (!obj1->visible || !obj2->visible) return false;
+    return _internal::intersect(obj1->_collider(), obj2->_collider(), out);
+}
 
-    float left2 = obj2->flipX ? obj2->x - width2 : obj2->x;
-    float top2 = obj2->flipY ? obj2->y - height2 : obj2->y;
-    float right2 = left2 + width2;
-    float bottom2 = top2 + height2;
-    return left1 < right2 && right1 > left2 && top1 < bottom2 && bottom1 > top2;
+bool overlap(dsge::Text* obj1, dsge::Text* obj2, Penetration* out) {
+    if (!obj1->visible || !obj2->visible) return false;
+    return _internal::intersect(obj1->_collider(), obj2->_collider(), out);
 }
 
 int exit() {
     // Free DS game engine resources FIRST!
+    dsge::Replay::stop();
+    dsge::Log::stopFileSink();
     dsge::Text::exit();
+    dsge::TextureCache::_clear();
+    dsge::Sound::exit();
 
     // Now shut down libraries (reverse order of init)
     C3D_Fini();
@@ -30,12 +30,17 @@ typedef enum {
 namespace dsge {
     // Namespaces
     namespace Applet {}
+    namespace Input {}
+    namespace Loop {}
     namespace Math {}
     namespace Random {}
+    namespace Replay {}
     namespace Utils {}
     namespace Timer {}
     
     // Classes
+    class EntityStore;
+    class Group;
     class Sound;
     class Sprite;
     class Text;
@@ -44,17 +49,31 @@ namespace dsge {
 }
 
 // Basic utility headers first
+#include "registry.hpp"
+#include "render.hpp"
+#include "transform.hpp"
+#include "shape.hpp"
+#include "mask.hpp"
+#include "loop.hpp"
 #include "math.hpp"
 #include "random.hpp"
 #include "utils.hpp"
 
 // Then other headers
 #include "applet.hpp"
+#include "collision.hpp"
+#include "entity.hpp"
+#include "input.hpp"
+#include "log.hpp"
+#include "profiler.hpp"
+#include "replay.hpp"
 #include "sound.hpp"
 #include "sprite.hpp"
 #include "text.hpp"
+#include "texture.hpp"
 #include "timer.hpp"
 #include "touch.hpp"
+#include "tween.hpp"
 
 // Color structure
 struct color {
@@ -84,12 +103,6 @@ std::string TSA(const T& value) {
 }
 
 namespace dsge {
-// Forward declarations
-namespace _internal {
-    void _logger(const std::string& message);
-    void _renderDebugText();
-}
-
 /**
  * @brief The external color for dsge.
  * 
@@ -123,6 +136,20 @@ extern color dsgeColor;
  */
 extern u64 elapsed;
 
+/**
+ * @brief Seconds that passed between the last two `dsge::render()` calls, precise to well under a millisecond.
+ * 
+ * Read from the system tick counter, unlike `dsge::elapsed` it also counts the time spent in your own code.
+ * 
+ * #### Example Usage:
+ * ```
+ * while (dsge::render()) {
+ *     player.x += 120 * dsge::deltaTime; // 120 pixels per second, at any FPS.
+ * }
+ * ```
+ */
+extern float deltaTime;
+
 /**
  * @brief Current background hex color when using the dsge::Render function.
  * 
@@ -154,11 +181,28 @@ extern u32 bgColor;
  */
 extern int FPS;
 
+/**
+ * @brief Draw counters of the last `dsge::render()`.
+ * 
+ * `items` is the amount of sprites and texts that got drawn, `batches` is the amount of runs of the same graphic or font drawn one after another, which is roughly the amount of GPU draw calls.
+ * 
+ * #### Example Usage:
+ * ```
+ * while (dsge::render()) {
+ *     trace(TSA(dsge::renderStats.items) + " items in " + TSA(dsge::renderStats.batches) + " batches");
+ * }
+ * ```
+ */
+extern drawStats renderStats;
+
 /**
  * @brief Initializes dsge and bring back the lives of your own 3DS Games.
+ * @param maxObjects Amount of sprites, texts and entities citro2d can draw in a frame, 4096 by default. Anything past it doesn't get drawn.
  * 
  * Note that if you try to initialize the same function again, there's likely bad things that is gonna happen so don't trigger twice!
  * 
+ * Every object costs about 190 bytes of linear memory for the whole game, which textures and sounds also need, so only raise it if you draw more than that (big `EntityStore`s).
+ * 
  * #### Example Usage:
  * ```
  * #include "dsge/dsge.hpp"
@@ -170,7 +214,7 @@ extern int FPS;
  * }
  * ```
  */
-void init();
+void init(u32 maxObjects = C2D_DEFAULT_MAX_OBJECTS);
 
 /**
  * @brief Exits all of the needed libraries that DSGE needs
@@ -193,10 +237,15 @@ void init();
 int exit();
 
 /**
- * @brief Checks if both Sprite objects are colliding.
- * @param obj1 The 1st Sprite object to check
- * @param obj2 The 2nd Sprite object to check.
- * @return `true` if both collided, `false` otherwise, or `false` if one of the sprites is invisible.
+ * @brief Checks if two sprites or texts are colliding.
+ * @param obj1 The 1st Sprite or Text object to check
+ * @param obj2 The 2nd Sprite or Text object to check.
+ * @param out Where to write how far `obj1` has to move to stop colliding. Optional.
+ * @return `true` if both collided, `false` otherwise, or `false` if one of the objects is invisible.
+ * 
+ * Objects with a hitbox from `setHitbox()` are checked with their shape, the others with their own box. Both are placed just like the object is drawn, rotated, flipped or attached.
+ * 
+ * If one of two sprites has a `dsge::Shape::pixels()` hitbox, it's solid pixels are compared with the other one's solid pixels, or with the inside of it's shape. `out` is still only from their boxes.
  * 
  * #### Example Usage:
  * ```
@@ -207,13 +256,29 @@ int exit();
  * test2.makeGraphic();
  * 
  * dsge::overlap(test1, test2); // will return true since it's both overlapping.
+ * 
+ * dsge::Penetration push;
+ * if (dsge::overlap(&player, &wall, &push)) {
+ *     player.x += push.x; // Slides along the wall.
+ *     player.y += push.y;
+ * }
  * ```
+ * 
+ * To check a lot of sprites against each other, put them in a `dsge::Group` and use `dsge::collide()` instead.
  */
-bool overlap(Sprite* obj1, Sprite* obj2);
+bool overlap(Sprite* obj1, Sprite* obj2, Penetration* out = nullptr);
+bool overlap(Sprite* obj1, Text* obj2, Penetration* out = nullptr);
+bool overlap(Text* obj1, Sprite* obj2, Penetration* out = nullptr);
+bool overlap(Text* obj1, Text* obj2, Penetration* out = nullptr);
 
 /**
- * @brief Adds a sprite or text to members for dsge::Update;
- * @param basic The sprite or text to add as.
+ * @brief Adds a sprite, text or entity store to members for dsge::Update;
+ * @param basic The sprite, text or entity store to add as.
+ * @return A handle to the member, adding the same object twice returns the same handle.
+ * 
+ * #### Note:
+ * 
+ * The member is removed automatically once it's destroyed or goes out of scope.
  * 
  * #### Example Usage:
  * ```
@@ -222,11 +287,47 @@ bool overlap(Sprite* obj1, Sprite* obj2);
  * dsge::add(newSprite);
  * 
  * dsge::Text newText(120, 120, "Hello");
- * dsge::add(newText);
+ * dsge::MemberHandle handle = dsge::add(newText);
+ * ```
+ */
+MemberHandle add(Sprite& spr);
+MemberHandle add(Text& txt);
+MemberHandle add(EntityStore& store);
+
+/**
+ * @brief Removes a sprite or text from members, it will stop being rendered but isn't destroyed.
+ * @param handle The handle returned by `dsge::add()`.
+ * @return `true` if removed, `false` if the handle is stale or the object isn't added.
+ * 
+ * #### Example Usage:
+ * ```
+ * dsge::Sprite newSprite(120, 120);
+ * dsge::MemberHandle handle = dsge::add(newSprite);
+ * 
+ * dsge::remove(handle); // Or dsge::remove(newSprite);
+ * ```
+ */
+bool remove(MemberHandle handle);
+bool remove(Sprite& spr);
+bool remove(Text& txt);
+bool remove(EntityStore& store);
+
+/**
+ * @brief Checks if a handle still points to an added member.
+ * @param handle The handle returned by `dsge::add()`.
+ * @return `true` if the member is still added, `false` if it has been removed or destroyed.
+ * 
+ * #### Example Usage:
+ * ```
+ * dsge::Sprite newSprite(120, 120);
+ * dsge::MemberHandle handle = dsge::add(newSprite);
+ * newSprite.destroy();
+ * 
+ * dsge::render();
+ * dsge::isValid(handle); // Returns false.
  * ```
  */
-void add(Sprite& spr);
-void add(Text& txt);
+bool isValid(MemberHandle handle);
 
 /**
  * @brief Starts a function rendering that starts rendering the 3DS's top screen and bottom screen with the concurrent added to members.
@@ -241,7 +342,7 @@ void add(Text& txt);
  * 
  * If you use centered or right, please use the `_BOT` enum version!
  * 
- * Render the sprites FIRST then render the text!!! if you don't do that in that order the text will overwrite things making it look ugly.
+ * Draw order is decided by `layer` then `z` of each sprite and text, higher is drawn above. If both are the same, sprites are drawn before texts, and members with the same graphic or font are drawn together so they end up in the same batch.
  * 
  * #### Example Usage:
  * ```
@@ -264,7 +365,7 @@ bool render();
 // Public logging macro
 #if defined(DEBUG)
     #define __FILENAME__ (strrchr(__FILE__, '/') ? strrchr(__FILE__, '/') + 1 : (strrchr(__FILE__, '\\') ? strrchr(__FILE__, '\\') + 1 : __FILE__))
-    #define trace(message) dsge::_internal::_logger(std::string(__FILENAME__) + ":" + std::to_string(__LINE__) + ": " + TSA(message))
+    #define trace(message) dsge::Log::_trace(__FILENAME__, __LINE__, message)
 #else
     #define trace(message) ((void)0)
 #endif
@@ -314,8 +415,6 @@ inline constexpr int WIDTH_BOTTOM = 320;
 // Implementation details (in header but not exposed in namespace)
 namespace _internal {
     // These are implementation details that shouldn't be used directly
-    extern std::vector<Text> _debugText;
-    extern std::vector<u8> _debugCol;
     extern C3D_RenderTarget* top;
     extern std::vector<u64> fpsCtr;
 }
@@ -0,0 +1,303 @@
+#include "entity.hpp"
+
+namespace {
+    // Fields handed out by EntityStore::get() for stale handles, so nothing in the store gets written.
+    struct {
+        float x, y, angle, alpha, width, height, scaleX, scaleY, accelX, accelY, accelAngle;
+        u32 color;
+        u8 visible;
+    } scratch;
+}
+
+namespace dsge {
+EntityStore::EntityStore(size_t reserve):
+    bottom(false),
+    layer(0),
+    visible(true),
+    z(0)
+{
+    _private.image = {NULL, NULL};
+    _private.sprite = NULL;
+    _private.handle = {};
+    _private.width = 8;
+    _private.height = 8;
+    _private.color = 0xFFFFFFFF;
+    _private.snapshotTick = 0;
+    this->reserve(reserve);
+}
+
+EntityStore::~EntityStore() {
+    dsge::remove(_private.handle);
+
+    if (_private.sprite) {
+        TextureCache::_release(_private.sprite);
+    }
+}
+
+void EntityStore::makeGraphic(int width, int height, u32 color) {
+    if (_private.sprite) {
+        TextureCache::_release(_private.sprite);
+        _private.sprite = NULL;
+    }
+    _private.image = {NULL, NULL};
+
+    _private.width = fabs(width);
+    _private.height = fabs(height);
+    _private.color = color;
+}
+
+bool EntityStore::loadGraphic(const std::string& file) {
+    C2D_SpriteSheet sheet = TextureCache::_acquire(file);
+    if (_private.sprite) {
+        TextureCache::_release(_private.sprite);
+    }
+
+    _private.sprite = sheet;
+    if (!_private.sprite) {
+        _private.image = {NULL, NULL};
+        trace("[WARN] EntityStore::loadGraphic: Failed to load Sprite sheet: " + file);
+        return false;
+    }
+
+    _private.image = C2D_SpriteSheetGetImage(_private.sprite, 0);
+    _private.width = _private.image.subtex->width;
+    _private.height = _private.image.subtex->height;
+    _private.color = 0xFFFFFFFF;
+
+    return true;
+}
+
+void EntityStore::setSize(size_t count) {
+    fields.x.resize(count);
+    fields.y.resize(count);
+    fields.angle.resize(count);
+    fields.alpha.resize(count);
+    fields.width.resize(count);
+    fields.height.resize(count);
+    fields.scaleX.resize(count);
+    fields.scaleY.resize(count);
+    fields.accelX.resize(count);
+    fields.accelY.resize(count);
+    fields.accelAngle.resize(count);
+    fields.color.resize(count);
+    fields.visible.resize(count);
+    _private.owner.resize(count);
+    _private.prevX.resize(count);
+    _private.prevY.resize(count);
+    _private.prevAngle.resize(count);
+}
+
+void EntityStore::reserve(size_t count) {
+    fields.x.reserve(count);
+    fields.y.reserve(count);
+    fields.angle.reserve(count);
+    fields.alpha.reserve(count);
+    fields.width.reserve(count);
+    fields.height.reserve(count);
+    fields.scaleX.reserve(count);
+    fields.scaleY.reserve(count);
+    fields.accelX.reserve(count);
+    fields.accelY.reserve(count);
+    fields.accelAngle.reserve(count);
+    fields.color.reserve(count);
+    fields.visible.reserve(count);
+    _private.owner.reserve(count);
+    _private.slots.reserve(count);
+    _private.generation.reserve(count);
+    _private.freeSlots.reserve(count);
+    _private.prevX.reserve(count);
+    _private.prevY.reserve(count);
+    _private.prevAngle.reserve(count);
+}
+
+EntityHandle EntityStore::create(float x, float y) {
+    u32 slot;
+    if (!_private.freeSlots.empty()) {
+        slot = _private.freeSlots.back();
+        _private.freeSlots.pop_back();
+    } else {
+        slot = _private.slots.size();
+        _private.slots.push_back(0);
+        _private.generation.push_back(1);
+    }
+
+    size_t i = size();
+    setSize(i + 1);
+    _private.slots[slot] = i;
+    _private.owner[i] = slot;
+
+    fields.x[i] = x;
+    fields.y[i] = y;
+    fields.angle[i] = 0;
+    fields.alpha[i] = 1;
+    fields.width[i] = _private.width;
+    fields.height[i] = _private.height;
+    fields.scaleX[i] = 1;
+    fields.scaleY[i] = 1;
+    fields.accelX[i] = 0;
+    fields.accelY[i] = 0;
+    fields.accelAngle[i] = 0;
+    fields.color[i] = _private.color;
+    fields.visible[i] = true;
+
+    // Nothing to blend from yet, so it's drawn where it got made.
+    _private.prevX[i] = x;
+    _private.prevY[i] = y;
+    _private.prevAngle[i] = 0;
+
+    return {slot, _private.generation[slot]};
+}
+
+bool EntityStore::isValid(EntityHandle handle) const {
+    return handle.generation != 0 && handle.index < _private.generation.size() && _private.generation[handle.index] == handle.generation;
+}
+
+bool EntityStore::destroy(EntityHandle handle) {
+    if (!isValid(handle)) return false;
+
+    if (++_private.generation[handle.index] == 0) _private.generation[handle.index] = 1;
+    _private.freeSlots.push_back(handle.index);
+
+    size_t i = _private.slots[handle.index];
+    size_t last = size() - 1;
+    if (i != last) {
+        fields.x[i] = fields.x[last];
+        fields.y[i] = fields.y[last];
+        fields.angle[i] = fields.angle[last];
+        fields.alpha[i] = fields.alpha[last];
+        fields.width[i] = fields.width[last];
+        fields.height[i] = fields.height[last];
+        fields.scaleX[i] = fields.scaleX[last];
+        fields.scaleY[i] = fields.scaleY[last];
+        fields.accelX[i] = fields.accelX[last];
+        fields.accelY[i] = fields.accelY[last];
+        fields.accelAngle[i] = fields.accelAngle[last];
+        fields.color[i] = fields.color[last];
+        fields.visible[i] = fields.visible[last];
+        _private.prevX[i] = _private.prevX[last];
+        _private.prevY[i] = _private.prevY[last];
+        _private.prevAngle[i] = _private.prevAngle[last];
+        _private.owner[i] = _private.owner[last];
+        _private.slots[_private.owner[i]] = i;
+    }
+
+    setSize(last);
+    return true;
+}
+
+void EntityStore::clear() {
+    for (size_t i = 0; i < size(); i++) {
+        u32 slot = _private.owner[i];
+        if (++_private.generation[slot] == 0) _private.generation[slot] = 1;
+        _private.freeSlots.push_back(slot);
+    }
+    setSize(0);
+}
+
+Entity EntityStore::at(size_t i) {
+    return {
+        fields.x[i], fields.y[i], fields.angle[i], fields.alpha[i], fields.color[i], fields.visible[i], fields.width[i], fields.height[i],
+        {fields.scaleX[i], fields.scaleY[i]},
+        {fields.accelX[i], fields.accelY[i], fields.accelAngle[i]}
+    };
+}
+
+Entity EntityStore::get(EntityHandle handle) {
+    if (!isValid(handle)) {
+        trace("[WARN] EntityStore::get: Handle is stale, the entity has been destroyed!");
+        return {
+            scratch.x, scratch.y, scratch.angle, scratch.alpha, scratch.color, scratch.visible, scratch.width, scratch.height,
+            {scratch.scaleX, scratch.scaleY},
+            {scratch.accelX, scratch.accelY, scratch.accelAngle}
+        };
+    }
+
+    return at(_private.slots[handle.index]);
+}
+
+void EntityStore::_integrate(float steps) {
+    size_t count = size();
+    if (count == 0) return;
+
+    // One array at a time, so every loop is a straight run over contiguous floats.
+    float* x = fields.x.data();
+    const float* ax = fields.accelX.data();
+    for (size_t i = 0; i < count; i++) x[i] += ax[i] * steps;
+
+    float* y = fields.y.data();
+    const float* ay = fields.accelY.data();
+    for (size_t i = 0; i < count; i++) y[i] += ay[i] * steps;
+
+    float* angle = fields.angle.data();
+    const float* aa = fields.accelAngle.data();
+    for (size_t i = 0; i < count; i++) angle[i] += aa[i] * steps;
+}
+
+void EntityStore::_snapshot() {
+    _private.prevX = fields.x;
+    _private.prevY = fields.y;
+    _private.prevAngle = fields.angle;
+    _private.snapshotTick = Loop::ticks();
+}
+
+bool EntityStore::_prepare() {
+    return visible && size() != 0;
+}
+
+u32 EntityStore::_draw() {
+    DSGE_PROFILE_ZONE("EntityStore::_draw");
+
+    const float screenWidth = bottom ? dsge::WIDTH_BOTTOM : dsge::WIDTH;
+    const float blend = _internal::blendFactor(_private.snapshotTick);
+    u32 drawn = 0;
+    size_t count = size();
+
+    for (size_t i = 0; i < count; i++) {
+        if (!fields.visible[i] || fields.alpha[i] <= 0) continue;
+
+        // Like sprites: x and y is the top left corner, rotated around the center of the scaled entity.
+        float w = fields.width[i] * fields.scaleX[i];
+        float h = fields.height[i] * fields.scaleY[i];
+        float ex = fields.x[i], ey = fields.y[i], ea = fields.angle[i];
+        if (blend < 1) {
+            ex = _private.prevX[i] + (ex - _private.prevX[i]) * blend;
+            ey = _private.prevY[i] + (ey - _private.prevY[i]) * blend;
+            ea = _private.prevAngle[i] + (ea - _private.prevAngle[i]) * blend;
+        }
+
+        float cx = ex + w / 2;
+        float cy = ey + h / 2;
+
+        // Half of the width plus half of the height always covers the rotated rectangle.
+        float reach = (fabs(w) + fabs(h)) / 2;
+        if (cx + reach < 0 || cx - reach > screenWidth || cy + reach < 0 || cy - reach > dsge::HEIGHT) continue;
+
+        float rad = ea * (M_PI / 180);
+        u32 color = fields.color[i];
+        float alpha = fields.alpha[i] >= 1 ? 1 : fields.alpha[i];
+        color = (color & 0x00FFFFFF) | ((u32)(((color >> 24) & 0xFF) * alpha) << 24);
+
+        if (_private.image.tex != NULL) {
+            C2D_PlainImageTint(&_private.tint, C2D_Color32((color >> 16) & 0xFF, (color >> 8) & 0xFF, color & 0xFF, color >> 24), 0);
+
+            C2D_DrawParams params = {{cx, cy, w, h}, {w / 2, h / 2}, 0, rad};
+            C2D_DrawImage(_private.image, &params, &_private.tint);
+        } else if (rad == 0) {
+            C2D_DrawRectSolid(cx - fabs(w) / 2, cy - fabs(h) / 2, 0, fabs(w), fabs(h), color);
+        } else {
+            float c = cosf(rad), s = sinf(rad);
+            float hx = w / 2, hy = h / 2;
+
+            // Corners: top left, top right, bottom left, bottom right.
+            float px[4] = {cx - hx * c + hy * s, cx + hx * c + hy * s, cx - hx * c - hy * s, cx + hx * c - hy * s};
+            float py[4] = {cy - hx * s - hy * c, cy + hx * s - hy * c, cy - hx * s + hy * c, cy + hx * s + hy * c};
+
+            C2D_DrawTriangle(px[0], py[0], color, px[1], py[1], color, px[2], py[2], color, 0);
+            C2D_DrawTriangle(px[2], py[2], color, px[1], py[1], color, px[3], py[3], color, 0);
+        }
+        drawn++;
+    }
+
+    return drawn;
+}
+} // namespace dsge
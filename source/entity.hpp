@@ -0,0 +1,192 @@
+#ifndef DSGE_ENTITY_HPP
+#define DSGE_ENTITY_HPP
+
+#include "dsge.hpp"
+
+namespace dsge {
+// A handle to an entity of an EntityStore, stale once the entity is destroyed.
+struct EntityHandle {
+    u32 index = 0;
+    u32 generation = 0; // 0 is never valid.
+};
+
+/**
+ * @brief References to the fields of one entity, named like the ones of `dsge::Sprite`.
+ * 
+ * #### Note:
+ * 
+ * The references point into the store, don't keep an Entity around after creating or destroying entities.
+ */
+struct Entity {
+    float& x;     // X Position of the entity.
+    float& y;     // Y Position of the entity.
+    float& angle; // Rotation angle.
+    float& alpha; // Alpha transparency (0 = invisible, 1 = fully visible)
+    u32& color;   // Entity color, tints the graphic if the store has one.
+    u8& visible;  // Entity visibility.
+    float& width;
+    float& height;
+
+    struct {
+        float& x; // Horizontal scale.
+        float& y; // Vertical scale.
+
+        void set(float x = 1, float y = 1) {
+            this->x = x;
+            this->y = y;
+        }
+    } scale;
+
+    struct {
+        float& x; // X's Acceleration speed.
+        float& y; // Y's Acceleration speed.
+        float& angle; // Angle's Acceleration speed.
+    } acceleration;
+};
+
+/**
+ * @brief A lot of sprites sharing one graphic, stored as arrays of fields instead of objects.
+ * 
+ * Meant for bullets, particles and anything else there's thousands of. Every entity is moved by the
+ * same batched pass once per frame, even if it's off screen, and the whole store is drawn as a single member.
+ * 
+ * Destroying an entity moves the last one in it's place, so the draw order inside of the store may change.
+ * 
+ * citro2d draws 4096 objects per frame by default, everything included. For more than that pass a higher limit to `dsge::init()`, like `dsge::init(16384)`.
+ * 
+ * #### Example Usage:
+ * ```
+ * dsge::EntityStore bullets;
+ * bullets.makeGraphic(4, 4, 0xFFFFFF00);
+ * dsge::add(bullets);
+ * 
+ * dsge::EntityHandle bullet = bullets.create(200, 120);
+ * bullets.get(bullet).acceleration.y = -4;
+ * ```
+ */
+class EntityStore {
+public:
+    bool bottom;   // Whetever or not you want to render in the bottom screen.
+    u8   layer;    // Draw layer, higher layers are always drawn above lower ones.
+    bool visible;  // Visibility of the whole store.
+    int  z;        // Draw order inside of the layer, higher is drawn above.
+
+    // Arrays of every field, index `i` of each is the same entity. Read and write them directly for batch work.
+    struct {
+        std::vector<float> x, y, angle, alpha, width, height;
+        std::vector<float> scaleX, scaleY;
+        std::vector<float> accelX, accelY, accelAngle;
+        std::vector<u32> color;
+        std::vector<u8> visible;
+    } fields;
+
+    struct {
+        C2D_Image image;
+        C2D_SpriteSheet sprite;
+        C2D_ImageTint tint;
+        MemberHandle handle;
+        float width, height; // Size of new entities.
+        u32 color;           // Color of new entities.
+
+        std::vector<u32> owner;      // Handle slot of every entity.
+        std::vector<u32> slots;      // Index of the entity of every handle slot.
+        std::vector<u32> generation; // Generation of every handle slot.
+        std::vector<u32> freeSlots;
+
+        // Position and angle of every entity before the last fixed step, see dsge::Loop.
+        std::vector<float> prevX, prevY, prevAngle;
+        u32 snapshotTick;
+    } _private;
+
+    /**
+     * @brief Constructor: Creates an empty store.
+     * @param reserve Amount of entities to allocate room for, so creating them won't allocate.
+     */
+    EntityStore(size_t reserve = 0);
+    ~EntityStore();
+
+    // Members keep a pointer to the store, so it can't be copied.
+    EntityStore(const EntityStore&) = delete;
+    EntityStore& operator=(const EntityStore&) = delete;
+
+    /**
+     * @brief Sets the rectangle used by entities made after this call, removes the loaded graphic.
+     * @param width  Width of the graphic.
+     * @param height Height of the graphic.
+     * @param color  Color of the graphic.
+     */
+    void makeGraphic(int width = 8, int height = 8, u32 color = 0xFFFFFFFF);
+
+    /**
+     * @brief Loads a .t3x image from romfs, which every entity is drawn with.
+     * @param file Path to image file (without "romfs:/" prefix).
+     * @returns `true` if successful, `false` otherwise.
+     * 
+     * Entities made after this call get the size of the image.
+     */
+    bool loadGraphic(const std::string& file);
+
+    /**
+     * @brief Creates an entity at position (x, y), using the size and color of the graphic.
+     * @return A handle to the entity.
+     */
+    EntityHandle create(float x = 0, float y = 0);
+
+    /**
+     * @brief Destroys an entity.
+     * @param handle The handle from `create()`.
+     * @return `true` if the entity existed.
+     */
+    bool destroy(EntityHandle handle);
+
+    /**
+     * @brief Checks if an entity still exists.
+     * @param handle The handle from `create()`.
+     */
+    bool isValid(EntityHandle handle) const;
+
+    /**
+     * @brief Gets the fields of an entity.
+     * @param handle The handle from `create()`, it has to be valid.
+     * @return References to the fields, see `dsge::Entity`.
+     * 
+     * #### Example Usage:
+     * ```
+     * dsge::Entity e = bullets.get(bullet);
+     * e.x += 2;
+     * e.scale.set(2, 2);
+     * ```
+     */
+    Entity get(EntityHandle handle);
+
+    /**
+     * @brief Gets the fields of the entity at index `i` of the arrays, from 0 to `size() - 1`.
+     */
+    Entity at(size_t i);
+
+    /**
+     * @brief Amount of entities in the store.
+     */
+    size_t size() const { return fields.x.size(); }
+
+    /**
+     * @brief Destroys every entity, the memory is kept for the next ones.
+     */
+    void clear();
+
+    /**
+     * @brief Allocates room for `count` entities.
+     */
+    void reserve(size_t count);
+
+    void _integrate(float steps);
+    void _snapshot();
+    bool _prepare();
+    u32 _draw();
+
+private:
+    void setSize(size_t count);
+};
+} // namespace dsge
+
+#endif
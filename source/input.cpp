@@ -0,0 +1,104 @@
+#include "input.hpp"
+#include "dsge.hpp"
+
+namespace {
+    constexpr size_t QUEUE_SIZE = 64; // Power of two.
+
+    dsge::inputState current = {};
+
+    struct {
+        dsge::inputEvent events[QUEUE_SIZE];
+        size_t head = 0;  // Oldest event.
+        size_t count = 0;
+    } queue;
+
+    void push(inputEventType type, u32 key, u16 x, u16 y) {
+        if (queue.count == QUEUE_SIZE) {
+            // Full, the oldest one goes.
+            queue.head = (queue.head + 1) & (QUEUE_SIZE - 1);
+            queue.count--;
+        }
+
+        queue.events[(queue.head + queue.count) & (QUEUE_SIZE - 1)] = {type, key, x, y, current.frame};
+        queue.count++;
+    }
+
+    // One event per changed key, lowest bit first.
+    void pushKeys(inputEventType type, u32 keys) {
+        while (keys != 0) {
+            u32 key = keys & -keys;
+            keys ^= key;
+
+            if (key == KEY_TOUCH) push(type, key, current.touch.px, current.touch.py);
+            else push(type, key, 0, 0);
+        }
+    }
+}
+
+namespace dsge {
+namespace Input {
+const inputState& state() {
+    return current;
+}
+
+bool isHeld(u32 keys) {
+    return current.held & keys;
+}
+
+bool isDown(u32 keys) {
+    return current.down & keys;
+}
+
+bool isUp(u32 keys) {
+    return current.up & keys;
+}
+
+bool pollEvent(inputEvent& out) {
+    if (queue.count == 0) return false;
+
+    out = queue.events[queue.head];
+    queue.head = (queue.head + 1) & (QUEUE_SIZE - 1);
+    queue.count--;
+    return true;
+}
+
+size_t pending() {
+    return queue.count;
+}
+
+void flushEvents() {
+    queue.head = 0;
+    queue.count = 0;
+}
+
+void _scan() {
+    DSGE_PROFILE_ZONE("Input::_scan");
+
+    touchPosition last = current.touch;
+    u32 previous = current.held;
+    current.frame++;
+
+    if (!Replay::_readInput(current)) {
+        // The only hidScanInput() of the frame, scanning again would eat the down and up bits.
+        hidScanInput();
+        current.held = hidKeysHeld();
+        hidCircleRead(&current.circle);
+        if (current.held & KEY_TOUCH) hidTouchRead(&current.touch);
+
+        Replay::_writeInput(current);
+    }
+
+    // Same as hidKeysDown() and hidKeysUp(), but works for played back input too.
+    current.down = current.held & ~previous;
+    current.up = ~current.held & previous;
+
+    pushKeys(INPUT_PRESS, current.down);
+    pushKeys(INPUT_RELEASE, current.up);
+
+    bool moved = current.touch.px != last.px || current.touch.py != last.py;
+    if ((current.held & KEY_TOUCH) && !(current.down & KEY_TOUCH) && moved) {
+        push(INPUT_DRAG, KEY_TOUCH, current.touch.px, current.touch.py);
+    }
+}
+} // namespace Input
+} // namespace dsge
@@ -0,0 +1,115 @@
+#ifndef DSGE_INPUT_HPP
+#define DSGE_INPUT_HPP
+
+#include <3ds.h>
+
+typedef enum {
+    INPUT_PRESS = 0,   // A key got pressed or the screen got touched.
+    INPUT_RELEASE = 1, // A key got released or the stylus got lifted.
+    INPUT_DRAG = 2     // The stylus moved while touching, only for KEY_TOUCH.
+} inputEventType;
+
+namespace dsge {
+/**
+ * @brief Everything read from the 3DS's buttons, touch screen and circle pad at the start of a frame.
+ *
+ * Taken once by `dsge::render()`, so every check in the same frame sees the same thing.
+ */
+struct inputState {
+    u32 held;              // KEY_* bits held down.
+    u32 down;              // KEY_* bits pressed this frame.
+    u32 up;                // KEY_* bits released this frame.
+    touchPosition touch;   // Where the screen is touched, kept on the last position after it's released.
+    circlePosition circle; // Circle pad position, about -156 to 156 on both axes.
+    u32 frame;             // Amount of snapshots taken so far, 0 before the first `dsge::render()`.
+};
+
+/**
+ * @brief A single press, release or drag, queued until it's read with `Input::pollEvent()`.
+ */
+struct inputEvent {
+    inputEventType type;
+    u32 key;    // A single KEY_* bit, KEY_TOUCH for the touch screen.
+    u16 x, y;   // Touch position, only for KEY_TOUCH.
+    u32 frame;  // Frame it happened on, see `inputState::frame`.
+};
+
+namespace Input {
+
+/**
+ * @brief The input snapshot of the current frame.
+ *
+ * #### Example Usage:
+ * ```
+ * while (dsge::render()) {
+ *     const dsge::inputState& in = dsge::Input::state();
+ *     player.x += in.circle.dx / 32.0;
+ * }
+ * ```
+ */
+const inputState& state();
+
+/**
+ * @brief Checks if any of the keys are held down.
+ * @param keys One or more KEY_* bits, like `KEY_A | KEY_B`.
+ */
+bool isHeld(u32 keys);
+
+/**
+ * @brief Checks if any of the keys got pressed this frame.
+ * @param keys One or more KEY_* bits, like `KEY_A | KEY_B`.
+ *
+ * #### Example Usage:
+ * ```
+ * while (dsge::render()) {
+ *     if (dsge::Input::isDown(KEY_START)) break;
+ * }
+ * ```
+ */
+bool isDown(u32 keys);
+
+/**
+ * @brief Checks if any of the keys got released this frame.
+ * @param keys One or more KEY_* bits, like `KEY_A | KEY_B`.
+ */
+bool isUp(u32 keys);
+
+/**
+ * @brief Takes the oldest event out of the queue.
+ * @param out Where the event gets written to.
+ * @return `true` if there was one, `false` if the queue is empty.
+ *
+ * #### Details:
+ *
+ * Events stay queued over frames until they're read, so a press can't be missed by skipping a frame. The queue
+ * holds the last 64 events, older ones are dropped if it isn't read.
+ *
+ * #### Example Usage:
+ * ```
+ * dsge::inputEvent e;
+ * while (dsge::Input::pollEvent(e)) {
+ *     if (e.key == KEY_TOUCH && e.type == INPUT_DRAG) {
+ *         cursor.x = e.x;
+ *         cursor.y = e.y;
+ *     }
+ * }
+ * ```
+ */
+bool pollEvent(inputEvent& out);
+
+/**
+ * @brief Amount of events waiting in the queue.
+ */
+size_t pending();
+
+/**
+ * @brief Drops every queued event, like when changing to another menu.
+ */
+void flushEvents();
+
+void _scan();
+
+} // namespace Input
+} // namespace dsge
+
+#endif
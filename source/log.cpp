@@ -0,0 +1,185 @@
+#include "log.hpp"
+#include <atomic>
+#include <cstdio>
+
+namespace {
+    // Every entry is a small seqlock: `seq` is odd while being written, and 2 * (index + 1) once done.
+    struct LogEntry {
+        std::atomic<u32> seq{0};
+        char text[dsge::Log::LINE_LENGTH];
+    };
+
+    LogEntry entries[dsge::Log::CAPACITY];
+    std::atomic<u32> writeIndex{0};
+
+    // Copies entry `index` into `out`, returns false if it isn't written yet or got overwritten.
+    bool readEntry(u32 index, char* out) {
+        const LogEntry& entry = entries[index % dsge::Log::CAPACITY];
+        u32 expected = 2 * (index + 1);
+
+        if (entry.seq.load(std::memory_order_acquire) != expected) return false;
+        memcpy(out, entry.text, dsge::Log::LINE_LENGTH);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return entry.seq.load(std::memory_order_relaxed) == expected;
+    }
+
+    // Overlay, every line keeps it's own Text so the glyphs are only parsed once per message.
+    struct OverlayLine {
+        u32 index; // Log entry shown by the line.
+        u32 frame; // Frame the line showed up, it fades out over 255 frames.
+        bool used;
+    };
+
+    OverlayLine overlay[dsge::Log::OVERLAY_MAX] = {};
+    u32 overlayRead = 0; // Next entry for the overlay and stdout.
+    u32 overlayFrame = 0;
+
+    dsge::Text& overlayText(int slot) {
+        static dsge::Text* texts = nullptr;
+        if (!texts) {
+            texts = new dsge::Text[dsge::Log::OVERLAY_MAX];
+            for (int i = 0; i < dsge::Log::OVERLAY_MAX; i++) {
+                texts[i].scale.set(0.4, 0.4);
+                texts[i]._private.debug = true;
+            }
+        }
+        return texts[slot];
+    }
+
+    // File sink
+    FILE* sinkFile = nullptr;
+    Thread sinkThread = nullptr;
+    std::atomic<bool> sinkQuit{false};
+    u32 sinkRead = 0;
+
+    void drainToFile() {
+        char line[dsge::Log::LINE_LENGTH];
+        u32 end = writeIndex.load(std::memory_order_acquire);
+
+        // Skip what got overwritten before the sink could write it.
+        if (end - sinkRead > (u32)dsge::Log::CAPACITY) {
+            fprintf(sinkFile, "[%lu messages lost]\n", (unsigned long)(end - sinkRead - dsge::Log::CAPACITY));
+            sinkRead = end - dsge::Log::CAPACITY;
+        }
+
+        for (; sinkRead != end; sinkRead++) {
+            if (!readEntry(sinkRead, line)) {
+                break; // Still being written, try again next time.
+            }
+            fputs(line, sinkFile);
+            fputc('\n', sinkFile);
+        }
+        fflush(sinkFile);
+    }
+
+    void sinkMain(void*) {
+        DSGE_PROFILE_THREAD("Log");
+
+        while (!sinkQuit.load()) {
+            drainToFile();
+            svcSleepThread(250 * 1000000LL);
+        }
+        drainToFile();
+    }
+}
+
+namespace dsge {
+namespace Log {
+int overlayLines = OVERLAY_MAX;
+
+void write(const char* message) {
+    u32 index = writeIndex.fetch_add(1, std::memory_order_relaxed);
+    LogEntry& entry = entries[index % CAPACITY];
+
+    entry.seq.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    strncpy(entry.text, message, LINE_LENGTH - 1);
+    entry.text[LINE_LENGTH - 1] = '\0';
+
+    entry.seq.store(2 * (index + 1), std::memory_order_release);
+}
+
+bool startFileSink(const std::string& filePath) {
+    if (sinkThread) return true;
+
+    sinkFile = fopen(("sdmc:/" + filePath).c_str(), "a");
+    if (!sinkFile) {
+        trace("[WARN] Log::startFileSink: Could not open file: sdmc:/" + filePath);
+        return false;
+    }
+
+    // Lowest priority, it should only run when everything else is waiting.
+    sinkRead = writeIndex.load();
+    sinkQuit = false;
+    sinkThread = threadCreate(sinkMain, nullptr, 8 * 1024, 0x3F, -2, false);
+    if (!sinkThread) {
+        fclose(sinkFile);
+        sinkFile = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void stopFileSink() {
+    if (!sinkThread) return;
+
+    sinkQuit = true;
+    threadJoin(sinkThread, UINT64_MAX);
+    threadFree(sinkThread);
+    sinkThread = nullptr;
+
+    fclose(sinkFile);
+    sinkFile = nullptr;
+}
+
+void _renderOverlay() {
+    char line[LINE_LENGTH];
+    u32 end = writeIndex.load(std::memory_order_acquire);
+    if (end - overlayRead > (u32)OVERLAY_MAX) {
+        overlayRead = end - OVERLAY_MAX; // Older ones wouldn't be shown anyway.
+    }
+
+    // New messages take the slot of the oldest line, the others keep their parsed glyphs.
+    for (; overlayRead != end; overlayRead++) {
+        if (!readEntry(overlayRead, line)) break;
+
+        puts(line);
+
+        int slot = overlayRead % OVERLAY_MAX;
+        overlay[slot] = {overlayRead, overlayFrame, true};
+
+        Text& text = overlayText(slot);
+        text.text = line;
+        text.scale.set(0.4, 0.4);
+    }
+
+    // Newest on top.
+    int shown = 0;
+    int maxLines = overlayLines < OVERLAY_MAX ? overlayLines : OVERLAY_MAX;
+    for (u32 n = 0; n < (u32)OVERLAY_MAX && n < overlayRead && shown < maxLines; n++) {
+        u32 i = overlayRead - 1 - n;
+        OverlayLine& info = overlay[i % OVERLAY_MAX];
+        if (!info.used || info.index != i) break;
+
+        u32 age = overlayFrame - info.frame;
+        if (age >= 255) {
+            info.used = false;
+            continue;
+        }
+
+        Text& text = overlayText(i % OVERLAY_MAX);
+        text.x = 2;
+        text.y = 2 + (11 * shown);
+        text.color = 0x00FFFFFF | ((255 - age) << 24);
+        if (text.width > 398) {
+            text.scale.x -= 0.01;
+        }
+        text._render();
+        shown++;
+    }
+
+    overlayFrame++;
+}
+}
+} // namespace dsge
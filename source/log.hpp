@@ -0,0 +1,115 @@
+#ifndef DSGE_LOG_HPP
+#define DSGE_LOG_HPP
+
+#include "dsge.hpp"
+#include <sstream>
+#include <string>
+#include <type_traits>
+
+namespace dsge {
+namespace Log {
+/**
+ * @brief Amount of messages kept in the log ring, older ones get overwritten.
+ */
+inline constexpr int CAPACITY = 128;
+
+/**
+ * @brief Maximum length of a message, longer ones are cut.
+ */
+inline constexpr int LINE_LENGTH = 128;
+
+/**
+ * @brief Maximum amount of lines the DEBUG overlay can show.
+ */
+inline constexpr int OVERLAY_MAX = 22;
+
+/**
+ * @brief Amount of newest messages shown on the top screen in DEBUG builds, 22 by default.
+ * 
+ * #### Example Usage:
+ * ```
+ * dsge::Log::overlayLines = 5; // Keep most of the screen clear.
+ * ```
+ */
+extern int overlayLines;
+
+/**
+ * @brief Writes a message to the log, this is what `trace` uses.
+ * @param message The message to write, it's copied so it can be freed right after.
+ * 
+ * Never allocates or locks, so it's safe to use in hot loops, audio threads and timer threads.
+ * 
+ * #### Example Usage:
+ * ```
+ * dsge::Log::write("Boss spawned!");
+ * ```
+ */
+void write(const char* message);
+
+/**
+ * @brief Starts a background thread that appends every message to a file in `sdmc:/`.
+ * @param filePath The path to save as, without `sdmc:/`.
+ * @returns `true` if the file could be opened, `false` otherwise.
+ * 
+ * Messages are written in batches a few times per second, so the game never waits on the SD card.
+ * 
+ * #### Example Usage:
+ * ```
+ * dsge::init();
+ * dsge::Log::startFileSink("my_game.log");
+ * ```
+ */
+bool startFileSink(const std::string& filePath = "dsge.log");
+
+/**
+ * @brief Writes what's left to the log file and stops the background thread.
+ * 
+ * Called by `dsge::exit()`.
+ */
+void stopFileSink();
+
+// Formats a value into `out` without allocating for strings, numbers and booleans.
+template<typename T>
+void _format(char* out, size_t size, size_t& len, const T& value) {
+    if (len >= size - 1) return;
+
+    if constexpr (std::is_same_v<T, bool>) {
+        len += snprintf(out + len, size - len, "%s", value ? "1" : "0");
+    } else if constexpr (std::is_same_v<T, char> || std::is_same_v<T, signed char> || std::is_same_v<T, unsigned char>) {
+        len += snprintf(out + len, size - len, "%c", (char)value);
+    } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+        len += snprintf(out + len, size - len, "%lld", (long long)value);
+    } else if constexpr (std::is_integral_v<T>) {
+        len += snprintf(out + len, size - len, "%llu", (unsigned long long)value);
+    } else if constexpr (std::is_floating_point_v<T>) {
+        len += snprintf(out + len, size - len, "%g", (double)value);
+    } else if constexpr (std::is_convertible_v<const T&, const char*>) {
+        len += snprintf(out + len, size - len, "%s", (const char*)value);
+    } else if constexpr (std::is_same_v<T, std::string>) {
+        len += snprintf(out + len, size - len, "%s", value.c_str());
+    } else {
+        std::ostringstream oss; // Anything else still has to go through it's operator<<.
+        oss << value;
+        len += snprintf(out + len, size - len, "%s", oss.str().c_str());
+    }
+
+    if (len > size - 1) len = size - 1;
+}
+
+template<typename T>
+void _trace(const char* file, int line, const T& message) {
+    char buffer[LINE_LENGTH];
+    size_t len = 0;
+    _format(buffer, sizeof(buffer), len, file);
+    _format(buffer, sizeof(buffer), len, ':');
+    _format(buffer, sizeof(buffer), len, line);
+    _format(buffer, sizeof(buffer), len, ": ");
+    _format(buffer, sizeof(buffer), len, message);
+    write(buffer);
+}
+
+void _renderOverlay();
+}
+} // namespace dsge
+
+#endif
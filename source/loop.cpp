@@ -0,0 +1,121 @@
+#include "loop.hpp"
+#include "dsge.hpp"
+
+namespace {
+    struct {
+        std::function<void()> update;
+        u64 stepTicks = 0;   // System ticks per step.
+        u64 accumulator = 0; // System ticks not simulated yet.
+        int maxSteps = 5;
+        float alpha = 1;
+        u32 tick = 0;
+        u64 lastFrame = 0;   // System tick of the last frame, 0 before the first one.
+    } loop;
+}
+
+namespace dsge {
+namespace _internal {
+bool interpolating = false;
+
+float blendFactor(u32 tick) {
+    if (!interpolating || tick == 0 || tick != loop.tick) return 1;
+    return loop.alpha;
+}
+
+void Snapshot::take(float x, float y, float angle) {
+    this->x = x;
+    this->y = y;
+    this->angle = angle;
+    tick = loop.tick;
+}
+
+void Snapshot::blend(float& x, float& y, float& angle) const {
+    float a = blendFactor(tick);
+    if (a >= 1) return;
+
+    x = this->x + (x - this->x) * a;
+    y = this->y + (y - this->y) * a;
+    angle = this->angle + (angle - this->angle) * a;
+}
+}
+
+namespace Loop {
+void setFixed(std::function<void()> update, int rate, int maxSteps) {
+    if (rate <= 0) {
+        trace("[WARN] Loop::setFixed: Rate has to be above 0!");
+        return;
+    }
+
+    loop.update = update;
+    loop.stepTicks = SYSCLOCK_ARM11 / rate;
+    loop.maxSteps = maxSteps < 1 ? 1 : maxSteps;
+    loop.accumulator = 0;
+    loop.alpha = 1;
+}
+
+void clearFixed() {
+    loop.update = nullptr;
+    loop.accumulator = 0;
+    loop.alpha = 1;
+}
+
+bool isFixed() {
+    return loop.update != nullptr;
+}
+
+float stepTime() {
+    return loop.update ? (float)loop.stepTicks / SYSCLOCK_ARM11 : 0;
+}
+
+float alpha() {
+    return loop.alpha;
+}
+
+u32 ticks() {
+    return loop.tick;
+}
+
+float _beginFrame() {
+    u64 now = svcGetSystemTick();
+    u64 delta = loop.lastFrame != 0 ? now - loop.lastFrame : 0;
+    loop.lastFrame = now;
+
+    // Recorded frame times are played back instead, so the same steps run.
+    delta = Replay::_frameDelta(delta);
+
+    if (loop.update) loop.accumulator += delta;
+    return (float)((double)delta / SYSCLOCK_ARM11);
+}
+
+int _steps() {
+    if (!loop.update) return 0;
+
+    u64 steps = loop.accumulator / loop.stepTicks;
+    loop.accumulator -= steps * loop.stepTicks;
+
+    // Too far behind, keep the game slowed down instead of spending the next frames catching up.
+    if (steps > (u64)loop.maxSteps) steps = loop.maxSteps;
+
+    loop.alpha = (float)loop.accumulator / loop.stepTicks;
+    return steps;
+}
+
+void _resync() {
+    loop.accumulator = 0;
+    loop.alpha = 1;
+}
+
+void _nextTick() {
+    // Tick 0 is never used, so untouched snapshots are never blended.
+    if (++loop.tick == 0) loop.tick = 1;
+}
+
+void _update() {
+    if (!loop.update) return;
+
+    // Kept alive in case the update replaces itself.
+    std::function<void()> update = loop.update;
+    update();
+}
+} // namespace Loop
+} // namespace dsge
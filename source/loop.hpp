@@ -0,0 +1,88 @@
+#ifndef DSGE_LOOP_HPP
+#define DSGE_LOOP_HPP
+
+#include <3ds.h>
+#include <functional>
+
+namespace dsge {
+namespace Loop {
+
+/**
+ * @brief Runs `update` at a fixed rate from `dsge::render()`, no matter how fast frames are drawn.
+ * @param update Function that updates the game, called once per step.
+ * @param rate Steps per second, 60 by default.
+ * @param maxSteps Most steps that can run in a single frame, the time left over is dropped so a slow frame can't snowball.
+ *
+ * #### Details:
+ *
+ * Every step, the position and angle of each added sprite, text and entity is saved, `update` is called and
+ * then acceleration is applied, once per step instead of once per frame. Drawing then blends the last two steps,
+ * so dropped frames only cost smoothness and the game keeps running at the same speed.
+ *
+ * Code after `dsge::render()` still runs once per frame.
+ *
+ * #### Example Usage:
+ * ```
+ * dsge::Loop::setFixed([&]() {
+ *     player.x += input.x * 2; // Always 120 pixels per second.
+ * }, 60);
+ *
+ * while (dsge::render()) {
+ *     // Per frame stuff here.
+ * }
+ * ```
+ */
+void setFixed(std::function<void()> update, int rate = 60, int maxSteps = 5);
+
+/**
+ * @brief Goes back to updating once per frame, `dsge::render()` stops blending states.
+ */
+void clearFixed();
+
+/**
+ * @brief Checks if an update has been set with `Loop::setFixed()`.
+ */
+bool isFixed();
+
+/**
+ * @brief Seconds between two steps, `1 / rate`.
+ */
+float stepTime();
+
+/**
+ * @brief How far drawing is between the previous and current step, from 0 to 1.
+ */
+float alpha();
+
+/**
+ * @brief Amount of steps run since the fixed update has been set.
+ */
+u32 ticks();
+
+float _beginFrame();
+int _steps();
+void _resync();
+void _nextTick();
+void _update();
+
+} // namespace Loop
+
+namespace _internal {
+    // Position and angle of a member before the last fixed step.
+    struct Snapshot {
+        float x, y, angle;
+        u32 tick; // Loop tick it has been taken on, 0 is never blended.
+
+        void take(float x, float y, float angle);
+        void blend(float& x, float& y, float& angle) const;
+    };
+
+    // Set by dsge::render() while members are being collected and drawn.
+    extern bool interpolating;
+
+    // Blend factor for a snapshot taken on `tick`, 1 means draw the current state as is.
+    float blendFactor(u32 tick);
+}
+} // namespace dsge
+
+#endif
@@ -0,0 +1,223 @@
+#include "mask.hpp"
+#include "dsge.hpp"
+
+namespace {
+    constexpr u8 ALPHA_THRESHOLD = 0x80;
+
+    // Pixel index inside of an 8x8 tile, textures are stored as Z-ordered tiles.
+    u32 morton(u32 x, u32 y) {
+        return (x & 1) | ((y & 1) << 1) | ((x & 2) << 1) | ((y & 2) << 2) | ((x & 4) << 2) | ((y & 4) << 3);
+    }
+
+    // Alpha of a texel, `y` counted from the top of the image.
+    u8 alphaAt(const C3D_Tex* tex, u32 x, u32 y) {
+        // Texture memory starts at the bottom row.
+        u32 my = tex->height - 1 - y;
+        u32 tile = (my >> 3) * (tex->width >> 3) + (x >> 3);
+        u32 i = tile * 64 + morton(x & 7, my & 7);
+        const u8* data = (const u8*)tex->data;
+
+        switch (tex->fmt) {
+            case GPU_RGBA8:    return data[i * 4];
+            case GPU_RGBA5551: return (((const u16*)data)[i] & 1) ? 0xFF : 0;
+            case GPU_RGBA4:    return (((const u16*)data)[i] & 0xF) * 0x11;
+            case GPU_LA8:      return data[i * 2];
+            case GPU_A8:       return data[i];
+            case GPU_LA4:      return (data[i] & 0xF) * 0x11;
+            case GPU_A4:       return ((i & 1 ? data[i / 2] >> 4 : data[i / 2]) & 0xF) * 0x11;
+            case GPU_ETC1A4: {
+                // 4x4 blocks of 8 bytes of alpha then 8 bytes of color, 4 blocks per tile.
+                u32 block = tile * 4 + ((my & 4) >> 1) + ((x & 4) >> 2);
+                u64 alpha;
+                memcpy(&alpha, data + block * 16, sizeof(alpha));
+                return ((alpha >> (((x & 3) * 4 + (my & 3)) * 4)) & 0xF) * 0x11;
+            }
+            default:           return 0xFF; // No alpha channel, fully solid.
+        }
+    }
+
+    // Copies `count` bits of a mask row from bit `start` on, into words starting at bit 0.
+    void extract(const u32* row, int words, int start, int count, u32* out) {
+        int outWords = (count + 31) >> 5;
+        for (int i = 0; i < outWords; i++) {
+            int bit = start + i * 32;
+            int w = bit >> 5;
+            int shift = bit & 31;
+
+            u32 lo = w < words ? row[w] : 0;
+            u32 hi = shift != 0 && w + 1 < words ? row[w + 1] : 0;
+            out[i] = shift != 0 ? (lo >> shift) | (hi << (32 - shift)) : lo;
+        }
+
+        if (count & 31) out[outWords - 1] &= (1u << (count & 31)) - 1;
+    }
+
+    // Whetever the center of a pixel is inside of a placed shape.
+    bool inside(const dsge::_internal::Collider& c, float px, float py) {
+        float dx = px - c.cx, dy = py - c.cy;
+        float along = dx * c.ux + dy * c.uy;
+        float side = dy * c.ux - dx * c.uy;
+
+        switch (c.shape.type) {
+            case SHAPE_CIRCLE: return dx * dx + dy * dy < c.radius * c.radius;
+            case SHAPE_CAPSULE: {
+                float off = along - std::clamp(along, -c.hx, c.hx);
+                return off * off + side * side < c.radius * c.radius;
+            }
+            default:           return fabsf(along) < c.hx && fabsf(side) < c.hy;
+        }
+    }
+
+    // Where a sprite is drawn, in whole screen pixels.
+    struct Placement {
+        const dsge::_internal::PixelMask* mask;   // nullptr is a solid box, unless there's a shape.
+        const dsge::_internal::Collider*  shape;  // Sprites without a pixel hitbox are solid inside of it.
+        int x, y, w, h;
+        float scaleX, scaleY;
+        bool flipX, flipY;
+    };
+
+    bool place(dsge::Sprite& spr, Placement& p) {
+        // Anything but a pixel hitbox is sampled from it's shape, rotated or not.
+        if (!spr._private.hitbox.enabled || !spr._private.hitbox.pixels) {
+            const dsge::_internal::Collider& c = spr._collider();
+            p.mask = nullptr;
+            p.shape = &c;
+            p.x = (int)floorf(c.bounds.left);
+            p.y = (int)floorf(c.bounds.top);
+            p.w = (int)ceilf(c.bounds.right) - p.x;
+            p.h = (int)ceilf(c.bounds.bottom) - p.y;
+            return true;
+        }
+
+        spr._updateTransform();
+        const dsge::_internal::Transform& t = spr._private.transform;
+        if (t.world.b != 0 || t.world.c != 0) return false; // Rotated
+
+        p.mask = spr._private.mask;
+        p.shape = nullptr;
+        p.scaleX = fabsf(t.world.a);
+        p.scaleY = fabsf(t.world.d);
+        p.flipX = t.world.a < 0;
+        p.flipY = t.world.d < 0;
+        p.x = (int)floorf(t.bounds.left + 0.5f);
+        p.y = (int)floorf(t.bounds.top + 0.5f);
+        p.w = (int)(spr.width * p.scaleX + 0.5f);
+        p.h = (int)(spr.height * p.scaleY + 0.5f);
+        return true;
+    }
+
+    // Solid pixels of screen row `y`, from column `x0` on, as packed bits.
+    void sampleRow(const Placement& p, int y, int x0, int count, u32* out) {
+        int outWords = (count + 31) >> 5;
+
+        if (p.shape) {
+            for (int i = 0; i < outWords; i++) out[i] = 0;
+            for (int j = 0; j < count; j++) {
+                if (inside(*p.shape, x0 + j + 0.5f, y + 0.5f)) out[j >> 5] |= 1u << (j & 31);
+            }
+            return;
+        }
+
+        if (!p.mask) {
+            for (int i = 0; i < outWords; i++) out[i] = ~0u;
+            if (count & 31) out[outWords - 1] = (1u << (count & 31)) - 1;
+            return;
+        }
+
+        const dsge::_internal::PixelMask& m = *p.mask;
+        int sy = (int)((y - p.y) / p.scaleY);
+        if (p.flipY) sy = m.height - 1 - sy;
+
+        int lx = x0 - p.x;
+        if (sy < 0 || sy >= m.height) {
+            for (int i = 0; i < outWords; i++) out[i] = 0;
+            return;
+        }
+
+        // Unscaled, a plain shift of the (mirrored) row.
+        if (p.scaleX == 1 && p.w == m.width) {
+            extract(m.row(sy, p.flipX), m.words, lx, count, out);
+            return;
+        }
+
+        const u32* row = m.row(sy, false);
+        for (int i = 0; i < outWords; i++) out[i] = 0;
+        for (int j = 0; j < count; j++) {
+            int sx = (int)((lx + j) / p.scaleX);
+            if (p.flipX) sx = m.width - 1 - sx;
+            if (sx >= 0 && sx < m.width && (row[sx >> 5] >> (sx & 31) & 1)) out[j >> 5] |= 1u << (j & 31);
+        }
+    }
+}
+
+namespace dsge {
+namespace _internal {
+bool buildMask(PixelMask& mask, const C2D_Image& image) {
+    const C3D_Tex* tex = image.tex;
+    const Tex3DS_SubTexture* sub = image.subtex;
+    if (!tex || !sub || !tex->data) return false;
+
+    // Images rotated inside of the sheet keep their box.
+    if (sub->top < sub->bottom) return false;
+
+    mask.width = sub->width;
+    mask.height = sub->height;
+    mask.words = (sub->width + 31) / 32;
+    mask.bits.assign(mask.words * mask.height, 0);
+    mask.mirrored.assign(mask.words * mask.height, 0);
+
+    u32 left = (u32)(sub->left * tex->width + 0.5f);
+    u32 top = (u32)((1 - sub->top) * tex->height + 0.5f);
+
+    for (u32 y = 0; y < mask.height; y++) {
+        u32* row = mask.bits.data() + y * mask.words;
+        u32* mirrored = mask.mirrored.data() + y * mask.words;
+
+        for (u32 x = 0; x < mask.width; x++) {
+            if (alphaAt(tex, left + x, top + y) < ALPHA_THRESHOLD) continue;
+
+            u32 mx = mask.width - 1 - x;
+            row[x >> 5] |= 1u << (x & 31);
+            mirrored[mx >> 5] |= 1u << (mx & 31);
+        }
+    }
+
+    return true;
+}
+
+bool overlapMasks(Sprite& a, Sprite& b) {
+    DSGE_PROFILE_ZONE("dsge::_internal::overlapMasks");
+
+    Placement pa, pb;
+    if (!place(a, pa) || !place(b, pb)) {
+        // Rotated pixel hitboxes only get their box.
+        return intersect(a._collider(), b._collider(), nullptr);
+    }
+
+    int x0 = std::max(pa.x, pb.x), x1 = std::min(pa.x + pa.w, pb.x + pb.w);
+    int y0 = std::max(pa.y, pb.y), y1 = std::min(pa.y + pa.h, pb.y + pb.h);
+    if (x0 >= x1 || y0 >= y1) return false;
+
+    // Reused by every test, only grows.
+    static std::vector<u32> rowA, rowB;
+    int count = x1 - x0;
+    int words = (count + 31) >> 5;
+    if ((int)rowA.size() < words) {
+        rowA.resize(words);
+        rowB.resize(words);
+    }
+
+    for (int y = y0; y < y1; y++) {
+        sampleRow(pa, y, x0, count, rowA.data());
+        sampleRow(pb, y, x0, count, rowB.data());
+
+        for (int i = 0; i < words; i++) {
+            if (rowA[i] & rowB[i]) return true;
+        }
+    }
+
+    return false;
+}
+}
+} // namespace dsge
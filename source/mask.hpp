@@ -0,0 +1,36 @@
+#ifndef DSGE_MASK_HPP
+#define DSGE_MASK_HPP
+
+#include <3ds.h>
+#include <citro2d.h>
+#include <vector>
+
+namespace dsge {
+class Sprite;
+
+namespace _internal {
+    /**
+     * 1 bit collision mask of an image, a pixel is solid if it's alpha is at least half.
+     *
+     * Rows are packed 32 pixels per word, bit `i` of word `w` is pixel `w * 32 + i`. Every row is also kept
+     * mirrored, so flipped sprites are tested with the same word shifts as unflipped ones.
+     */
+    struct PixelMask {
+        u16 width, height;
+        u16 words;                 // Words per row.
+        std::vector<u32> bits;     // `height` rows of `words` words.
+        std::vector<u32> mirrored; // The same rows, flipped horizontally.
+
+        const u32* row(int y, bool flipped) const { return (flipped ? mirrored.data() : bits.data()) + y * words; }
+    };
+
+    // Decodes the alpha of a loaded image, every texture format with alpha is supported.
+    bool buildMask(PixelMask& mask, const C2D_Image& image);
+
+    // Pixel test of two sprites where at least one has an unrotated pixel hitbox, their shapes have to overlap
+    // already. The other one is solid inside of it's own shape.
+    bool overlapMasks(Sprite& a, Sprite& b);
+}
+} // namespace dsge
+
+#endif
@@ -0,0 +1,279 @@
+#include "profiler.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+
+namespace {
+    struct Frame {
+        u32 ticks[PHASE_COUNT];
+    };
+
+    Frame frames[dsge::Profiler::FRAMES];
+    frameSpike spikes[dsge::Profiler::SPIKES];
+    float scratch[dsge::Profiler::FRAMES]; // Sorting space for the percentiles.
+
+    Frame current = {};
+    u64 lastMark = 0;
+    u32 frameCount = 0; // Frames recorded, also the next frame number.
+    u32 spikeCount = 0;
+
+    float toMs(u32 ticks) {
+        return ticks / CPU_TICKS_PER_MSEC;
+    }
+
+    int recorded() {
+        return frameCount < (u32)dsge::Profiler::FRAMES ? frameCount : dsge::Profiler::FRAMES;
+    }
+
+    // Zones, every thread gets it's own single producer/single consumer ring.
+    constexpr int MAX_THREADS = 16;
+    constexpr u32 ZONE_EVENTS = 2048;
+
+    enum : u32 {
+        BUFFER_FREE = 0,   // Can be claimed by a new thread.
+        BUFFER_OWNED = 1,  // Written by it's thread.
+        BUFFER_RETIRED = 2 // The thread exited, freed once exported.
+    };
+
+    struct ZoneEvent {
+        const char* name;
+        u64 tick;
+        bool begin;
+    };
+
+    struct ZoneBuffer {
+        std::atomic<u32> state{BUFFER_FREE};
+        std::atomic<u32> head{0}; // Only written by the owning thread.
+        std::atomic<u32> tail{0}; // Only written by the exporter.
+        u32 tid = 0;
+        u32 dropped = 0;
+        const char* name = nullptr;
+        ZoneEvent* events = nullptr;
+    };
+
+    ZoneBuffer zoneBuffers[MAX_THREADS];
+    std::atomic<u32> nextTid{1};
+
+    // Claims a buffer for the thread on it's first zone, and retires it once the thread exits.
+    struct ThreadBuffer {
+        ZoneBuffer* buffer = nullptr;
+        bool failed = false;
+
+        ZoneBuffer* get() {
+            if (buffer || failed) return buffer;
+
+            for (auto &&candidate : zoneBuffers) {
+                u32 expected = BUFFER_FREE;
+                if (candidate.state.compare_exchange_strong(expected, BUFFER_OWNED)) {
+                    if (!candidate.events) {
+                        candidate.events = new ZoneEvent[ZONE_EVENTS];
+                    }
+                    candidate.tid = nextTid++;
+                    candidate.name = nullptr;
+                    buffer = &candidate;
+                    return buffer;
+                }
+            }
+
+            failed = true; // Every buffer is taken, this thread won't be profiled.
+            return nullptr;
+        }
+
+        ~ThreadBuffer() {
+            if (buffer) buffer->state.store(BUFFER_RETIRED);
+        }
+    };
+
+    thread_local ThreadBuffer threadBuffer;
+
+    void pushZone(const char* name, bool begin) {
+        ZoneBuffer* buffer = threadBuffer.get();
+        if (!buffer) return;
+
+        u32 head = buffer->head.load(std::memory_order_relaxed);
+        if (head - buffer->tail.load(std::memory_order_acquire) >= ZONE_EVENTS) {
+            buffer->dropped++;
+            return;
+        }
+
+        buffer->events[head % ZONE_EVENTS] = {name, svcGetSystemTick(), begin};
+        buffer->head.store(head + 1, std::memory_order_release);
+    }
+}
+
+namespace dsge {
+namespace Profiler {
+float spikeThreshold = 20;
+bool showOverlay = false;
+
+void _mark(profilerPhase phase) {
+    u64 now = svcGetSystemTick();
+    if (lastMark != 0) {
+        current.ticks[phase] += now - lastMark;
+    }
+    lastMark = now;
+}
+
+void _endFrame() {
+    u32 total = 0;
+    for (int i = 0; i < PHASE_TOTAL; i++) {
+        total += current.ticks[i];
+    }
+    current.ticks[PHASE_TOTAL] = total;
+
+    if (toMs(total) > spikeThreshold && frameCount != 0) {
+        frameSpike& spike = spikes[spikeCount % SPIKES];
+        spike.frame = frameCount;
+        for (int i = 0; i < PHASE_COUNT; i++) {
+            spike.ms[i] = toMs(current.ticks[i]);
+        }
+        spikeCount++;
+    }
+
+    frames[frameCount % FRAMES] = current;
+    frameCount++;
+    current = {};
+}
+
+phaseStats getStats(profilerPhase phase) {
+    int count = recorded();
+    if (count == 0) return {0, 0, 0, 0, 0};
+
+    float sum = 0;
+    for (int i = 0; i < count; i++) {
+        scratch[i] = toMs(frames[i].ticks[phase]);
+        sum += scratch[i];
+    }
+
+    std::sort(scratch, scratch + count);
+    return {scratch[0], sum / count, scratch[(count - 1) * 95 / 100], scratch[(count - 1) * 99 / 100], scratch[count - 1]};
+}
+
+float getLast(profilerPhase phase) {
+    if (frameCount == 0) return 0;
+    return toMs(frames[(frameCount - 1) % FRAMES].ticks[phase]);
+}
+
+const frameSpike* getSpikes(int& count) {
+    count = spikeCount < (u32)SPIKES ? spikeCount : SPIKES;
+
+    // Rotate so the oldest spike comes first.
+    if (spikeCount > (u32)SPIKES) {
+        std::rotate(spikes, spikes + (spikeCount % SPIKES), spikes + SPIKES);
+        spikeCount = SPIKES;
+    }
+    return spikes;
+}
+
+bool dumpCSV(const std::string& filePath) {
+    FILE* file = fopen(("sdmc:/" + filePath).c_str(), "w");
+    if (!file) {
+        trace("[WARN] Profiler::dumpCSV: Could not save file: sdmc:/" + filePath);
+        return false;
+    }
+
+    fprintf(file, "frame,update,top,debug,bottom,frame_end,total,spike\n");
+
+    int count = recorded();
+    u32 first = frameCount - count;
+    for (u32 f = first; f < frameCount; f++) {
+        const Frame& frame = frames[f % FRAMES];
+        fprintf(file, "%lu", (unsigned long)f);
+        for (int i = 0; i < PHASE_COUNT; i++) {
+            fprintf(file, ",%.3f", toMs(frame.ticks[i]));
+        }
+        fprintf(file, ",%d\n", toMs(frame.ticks[PHASE_TOTAL]) > spikeThreshold ? 1 : 0);
+    }
+
+    fclose(file);
+    return true;
+}
+
+void reset() {
+    frameCount = 0;
+    spikeCount = 0;
+    current = {};
+}
+
+Zone::Zone(const char* name) : name(name) {
+    pushZone(name, true);
+}
+
+Zone::~Zone() {
+    pushZone(name, false);
+}
+
+void _nameThread(const char* name) {
+    ZoneBuffer* buffer = threadBuffer.get();
+    if (buffer) buffer->name = name;
+}
+
+bool exportTrace(const std::string& filePath) {
+    FILE* file = fopen(("sdmc:/" + filePath).c_str(), "w");
+    if (!file) {
+        trace("[WARN] Profiler::exportTrace: Could not save file: sdmc:/" + filePath);
+        return false;
+    }
+
+    fprintf(file, "{\"traceEvents\":[\n");
+    bool first = true;
+
+    for (auto &&buffer : zoneBuffers) {
+        u32 state = buffer.state.load();
+        if (state == BUFFER_FREE) continue;
+
+        fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%lu,\"args\":{\"name\":\"%s\"}}",
+            first ? "" : ",\n", (unsigned long)buffer.tid, buffer.name ? buffer.name : "Thread");
+        first = false;
+
+        u32 head = buffer.head.load(std::memory_order_acquire);
+        for (u32 i = buffer.tail.load(std::memory_order_relaxed); i != head; i++) {
+            const ZoneEvent& event = buffer.events[i % ZONE_EVENTS];
+            fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":0,\"tid\":%lu}",
+                event.name, event.begin ? 'B' : 'E', event.tick / CPU_TICKS_PER_USEC, (unsigned long)buffer.tid);
+        }
+        buffer.tail.store(head, std::memory_order_release);
+
+        if (buffer.dropped != 0) {
+            trace("[WARN] Profiler::exportTrace: " + TSA(buffer.dropped) + " zones dropped on thread " + TSA(buffer.tid));
+            buffer.dropped = 0;
+        }
+
+        // Exited threads give their buffer back once everything's exported.
+        if (state == BUFFER_RETIRED) {
+            buffer.state.store(BUFFER_FREE);
+        }
+    }
+
+    fprintf(file, "\n]}\n");
+    fclose(file);
+    return true;
+}
+
+void _renderOverlay() {
+    if (!showOverlay) return;
+
+    static const u32 colors[PHASE_TOTAL] = {0xC00000FF, 0xC000FF00, 0xC0808080, 0xC0FF0000, 0xC000FFFF};
+    constexpr float SCALE = 2;    // Pixels per millisecond.
+    constexpr float BASE = 236;   // Bottom of the graph.
+    constexpr int   BARS = 132;   // Frames shown, 3 pixels each.
+
+    int count = recorded() < BARS ? recorded() : BARS;
+    for (int bar = 0; bar < count; bar++) {
+        const Frame& frame = frames[(frameCount - count + bar) % FRAMES];
+
+        float y = BASE;
+        for (int i = 0; i < PHASE_TOTAL; i++) {
+            float h = toMs(frame.ticks[i]) * SCALE;
+            if (y - h < BASE - 100) h = y - (BASE - 100);
+            if (h <= 0) continue;
+
+            y -= h;
+            C2D_DrawRectSolid(2 + bar * 3, y, 0, 2, h, colors[i]);
+        }
+    }
+
+    C2D_DrawRectSolid(2, BASE - 16.6f * SCALE, 0, BARS * 3, 1, 0xFFFFFFFF);
+}
+}
+} // namespace dsge
@@ -0,0 +1,186 @@
+#ifndef DSGE_PROFILER_HPP
+#define DSGE_PROFILER_HPP
+
+#include "dsge.hpp"
+#include <string>
+
+typedef enum {
+    PHASE_UPDATE = 0,    // User code between two dsge::render(), then the fixed steps, timers, tweens, sounds and members in it.
+    PHASE_TOP = 1,       // Top screen submission, including the wait for the previous frame.
+    PHASE_DEBUG = 2,     // Debug overlay (trace lines, FPS, profiler graph).
+    PHASE_BOTTOM = 3,    // Bottom screen submission.
+    PHASE_FRAME_END = 4, // C3D_FrameEnd wait.
+    PHASE_TOTAL = 5,     // The whole frame.
+    PHASE_COUNT = 6
+} profilerPhase;
+
+// Duration statistics of a phase over the recorded frames, in milliseconds.
+struct phaseStats {
+    float min;
+    float avg;
+    float p95;
+    float p99;
+    float max;
+};
+
+// A frame that took longer than dsge::Profiler::spikeThreshold.
+struct frameSpike {
+    u32   frame;             // Frame number, counted since dsge::init().
+    float ms[PHASE_COUNT];   // Duration of each phase, in milliseconds.
+};
+
+namespace dsge {
+namespace Profiler {
+/**
+ * @brief Amount of frames kept by the profiler, older frames get overwritten.
+ */
+inline constexpr int FRAMES = 256;
+
+/**
+ * @brief Amount of spikes kept by the profiler, older spikes get overwritten.
+ */
+inline constexpr int SPIKES = 32;
+
+/**
+ * @brief Frames slower than this (in milliseconds) are logged as spikes, 20ms by default.
+ * 
+ * #### Example Usage:
+ * ```
+ * dsge::Profiler::spikeThreshold = 17.5; // Anything missing 60 FPS.
+ * ```
+ */
+extern float spikeThreshold;
+
+/**
+ * @brief Whetever or not to draw the frame time graph on the top screen, only if DEBUG is defined.
+ * 
+ * Every bar is one frame, stacked by phase: update (red), top screen (green), debug (gray), bottom screen (blue) and frame end (yellow). The white line is 16.6ms.
+ * 
+ * #### Example Usage:
+ * ```
+ * dsge::Profiler::showOverlay = true;
+ * ```
+ */
+extern bool showOverlay;
+
+/**
+ * @brief Returns the min/avg/p95/p99/max of a phase over the recorded frames.
+ * @param phase The phase, `PHASE_TOTAL` for the whole frame.
+ * @returns The statistics in milliseconds, all 0 if nothing is recorded yet.
+ * 
+ * #### Example Usage:
+ * ```
+ * phaseStats frame = dsge::Profiler::getStats(PHASE_TOTAL);
+ * trace("p99: " + TSA(frame.p99) + "ms");
+ * ```
+ */
+phaseStats getStats(profilerPhase phase = PHASE_TOTAL);
+
+/**
+ * @brief Returns the duration of a phase in the last frame, in milliseconds.
+ * 
+ * #### Example Usage:
+ * ```
+ * trace(dsge::Profiler::getLast(PHASE_UPDATE)); // How long the game code took.
+ * ```
+ */
+float getLast(profilerPhase phase = PHASE_TOTAL);
+
+/**
+ * @brief Returns the logged spikes, oldest first.
+ * @param count Set to the amount of spikes returned.
+ * 
+ * #### Example Usage:
+ * ```
+ * int count;
+ * const frameSpike* spikes = dsge::Profiler::getSpikes(count);
+ * for (int i = 0; i < count; i++) {
+ *     trace("Frame " + TSA(spikes[i].frame) + ": " + TSA(spikes[i].ms[PHASE_TOTAL]) + "ms");
+ * }
+ * ```
+ */
+const frameSpike* getSpikes(int& count);
+
+/**
+ * @brief Saves every recorded frame and spike as CSV to `sdmc:/`.
+ * @param filePath The path to save as, without `sdmc:/`.
+ * @returns `true` if saved successfully, `false` otherwise.
+ * 
+ * #### Example Usage:
+ * ```
+ * dsge::Profiler::dumpCSV("dsge_profile.csv");
+ * ```
+ */
+bool dumpCSV(const std::string& filePath = "dsge_profile.csv");
+
+/**
+ * @brief Clears every recorded frame and spike.
+ */
+void reset();
+
+/**
+ * @brief Saves every recorded profiling zone as a Chrome trace to `sdmc:/`, only if DSGE_PROFILE is defined.
+ * @param filePath The path to save as, without `sdmc:/`.
+ * @returns `true` if saved successfully, `false` otherwise.
+ * 
+ * The file can be opened with `chrome://tracing` or https://ui.perfetto.dev on a PC. Saved zones are removed from the buffers, so every export only has the new ones.
+ * 
+ * #### Example Usage:
+ * ```
+ * void spawnWave() {
+ *     DSGE_PROFILE_ZONE("spawnWave");
+ *     // ...
+ * }
+ * 
+ * if (dsge::Input::isDown(KEY_SELECT)) {
+ *     dsge::Profiler::exportTrace("dsge_trace.json");
+ * }
+ * ```
+ */
+bool exportTrace(const std::string& filePath = "dsge_trace.json");
+
+/**
+ * Records the begin and end ticks of a zone, use DSGE_PROFILE_ZONE instead.
+ * 
+ * Every thread writes into it's own lock-free ring buffer, zones are dropped if it's full.
+ */
+class Zone {
+public:
+    Zone(const char* name);
+    ~Zone();
+
+private:
+    const char* name;
+};
+
+void _nameThread(const char* name);
+void _mark(profilerPhase phase);
+void _endFrame();
+void _renderOverlay();
+}
+} // namespace dsge
+
+/**
+ * Profiles the rest of the scope as a zone, the name has to be a string literal.
+ * 
+ * Zones are only recorded if DSGE_PROFILE is defined, they compile to nothing otherwise.
+ * 
+ * #### Example Usage:
+ * ```
+ * void updateEnemies() {
+ *     DSGE_PROFILE_ZONE("updateEnemies");
+ *     // ...
+ * }
+ * ```
+ */
+#if defined(DSGE_PROFILE)
+    #define DSGE_PROFILE_CONCAT_(a, b) a##b
+    #define DSGE_PROFILE_CONCAT(a, b) DSGE_PROFILE_CONCAT_(a, b)
+    #define DSGE_PROFILE_ZONE(name) dsge::Profiler::Zone DSGE_PROFILE_CONCAT(_dsgeZone, __LINE__)(name)
+    #define DSGE_PROFILE_THREAD(name) dsge::Profiler::_nameThread(name)
+#else
+    #define DSGE_PROFILE_ZONE(name) ((void)0)
+    #define DSGE_PROFILE_THREAD(name) ((void)0)
+#endif
+
+#endif
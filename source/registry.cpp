@@ -0,0 +1,66 @@
+#include "registry.hpp"
+
+namespace dsge {
+namespace _internal {
+Registry& members() {
+    // Never freed so sprites and texts destroyed after main() can still unregister themselves.
+    static Registry* registry = new Registry();
+    return *registry;
+}
+
+MemberHandle Registry::add(memberType type, void* object) {
+    u32 index;
+    if (!freeSlots.empty()) {
+        index = freeSlots.back();
+        freeSlots.pop_back();
+    } else {
+        index = slots.size();
+        slots.push_back({0, 1});
+    }
+
+    Slot& slot = slots[index];
+    slot.dense = dense.size();
+
+    MemberHandle handle = {index, slot.generation};
+    dense.push_back({type, object, handle, false});
+    return handle;
+}
+
+bool Registry::isValid(MemberHandle handle) const {
+    return handle.generation != 0 && handle.index < slots.size() && slots[handle.index].generation == handle.generation;
+}
+
+bool Registry::remove(MemberHandle handle) {
+    if (!isValid(handle)) return false;
+
+    Slot& slot = slots[handle.index];
+    Member& member = dense[slot.dense];
+    member.removed = true;
+    member.object = nullptr;
+    pending++;
+
+    // Bump the generation so every copy of this handle is stale from now on, 0 is skipped since it's never valid.
+    if (++slot.generation == 0) slot.generation = 1;
+    freeSlots.push_back(handle.index);
+    return true;
+}
+
+void Registry::compact() {
+    if (pending == 0) return;
+
+    size_t out = 0;
+    for (size_t i = 0; i < dense.size(); i++) {
+        if (dense[i].removed) continue;
+
+        if (out != i) {
+            dense[out] = dense[i];
+        }
+        slots[dense[out].handle.index].dense = out;
+        out++;
+    }
+
+    dense.resize(out);
+    pending = 0;
+}
+}
+} // namespace dsge
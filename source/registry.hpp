@@ -0,0 +1,76 @@
+#ifndef DSGE_REGISTRY_HPP
+#define DSGE_REGISTRY_HPP
+
+#include <3ds.h>
+#include <vector>
+
+namespace dsge {
+/**
+ * @brief A handle to a sprite or text added with `dsge::add()`.
+ * 
+ * Handles are generational, once the member is removed (or destroyed) the handle becomes stale and will never point to another member, even if it's slot gets reused.
+ * 
+ * #### Example Usage:
+ * ```
+ * dsge::Sprite bullet(0, 0);
+ * bullet.makeGraphic(4, 4);
+ * dsge::MemberHandle handle = dsge::add(bullet);
+ * 
+ * dsge::remove(handle);
+ * dsge::isValid(handle); // Returns false, the handle is stale now.
+ * ```
+ */
+struct MemberHandle {
+    u32 index = 0;      // Slot index in the registry.
+    u32 generation = 0; // Generation of the slot, 0 is never valid.
+
+    bool operator==(const MemberHandle& other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const MemberHandle& other) const { return !(*this == other); }
+};
+
+namespace _internal {
+    typedef enum {
+        MEMBER_SPRITE = 0,
+        MEMBER_TEXT = 1,
+        MEMBER_ENTITIES = 2
+    } memberType;
+
+    struct Member {
+        memberType type;
+        void* object;   // Sprite*, Text* or EntityStore*, depending on the type.
+        MemberHandle handle;
+        bool removed;   // Removed members are skipped and compacted at the end of the frame.
+    };
+
+    /**
+     * Slot map of every member added for rendering.
+     * 
+     * Removing is O(1), it only marks the member and bumps it's slot generation, the dense list is then compacted once at the end of the frame (keeping the insertion order).
+     */
+    class Registry {
+    public:
+        MemberHandle add(memberType type, void* object);
+        bool remove(MemberHandle handle);
+        bool isValid(MemberHandle handle) const;
+        void compact();
+
+        std::vector<Member>& list() { return dense; }
+        size_t size() const { return dense.size() - pending; }
+
+    private:
+        struct Slot {
+            u32 dense;      // Index in the dense list.
+            u32 generation; // Bumped on every removal.
+        };
+
+        std::vector<Slot> slots;
+        std::vector<u32> freeSlots;
+        std::vector<Member> dense;
+        size_t pending = 0; // Removed members not compacted yet.
+    };
+
+    Registry& members();
+}
+} // namespace dsge
+
+#endif
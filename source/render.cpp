@@ -0,0 +1,88 @@
+#include "render.hpp"
+#include "dsge.hpp"
+#include <algorithm>
+
+namespace {
+    // Bit layout of the sort key, from the highest bits to the lowest.
+    constexpr int SCREEN_SHIFT  = 63; // 1 bit
+    constexpr int LAYER_SHIFT   = 55; // 8 bits
+    constexpr int Z_SHIFT       = 39; // 16 bits
+    constexpr int PRIM_SHIFT    = 37; // 2 bits
+    constexpr int TEXTURE_SHIFT = 21; // 16 bits
+    constexpr u64 ORDER_MASK    = (1ull << TEXTURE_SHIFT) - 1;
+
+    // The texture and primitive bits, anything that breaks a batch when it changes.
+    constexpr u64 STATE_MASK = ((1ull << (Z_SHIFT - TEXTURE_SHIFT)) - 1) << TEXTURE_SHIFT;
+}
+
+namespace dsge {
+namespace _internal {
+RenderQueue& renderQueue() {
+    static RenderQueue queue;
+    return queue;
+}
+
+u64 RenderQueue::makeKey(bool bottom, int layer, int z, primitiveType type, const void* texture, u32 order) {
+    u64 l = std::clamp(layer, 0, 255);
+    u64 zz = std::clamp(z, -32768, 32767) + 32768;
+
+    // Only used to group the same textures together, a collision just costs a batch.
+    u64 tex = ((uintptr_t)texture >> 4) & 0xFFFF;
+
+    return ((u64)bottom << SCREEN_SHIFT)
+         | (l << LAYER_SHIFT)
+         | (zz << Z_SHIFT)
+         | ((u64)type << PRIM_SHIFT)
+         | (tex << TEXTURE_SHIFT)
+         | (order & ORDER_MASK);
+}
+
+void RenderQueue::push(bool bottom, int layer, int z, primitiveType type, const void* texture, void* object) {
+    items.push_back({makeKey(bottom, layer, z, type, texture, items.size()), object});
+}
+
+void RenderQueue::sort() {
+    std::sort(items.begin(), items.end(), [](const DrawItem& a, const DrawItem& b) {
+        return a.key < b.key;
+    });
+}
+
+void RenderQueue::flush(bool bottom) {
+    DSGE_PROFILE_ZONE("RenderQueue::flush");
+
+    u64 lastState = ~0ull;
+
+    for (auto &&item : items) {
+        if ((item.key >> SCREEN_SHIFT) != (u64)bottom) continue;
+
+        u64 state = item.key & STATE_MASK;
+        if (state != lastState) {
+            renderStats.batches++;
+            lastState = state;
+        }
+
+        switch ((primitiveType)((item.key >> PRIM_SHIFT) & 3)) {
+            case PRIM_TEXT:
+                renderStats.items++;
+
+                // Rotated or flipped texts change the view matrix, which always flushes the batch.
+                if (static_cast<Text*>(item.object)->_draw()) {
+                    lastState = ~0ull;
+                }
+                break;
+            case PRIM_ENTITIES:
+                renderStats.items += static_cast<EntityStore*>(item.object)->_draw();
+                break;
+            default:
+                renderStats.items++;
+                static_cast<Sprite*>(item.object)->_draw();
+                break;
+        }
+    }
+}
+
+void RenderQueue::clear() {
+    items.clear();
+}
+}
+} // namespace dsge
@@ -0,0 +1,51 @@
+#ifndef DSGE_RENDER_HPP
+#define DSGE_RENDER_HPP
+
+#include <3ds.h>
+#include <vector>
+
+// Draw counters of the last frame, see dsge::renderStats.
+struct drawStats {
+    u32 items;   // Sprites, texts and entities drawn by the render queue.
+    u32 batches; // Consecutive runs of the same texture/primitive, roughly the amount of GPU draw calls.
+};
+
+namespace dsge {
+namespace _internal {
+    typedef enum {
+        PRIM_RECT = 0,    // Solid color sprite
+        PRIM_IMAGE = 1,   // Sprite with a loaded graphic
+        PRIM_TEXT = 2,    // Text
+        PRIM_ENTITIES = 3 // A whole EntityStore
+    } primitiveType;
+
+    struct DrawItem {
+        u64 key;       // Sort key, see RenderQueue::makeKey.
+        void* object;  // Sprite*, Text* or EntityStore*, depending on the primitive type.
+    };
+
+    /**
+     * Collects every visible member for the frame, sorts them once and draws them per screen.
+     * 
+     * The 64 bit sort key is made of (from the highest bits): screen, layer, z, primitive type, texture/font and the submit order.
+     * 
+     * The submit order makes the sort stable, so members with the same key are drawn in the order they've been added.
+     */
+    class RenderQueue {
+    public:
+        void push(bool bottom, int layer, int z, primitiveType type, const void* texture, void* object);
+        void sort();
+        void flush(bool bottom);
+        void clear();
+
+        static u64 makeKey(bool bottom, int layer, int z, primitiveType type, const void* texture, u32 order);
+
+    private:
+        std::vector<DrawItem> items;
+    };
+
+    RenderQueue& renderQueue();
+}
+} // namespace dsge
+
+#endif
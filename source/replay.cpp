@@ -0,0 +1,346 @@
+#include "replay.hpp"
+#include "dsge.hpp"
+#include <atomic>
+#include <cstdio>
+
+namespace {
+    // File layout: "DSGR", version, 3 unused bytes, seed (little endian) and then one record per frame.
+    // A record is a byte of FRAME_* flags, the frame time in system ticks as a varint and then only the fields that changed.
+    constexpr u8 MAGIC[4] = {'D', 'S', 'G', 'R'};
+    constexpr u8 VERSION = 1;
+    constexpr size_t HEADER_SIZE = 12;
+    constexpr size_t FLUSH_SIZE = 16 * 1024; // Recorded frames are handed to the writer thread in chunks of about this size.
+
+    enum : u8 {
+        FRAME_HELD = 1,   // u32 held keys follow.
+        FRAME_TOUCH = 2,  // u16 x and y follow.
+        FRAME_CIRCLE = 4  // s16 x and y follow.
+    };
+
+    struct {
+        replayMode mode = REPLAY_OFF;
+        bool fastForward = false;
+        u32 seed = 0;
+        replayStats stats = {};
+
+        FILE* file = nullptr;
+        std::vector<u8> data; // Frames not written yet, or the whole file while playing.
+        size_t read = 0;
+
+        // Last frame written or read, only changes are stored.
+        u32 held = 0;
+        touchPosition touch = {0, 0};
+        circlePosition circle = {0, 0};
+        u64 delta = 0;        // Time of the frame being recorded.
+        bool pending = false; // A frame has been read, it's input isn't used yet.
+        u64 lastTick = 0;     // Real time of the last played frame.
+
+        // Frame clock used while recording or playing, so timers see the recorded time.
+        u64 clockBase = 0;    // Milliseconds when it started.
+        u64 clockTicks = 0;   // Frame time since then.
+        s64 clockOffset = 0;  // Added to osGetTime() afterwards, so the clock never jumps.
+    } replay;
+
+    // Writes the recorded chunks out, so the game never waits on the SD card.
+    struct {
+        Thread thread = nullptr;
+        LightEvent wake;
+        std::vector<u8> chunk;            // Only touched by the writer thread while `busy`.
+        std::atomic<bool> busy{false};
+        std::atomic<bool> failed{false};
+        std::atomic<bool> quit{false};
+    } writer;
+
+    void writerMain(void*) {
+        DSGE_PROFILE_THREAD("Replay");
+
+        while (true) {
+            LightEvent_Wait(&writer.wake);
+
+            if (writer.busy.load(std::memory_order_acquire)) {
+                if (fwrite(writer.chunk.data(), 1, writer.chunk.size(), replay.file) != writer.chunk.size()) writer.failed = true;
+                writer.chunk.clear();
+                writer.busy.store(false, std::memory_order_release);
+            }
+
+            if (writer.quit.load()) break;
+        }
+    }
+
+    bool startWriter() {
+        writer.busy = false;
+        writer.failed = false;
+        writer.quit = false;
+        LightEvent_Init(&writer.wake, RESET_ONESHOT);
+
+        // Lowest priority like the log's file sink, it only runs while the game waits for the screen.
+        writer.thread = threadCreate(writerMain, nullptr, 8 * 1024, 0x3F, -2, false);
+        return writer.thread != nullptr;
+    }
+
+    // Waits for the chunk being written, if any.
+    void stopWriter() {
+        if (!writer.thread) return;
+
+        writer.quit = true;
+        LightEvent_Signal(&writer.wake);
+        threadJoin(writer.thread, UINT64_MAX);
+        threadFree(writer.thread);
+        writer.thread = nullptr;
+    }
+
+    // Swapped, so both buffers keep their capacity and recording doesn't allocate once they're big enough.
+    void handOff() {
+        if (writer.busy.load(std::memory_order_acquire)) return; // Still writing the last one, this one keeps growing.
+
+        writer.chunk.swap(replay.data);
+        writer.busy.store(true, std::memory_order_release);
+        LightEvent_Signal(&writer.wake);
+    }
+
+    void putBytes(const void* bytes, size_t size) {
+        const u8* b = (const u8*)bytes;
+        replay.data.insert(replay.data.end(), b, b + size);
+    }
+
+    void putVarint(u64 value) {
+        do {
+            u8 byte = value & 0x7F;
+            value >>= 7;
+            replay.data.push_back(byte | (value != 0 ? 0x80 : 0));
+        } while (value != 0);
+    }
+
+    bool getBytes(void* bytes, size_t size) {
+        if (replay.read + size > replay.data.size()) return false;
+        memcpy(bytes, replay.data.data() + replay.read, size);
+        replay.read += size;
+        return true;
+    }
+
+    bool getVarint(u64& value) {
+        value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (replay.read >= replay.data.size()) return false;
+
+            u8 byte = replay.data[replay.read++];
+            value |= (u64)(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return true;
+        }
+        return false;
+    }
+
+    // Only once the writer thread is stopped.
+    bool flush() {
+        if (replay.data.empty()) return true;
+
+        bool ok = fwrite(replay.data.data(), 1, replay.data.size(), replay.file) == replay.data.size();
+        replay.data.clear();
+        return ok;
+    }
+
+    // Both modes start the same way, so a replay starts from the same state as it's recording.
+    void begin(replayMode mode, u32 seed) {
+        replay.clockBase = dsge::Replay::_clockMs();
+        replay.clockTicks = 0;
+        replay.mode = mode;
+        replay.seed = seed;
+        replay.stats = {};
+        replay.held = 0;
+        replay.touch = {0, 0};
+        replay.circle = {0, 0};
+        replay.pending = false;
+
+        srand(seed);
+        dsge::Loop::_resync();
+    }
+}
+
+namespace dsge {
+namespace Replay {
+bool record(const std::string& filePath, u32 seed) {
+    stop();
+
+    replay.file = fopen(("sdmc:/" + filePath).c_str(), "wb");
+    if (!replay.file) {
+        trace("[WARN] Replay::record: Could not open file: sdmc:/" + filePath);
+        return false;
+    }
+
+    if (seed == 0) {
+        u64 tick = svcGetSystemTick();
+        seed = (u32)(tick ^ (tick >> 32));
+        if (seed == 0) seed = 1;
+    }
+
+    u8 header[HEADER_SIZE] = {
+        MAGIC[0], MAGIC[1], MAGIC[2], MAGIC[3], VERSION, 0, 0, 0,
+        (u8)seed, (u8)(seed >> 8), (u8)(seed >> 16), (u8)(seed >> 24)
+    };
+
+    if (!startWriter()) {
+        trace("[WARN] Replay::record: Could not start the writer thread!");
+        fclose(replay.file);
+        replay.file = nullptr;
+        return false;
+    }
+
+    replay.data.clear();
+    putBytes(header, sizeof(header));
+
+    replay.fastForward = false;
+    begin(REPLAY_RECORDING, seed);
+    return true;
+}
+
+bool play(const std::string& filePath, bool fastForward) {
+    stop();
+
+    FILE* file = fopen(("sdmc:/" + filePath).c_str(), "rb");
+    if (!file) {
+        trace("[WARN] Replay::play: Could not open file: sdmc:/" + filePath);
+        return false;
+    }
+
+    // Read all at once, playing back shouldn't wait on the SD card.
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    replay.data.resize(size > 0 ? size : 0);
+    bool ok = size >= (long)HEADER_SIZE && fread(replay.data.data(), 1, size, file) == (size_t)size;
+    fclose(file);
+
+    if (!ok || memcmp(replay.data.data(), MAGIC, sizeof(MAGIC)) != 0 || replay.data[4] != VERSION) {
+        trace("[WARN] Replay::play: Not a valid recording: sdmc:/" + filePath);
+        replay.data.clear();
+        return false;
+    }
+
+    const u8* s = replay.data.data() + 8;
+    u32 seed = s[0] | (s[1] << 8) | (s[2] << 16) | ((u32)s[3] << 24);
+
+    replay.read = HEADER_SIZE;
+    replay.fastForward = fastForward;
+    replay.lastTick = svcGetSystemTick();
+    begin(REPLAY_PLAYING, seed);
+    return true;
+}
+
+void stop() {
+    if (replay.mode == REPLAY_OFF) return;
+
+    // Keeps going from the frame clock, timers would jump otherwise.
+    u64 now = _clockMs();
+    if (replay.mode == REPLAY_RECORDING) {
+        stopWriter();
+        if (writer.failed.exchange(false) | !flush()) trace("[WARN] Replay::stop: Could not write the whole recording!");
+        fclose(replay.file);
+        replay.file = nullptr;
+    }
+
+    replay.data.clear();
+    replay.data.shrink_to_fit();
+    writer.chunk.clear();
+    writer.chunk.shrink_to_fit();
+    replay.mode = REPLAY_OFF;
+    replay.fastForward = false;
+    replay.clockOffset = (s64)now - (s64)osGetTime();
+}
+
+replayMode mode() {
+    return replay.mode;
+}
+
+bool isFastForward() {
+    return replay.fastForward;
+}
+
+u32 seed() {
+    return replay.seed;
+}
+
+const replayStats& stats() {
+    return replay.stats;
+}
+
+u64 _frameDelta(u64 ticks) {
+    if (replay.mode == REPLAY_RECORDING) {
+        replay.delta = ticks;
+        replay.clockTicks += ticks;
+        return ticks;
+    }
+
+    if (replay.mode != REPLAY_PLAYING) return ticks;
+
+    u8 flags;
+    u64 delta;
+    bool ok = getBytes(&flags, 1) && getVarint(delta);
+    if (ok && (flags & FRAME_HELD)) ok = getBytes(&replay.held, 4);
+    if (ok && (flags & FRAME_TOUCH)) ok = getBytes(&replay.touch, 4);
+    if (ok && (flags & FRAME_CIRCLE)) ok = getBytes(&replay.circle, 4);
+
+    if (!ok) {
+        replayStats& s = replay.stats;
+        trace("Replay::play: Done, " + TSA(s.frames) + " frames in " + TSA(s.seconds) + "s (recorded in " + TSA(s.recordedSeconds) + "s), worst frame " + TSA(s.worstFrame) + "ms");
+        stop();
+        return ticks;
+    }
+
+    u64 now = svcGetSystemTick();
+    float real = (float)((double)(now - replay.lastTick) / SYSCLOCK_ARM11);
+    replay.lastTick = now;
+
+    replay.stats.frames++;
+    replay.stats.seconds += real;
+    replay.stats.recordedSeconds += (float)((double)delta / SYSCLOCK_ARM11);
+    if (real * 1000 > replay.stats.worstFrame) replay.stats.worstFrame = real * 1000;
+
+    replay.clockTicks += delta;
+    replay.pending = true;
+    return delta;
+}
+
+bool _readInput(inputState& state) {
+    if (replay.mode != REPLAY_PLAYING || !replay.pending) return false;
+
+    state.held = replay.held;
+    state.touch = replay.touch;
+    state.circle = replay.circle;
+    replay.pending = false;
+    return true;
+}
+
+void _writeInput(const inputState& state) {
+    if (replay.mode != REPLAY_RECORDING) return;
+
+    u8 flags = 0;
+    if (state.held != replay.held) flags |= FRAME_HELD;
+    if (state.touch.px != replay.touch.px || state.touch.py != replay.touch.py) flags |= FRAME_TOUCH;
+    if (state.circle.dx != replay.circle.dx || state.circle.dy != replay.circle.dy) flags |= FRAME_CIRCLE;
+
+    replay.data.push_back(flags);
+    putVarint(replay.delta);
+    if (flags & FRAME_HELD) putBytes(&state.held, 4);
+    if (flags & FRAME_TOUCH) putBytes(&state.touch, 4);
+    if (flags & FRAME_CIRCLE) putBytes(&state.circle, 4);
+
+    replay.held = state.held;
+    replay.touch = state.touch;
+    replay.circle = state.circle;
+
+    if (writer.failed.exchange(false)) {
+        trace("[WARN] Replay::record: Could not write to the recording, stopped recording!");
+        stop();
+        return;
+    }
+
+    if (replay.data.size() >= FLUSH_SIZE) handOff();
+}
+
+u64 _clockMs() {
+    if (replay.mode == REPLAY_OFF) return osGetTime() + replay.clockOffset;
+    return replay.clockBase + replay.clockTicks * 1000 / SYSCLOCK_ARM11;
+}
+} // namespace Replay
+} // namespace dsge
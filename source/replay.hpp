@@ -0,0 +1,114 @@
+#ifndef DSGE_REPLAY_HPP
+#define DSGE_REPLAY_HPP
+
+#include <3ds.h>
+#include <string>
+
+typedef enum {
+    REPLAY_OFF = 0,       // Live input.
+    REPLAY_RECORDING = 1, // Live input, written to a file every frame.
+    REPLAY_PLAYING = 2    // Input and frame times read back from a file.
+} replayMode;
+
+// Counters of the current or last replay, see dsge::Replay::stats().
+struct replayStats {
+    u32   frames;          // Frames played back so far.
+    float seconds;         // Real time it took to play them.
+    float recordedSeconds; // Time they took when they got recorded.
+    float worstFrame;      // Slowest frame while playing back, in milliseconds.
+};
+
+namespace dsge {
+struct inputState;
+
+namespace Replay {
+
+/**
+ * @brief Starts writing the input of every frame to a file, so the session can be played back exactly with `Replay::play()`.
+ * @param filePath Path of the file in the SD card, without `sdmc:/`.
+ * @param seed Seed for `dsge::Random`, 0 picks one. It's saved in the file and set right away.
+ * @return `true` if the file could be opened.
+ *
+ * #### Details:
+ *
+ * Every frame stores the time it took and whatever changed in the buttons, touch screen and circle pad, 5 bytes for
+ * a frame where nothing changed. While recording or playing back, `dsge::deltaTime`, `dsge::Loop` and `dsge::Timer`
+ * are driven by the recorded frame times instead of the real clock, so the game runs the same both times.
+ *
+ * Start recording at a point the game can get back to, like right after loading a level, and play it back from the
+ * same point. The file is closed with `Replay::stop()` or `dsge::exit()`.
+ *
+ * #### Example Usage:
+ * ```
+ * loadLevel(1);
+ * dsge::Replay::record("level1.dsgr");
+ *
+ * while (dsge::render()) {
+ *     if (dsge::Input::isDown(KEY_START)) break;
+ * }
+ *
+ * dsge::Replay::stop();
+ * ```
+ */
+bool record(const std::string& filePath, u32 seed = 0);
+
+/**
+ * @brief Plays back a file from `Replay::record()`, input from the 3DS is ignored until it's done.
+ * @param filePath Path of the file in the SD card, without `sdmc:/`.
+ * @param fastForward Skips drawing and doesn't wait for the screen, so the game updates as fast as it can.
+ * @return `true` if the file could be opened and is a valid recording.
+ *
+ * #### Details:
+ *
+ * The recorded seed is given to `dsge::Random` and every frame gets the recorded input and frame time. Once the
+ * file ends it goes back to live input, `Replay::stats()` then tells how long it took.
+ *
+ * Fast forwarding a recorded session runs the exact same updates every time, which makes it a repeatable benchmark.
+ *
+ * #### Example Usage:
+ * ```
+ * loadLevel(1);
+ * dsge::Replay::play("level1.dsgr", true);
+ *
+ * while (dsge::render() && dsge::Replay::mode() == REPLAY_PLAYING) {}
+ *
+ * const replayStats& s = dsge::Replay::stats();
+ * trace(TSA(s.frames / s.seconds) + " FPS, worst frame " + TSA(s.worstFrame) + " ms");
+ * ```
+ */
+bool play(const std::string& filePath, bool fastForward = false);
+
+/**
+ * @brief Stops recording or playing back, a recording is written out and closed.
+ */
+void stop();
+
+/**
+ * @brief Whetever it's recording, playing back or neither.
+ */
+replayMode mode();
+
+/**
+ * @brief Checks if a replay is being played back without drawing, see `Replay::play()`.
+ */
+bool isFastForward();
+
+/**
+ * @brief The seed of the current or last recording or replay.
+ */
+u32 seed();
+
+/**
+ * @brief Counters of the current or last replay.
+ */
+const replayStats& stats();
+
+u64 _frameDelta(u64 ticks);
+bool _readInput(inputState& state);
+void _writeInput(const inputState& state);
+u64 _clockMs();
+
+} // namespace Replay
+} // namespace dsge
+
+#endif
@@ -0,0 +1,237 @@
+#include "shape.hpp"
+#include <algorithm>
+#include <math.h>
+
+namespace {
+    using dsge::_internal::Collider;
+
+    // Half of the width of a collider along the axis (nx, ny), which has to be normalized.
+    float extent(const Collider& c, float nx, float ny) {
+        switch (c.shape.type) {
+            case SHAPE_BOX:     return c.hx * fabsf(c.ux * nx + c.uy * ny) + c.hy * fabsf(c.ux * ny - c.uy * nx);
+            case SHAPE_CAPSULE: return c.hx * fabsf(c.ux * nx + c.uy * ny) + c.radius;
+            default:            return c.radius;
+        }
+    }
+
+    // Closest point to (px, py) on the part of a collider without the radius: the center of a circle,
+    // the segment of a capsule or the whole area of a box.
+    void closestOnCore(const Collider& c, float px, float py, float& qx, float& qy) {
+        float dx = px - c.cx;
+        float dy = py - c.cy;
+        float along = std::clamp(dx * c.ux + dy * c.uy, -c.hx, c.hx);
+
+        switch (c.shape.type) {
+            case SHAPE_BOX: {
+                float side = std::clamp(dy * c.ux - dx * c.uy, -c.hy, c.hy);
+                qx = c.cx + c.ux * along - c.uy * side;
+                qy = c.cy + c.uy * along + c.ux * side;
+                break;
+            }
+            case SHAPE_CAPSULE:
+                qx = c.cx + c.ux * along;
+                qy = c.cy + c.uy * along;
+                break;
+            default:
+                qx = c.cx;
+                qy = c.cy;
+                break;
+        }
+    }
+
+    // Closest points between the segments of two capsules.
+    void closestSegments(const Collider& a, const Collider& b, float& px, float& py, float& qx, float& qy) {
+        float rx = a.cx - b.cx, ry = a.cy - b.cy;
+        float d = a.ux * b.ux + a.uy * b.uy; // Both directions are normalized.
+        float e = a.ux * rx + a.uy * ry;
+        float f = b.ux * rx + b.uy * ry;
+
+        // Parameters from the centers, in [-h, h].
+        float denom = 1 - d * d;
+        float s = denom > 1e-6f ? std::clamp((d * f - e) / denom, -a.hx, a.hx) : 0;
+        float t = std::clamp(d * s + f, -b.hx, b.hx);
+        s = std::clamp(d * t - e, -a.hx, a.hx);
+
+        px = a.cx + a.ux * s;
+        py = a.cy + a.uy * s;
+        qx = b.cx + b.ux * t;
+        qy = b.cy + b.uy * t;
+    }
+
+    struct AxisList {
+        float x[8], y[8];
+        int count = 0;
+
+        void add(float ax, float ay) {
+            float len = sqrtf(ax * ax + ay * ay);
+            if (len < 1e-6f || count == 8) return;
+            x[count] = ax / len;
+            y[count] = ay / len;
+            count++;
+        }
+    };
+
+    // Axes from the round parts of `r` to the closest point of `o`, only needed if `r` has any.
+    void roundAxes(const Collider& r, const Collider& o, AxisList& axes) {
+        float px, py, qx, qy;
+
+        if (r.shape.type == SHAPE_CIRCLE) {
+            closestOnCore(o, r.cx, r.cy, qx, qy);
+            axes.add(r.cx - qx, r.cy - qy);
+        } else if (r.shape.type == SHAPE_CAPSULE) {
+            if (o.shape.type == SHAPE_CAPSULE) {
+                closestSegments(r, o, px, py, qx, qy);
+                axes.add(px - qx, py - qy);
+            } else if (o.shape.type == SHAPE_BOX) {
+                for (float end : {-r.hx, r.hx}) {
+                    px = r.cx + r.ux * end;
+                    py = r.cy + r.uy * end;
+                    closestOnCore(o, px, py, qx, qy);
+                    axes.add(px - qx, py - qy);
+                }
+            }
+            // Against a circle, the circle adds the axis.
+        }
+    }
+
+    void faceAxes(const Collider& c, AxisList& axes) {
+        if (c.shape.type == SHAPE_BOX) {
+            axes.add(c.ux, c.uy);
+            axes.add(-c.uy, c.ux);
+        } else if (c.shape.type == SHAPE_CAPSULE) {
+            axes.add(-c.uy, c.ux);
+        }
+    }
+}
+
+namespace dsge {
+namespace _internal {
+Collider::Collider() :
+    shape(Shape::box(0, 0)),
+    enabled(false),
+    pixels(false),
+    cx(0), cy(0),
+    ux(1), uy(0),
+    hx(0), hy(0),
+    radius(0),
+    bounds{0, 0, 0, 0},
+    valid(false),
+    version(0),
+    angle(0)
+{}
+
+Collider::Collider(const Collider& other) : Collider() {
+    shape = other.shape;
+    enabled = other.enabled;
+    pixels = other.pixels;
+}
+
+Collider& Collider::operator=(const Collider& other) {
+    // Placed again by the new owner.
+    shape = other.shape;
+    enabled = other.enabled;
+    pixels = other.pixels;
+    valid = false;
+    return *this;
+}
+
+void Collider::set(const Shape& shape) {
+    this->shape = shape;
+    pixels = shape.type == SHAPE_PIXELS;
+    if (pixels) this->shape.type = SHAPE_BOX; // Sized by the owner.
+    enabled = true;
+    valid = false;
+}
+
+void Collider::update(const Transform& t, float originX, float originY) {
+    if (valid && version == t.version) return;
+
+    if (!valid || angle != t.worldAngle) {
+        angle = t.worldAngle;
+        ux = cosf(angle);
+        uy = sinf(angle);
+    }
+
+    t.world.apply(originX + shape.x, originY + shape.y, cx, cy);
+
+    float sx = fabsf(t.worldScaleX);
+    float sy = fabsf(t.worldScaleY);
+    float ex, ey;
+
+    switch (shape.type) {
+        case SHAPE_BOX:
+            hx = shape.width * sx / 2;
+            hy = shape.height * sy / 2;
+            radius = 0;
+            ex = hx * fabsf(ux) + hy * fabsf(uy);
+            ey = hx * fabsf(uy) + hy * fabsf(ux);
+            break;
+        case SHAPE_CAPSULE:
+            hx = shape.length * sx / 2;
+            hy = 0;
+            radius = shape.radius * sy;
+            ex = hx * fabsf(ux) + radius;
+            ey = hx * fabsf(uy) + radius;
+            break;
+        default:
+            hx = hy = 0;
+            radius = shape.radius * fmaxf(sx, sy);
+            ex = ey = radius;
+            break;
+    }
+
+    bounds = {cx - ex, cy - ey, cx + ex, cy + ey};
+    version = t.version;
+    valid = true;
+}
+
+void Collider::fromBounds(const Bounds& b) {
+    shape.type = SHAPE_BOX;
+    cx = (b.left + b.right) / 2;
+    cy = (b.top + b.bottom) / 2;
+    ux = 1;
+    uy = 0;
+    hx = (b.right - b.left) / 2;
+    hy = (b.bottom - b.top) / 2;
+    radius = 0;
+    bounds = b;
+    valid = false;
+}
+
+bool intersect(const Collider& a, const Collider& b, Penetration* out) {
+    // Cheap box test first, most pairs stop here.
+    if (!(a.bounds.left < b.bounds.right && a.bounds.right > b.bounds.left && a.bounds.top < b.bounds.bottom && a.bounds.bottom > b.bounds.top)) {
+        return false;
+    }
+
+    AxisList axes;
+    faceAxes(a, axes);
+    faceAxes(b, axes);
+    roundAxes(a, b, axes);
+    roundAxes(b, a, axes);
+    if (axes.count == 0) axes.add(0, -1); // Both are circles with the same center.
+
+    float best = INFINITY, bestX = 0, bestY = 0;
+    for (int i = 0; i < axes.count; i++) {
+        float nx = axes.x[i], ny = axes.y[i];
+        float ca = a.cx * nx + a.cy * ny, ea = extent(a, nx, ny);
+        float cb = b.cx * nx + b.cy * ny, eb = extent(b, nx, ny);
+
+        // How far a has to move along the axis, forwards or backwards, to get out of b.
+        float forward = (cb + eb) - (ca - ea);
+        float backward = (ca + ea) - (cb - eb);
+        if (forward <= 0 || backward <= 0) return false; // Separating axis.
+
+        float depth = fminf(forward, backward);
+        if (depth < best) {
+            best = depth;
+            bestX = forward < backward ? nx : -nx;
+            bestY = forward < backward ? ny : -ny;
+        }
+    }
+
+    if (out) *out = {bestX * best, bestY * best, best};
+    return true;
+}
+}
+} // namespace dsge
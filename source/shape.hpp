@@ -0,0 +1,91 @@
+#ifndef DSGE_SHAPE_HPP
+#define DSGE_SHAPE_HPP
+
+#include <3ds.h>
+#include "transform.hpp"
+
+typedef enum {
+    SHAPE_BOX = 0,     // Rotated rectangle
+    SHAPE_CIRCLE = 1,  // Circle
+    SHAPE_CAPSULE = 2, // Two circles joined by a rectangle, along the object's x axis.
+    SHAPE_PIXELS = 3   // The solid pixels of the sprite's graphic, only for unrotated sprites.
+} shapeType;
+
+namespace dsge {
+/**
+ * @brief A collision shape that can be given to a sprite or text with `setHitbox()`.
+ *
+ * The shape is centered on the center of the object and moves, rotates, scales and flips along with it.
+ *
+ * #### Example Usage:
+ * ```
+ * dsge::Sprite ship(100, 100);
+ * ship.loadGraphic("ship.t3x");
+ * ship.setHitbox(dsge::Shape::circle(6)); // Only the cockpit can get hit.
+ *
+ * dsge::Sprite laser(0, 0);
+ * laser.makeGraphic(200, 8);
+ * laser.setHitbox(dsge::Shape::capsule(192, 4));
+ *
+ * dsge::Sprite boss(200, 40);
+ * boss.loadGraphic("boss.t3x");
+ * boss.setHitbox(dsge::Shape::pixels()); // Pixel perfect against any other sprite.
+ * ```
+ */
+struct Shape {
+    shapeType type;
+    float x, y;          // Offset of the center of the shape from the center of the object.
+    float width, height; // Size of a box.
+    float radius;        // Radius of a circle, or of both ends of a capsule.
+    float length;        // Distance between the centers of both ends of a capsule.
+
+    static Shape box(float width, float height, float x = 0, float y = 0) { return {SHAPE_BOX, x, y, width, height, 0, 0}; }
+    static Shape circle(float radius, float x = 0, float y = 0) { return {SHAPE_CIRCLE, x, y, 0, 0, radius, 0}; }
+    static Shape capsule(float length, float radius, float x = 0, float y = 0) { return {SHAPE_CAPSULE, x, y, 0, 0, radius, length}; }
+    static Shape pixels() { return {SHAPE_PIXELS, 0, 0, 0, 0, 0, 0}; }
+};
+
+/**
+ * @brief How far and where the first object has to be moved for two objects to stop overlapping.
+ */
+struct Penetration {
+    float x, y;  // Move the first object by this much.
+    float depth; // Length of (x, y).
+};
+
+namespace _internal {
+    /**
+     * A shape placed in the world.
+     *
+     * It's only rebuilt if the owner's world transform changed, and it's axes only if the rotation changed.
+     */
+    struct Collider {
+        Shape shape;
+        bool  enabled;
+        bool  pixels;   // Set with SHAPE_PIXELS, it's placed as a box of the size of the owner.
+
+        float cx, cy;   // World center.
+        float ux, uy;   // World x axis of the shape, the y axis is (-uy, ux).
+        float hx, hy;   // Half size of a box, or half of the length and radius of a capsule.
+        float radius;   // World radius of a circle or capsule.
+        Bounds bounds;  // World bounding box.
+
+        Collider();
+        Collider(const Collider& other); // Copies have to be placed again.
+        Collider& operator=(const Collider& other);
+
+        void set(const Shape& shape);
+        void update(const Transform& t, float originX, float originY);
+        void fromBounds(const Bounds& b);
+
+    private:
+        bool  valid;
+        u32   version;  // Transform version it's been placed with.
+        float angle;    // World angle the axes got built for.
+    };
+
+    bool intersect(const Collider& a, const Collider& b, Penetration* out);
+}
+} // namespace dsge
+
+#endif
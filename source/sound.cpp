@@ -1,32 +1,735 @@
 #include "sound.hpp"
+#include "adpcm.hpp"
 #include "dsge.hpp"
 #include <tremor/ivorbisfile.h>
 #include <cstring>
 #include <cstdio> // For fopen, fclose
+#include <atomic>
+#include <unordered_map>
+#include <vector>
 
 namespace {
+    constexpr int CHANNELS = 24;
+    constexpr int MAX_BUFFERS = 8; // Most wave buffers a stream can use, see `Sound::setLatency()`.
+    constexpr size_t QUEUE_SIZE = 64; // Power of two.
+    constexpr u32 LEAD_IN_FRAMES = 1024; // Longest silence before a scheduled start, more than a DSP frame at any rate.
+    constexpr int MIX_CHANNEL = CHANNELS - 1; // Taken by the software mixer while it's on.
+    constexpr int MIX_VOICES = 16;
+    constexpr int MIX_BUFFERS = 4;
+    constexpr u32 MIX_FRAMES = 512;           // Per buffer, about 16ms at the DSP's rate.
+
+    enum : u8 {
+        STREAM_LOADING,
+        STREAM_READY,     // Opened and the first buffers are decoded.
+        STREAM_FAILED,
+        STREAM_DISCARDED  // Not wanted anymore, whoever is done with it last frees it.
+    };
+
+    enum : u8 {
+        FORMAT_VORBIS, // .ogg, decoded by Tremor on the CPU.
+        FORMAT_ADPCM   // .adpcm, decoded by the DSP.
+    };
+
+    u8 formatOf(const std::string& path) {
+        const std::string ext = ".adpcm";
+        bool adpcm = path.size() >= ext.size() && path.compare(path.size() - ext.size(), ext.size(), ext) == 0;
+        return adpcm ? FORMAT_ADPCM : FORMAT_VORBIS;
+    }
+}
+
+namespace dsge {
+namespace _internal {
+    // A whole clip decoded into linear memory, shared by every SoundEffect of the same file.
+    struct PcmClip {
+        std::string path;
+        int16_t* samples = nullptr; // Interleaved if stereo.
+        u8* adpcm = nullptr;        // The frames as they are in the file instead, if it's an ADPCM file.
+        u16 coefs[16] = {};
+        ndspAdpcmData context = {}; // Of the first frame.
+        u32 frames = 0;             // Samples per channel.
+        u32 rate = 0;
+        u8 channels = 0;
+        u32 refs = 0;
+    };
+
+    // An opened Ogg or ADPCM file with it's first buffers filled. Filled by the loader thread, then handed to the
+    // audio thread by `Sound::play()`, which keeps filling the same buffers.
+    struct SoundStream {
+        std::string path;
+        std::atomic<u8> state{STREAM_LOADING};
+        std::atomic<float> progress{0};
+        u8 format = FORMAT_VORBIS;
+
+        OggVorbis_File vorbisFile;
+        bool opened = false;
+
+        // ADPCM files are read straight into the wave buffers, the DSP decodes them.
+        FILE* file = nullptr;
+        AdpcmHeader adpcm;
+        u32 next = 0;                   // Next sample to read, always the start of a frame.
+        bool discontinuity = true;      // The next buffer doesn't go on from the last one, the DSP needs `context`.
+        ndspAdpcmData context;          // Of the frame at `next`.
+        ndspAdpcmData loopContext;      // Of the frame the loop goes back to.
+        ndspAdpcmData contexts[MAX_BUFFERS];
+
+        bool eof = false;
+        bool loop = false;
+        u8 primed = 0;                  // Buffers decoded by the loader.
+        u32 rate = 0;
+        u8 channels = 0;
+        u32 bufferFrames = 0;
+        u32 bufferSize = 0;             // Bytes per buffer.
+        u8 frameSize = 0;               // Bytes per sample frame, PCM only.
+        u32 total = 0;                  // Sample frames in the file.
+        int16_t* audioBuffer = nullptr;
+        ndspWaveBuf waveBufs[MAX_BUFFERS];
+
+        // Where every buffer starts, in samples played since the start and in the file.
+        u64 queued = 0;
+        u64 starts[MAX_BUFFERS];
+        u32 fileStarts[MAX_BUFFERS];
+
+        // Latency profile, `buffers` grows up to `capacity` after underruns if it's adaptive.
+        u8 buffers = 3;
+        u8 capacity = 3;
+        u16 bufferMs = 120;
+        bool adaptive = false;
+
+        // See `Sound::getStats()`, written by the loader and then the audio thread.
+        u64 decodeTicks = 0;   // CPU time spent filling buffers.
+        u64 worstTicks = 0;    // Slowest buffer.
+        u32 filled = 0;        // Buffers filled.
+        u64 decoded = 0;       // Samples in them.
+        u32 underruns = 0;
+        u8 queuedNow = 0;      // Buffers queued when the audio thread last looked.
+        u8 minQueued = 0xFF;
+        u64 queuedSum = 0;     // Every look added up, for the average.
+        u32 looks = 0;
+    };
+}
+}
+
+namespace {
+    using dsge::_internal::SoundStream;
+
+    // Where a stream was when the audio thread last looked, see `Sound::getPosition()` and `Sound::getStats()`.
+    struct ChannelStatus {
+        u64 played;      // Samples played since it started, loops included.
+        u32 file;        // Sample in the file.
+        u32 total;       // Samples in the file.
+        u32 rate;
+        u64 tick;        // System tick it got read at.
+        bool running;    // Playing, not paused, waiting for it's start or out of samples.
+        u32 serial;      // Play it belongs to, see `AudioChannel::serial`.
+        u64 decodeTicks; // Time spent filling it's buffers, loader included.
+        u64 decoded;     // Samples those buffers hold.
+        u64 worstTicks;
+        u32 filled;
+        u32 underruns;
+        u8 buffers;
+        u8 queued;
+        u8 minQueued;
+        float avgQueued;
+    };
+
     struct AudioChannel {
+        // Only touched by the game thread.
         bool active = false;
+        dsge::Sound* owner = nullptr;
+        const dsge::_internal::PcmClip* clip = nullptr; // Set while playing a SoundEffect, which needs no thread.
+        const dsge::SoundEffect* effect = nullptr;
+        ndspWaveBuf effectBuf;
+        ndspAdpcmData effectContext;
+        u32 serial = 0; // Counts plays, so a position left by an earlier one is never read.
+        int priority = 0;
+        u64 startTick = 0; // When it started playing, for STEAL_OLDEST.
+        float level = 1;   // Volume it plays at, for STEAL_QUIETEST.
+        u8 loggedBuffers = 0; // Buffers of the play the last time Sound::_update() looked, it logs when they grow.
+
+        // Serial of the play, set by the game thread before it sends CMD_PLAY and cleared by the audio thread once
+        // it closed the stream. A stream that ends after another play took the channel leaves it as it is.
+        std::atomic<u32> streaming{0};
+
+        // Only touched by the audio thread.
         int channel_id = -1;
-        ndspWaveBuf waveBufs[3];
-        int16_t* audioBuffer = nullptr;
-        OggVorbis_File vorbisFile;
-        Thread threadId = nullptr;
-        bool quit = false;
+        SoundStream* stream = nullptr;
+        u32 playSerial = 0;   // `serial` of the play it has.
+        bool started = false; // Waits for the loader until then.
         bool loop = false;
-        int* timePtr = nullptr;
-        dsge::Sound* owner = nullptr;
+        bool paused = false;
+        float volume = 1;
+        u64 startAt = 0;   // DSP clock to start at, 0 for right away.
+        u32 startFrom = 0; // Milliseconds into the file.
+        ndspWaveBuf leadIn;
+
+        // Written by the audio thread, read by the game thread. A seqlock, `statusSeq` is odd while writing.
+        std::atomic<u32> statusSeq{0};
+        ChannelStatus status = {};
+    };
+
+    enum : u8 {
+        CMD_PLAY,
+        CMD_STOP,
+        CMD_PAUSE,
+        CMD_RESUME,
+        CMD_VOLUME,
+        CMD_SEEK
+    };
+
+    struct Command {
+        u8 type;
+        s8 channel;
+        bool loop;
+        float volume;
+        SoundStream* stream; // Only for CMD_PLAY, the audio thread owns it from then on.
+        u64 at;              // CMD_PLAY: DSP clock to start at.
+        u32 time;            // CMD_PLAY and CMD_SEEK: milliseconds into the file.
+        u32 serial;          // CMD_PLAY: `AudioChannel::serial` of the play.
+    };
+
+    // Never waits, a full queue just refuses more.
+    template<typename T>
+    struct SpscQueue {
+        T items[QUEUE_SIZE];
+        std::atomic<u32> head{0}; // Next one the consumer reads.
+        std::atomic<u32> tail{0}; // Next one the producer writes.
+
+        bool push(const T& item) {
+            u32 t = tail.load(std::memory_order_relaxed);
+            if (t - head.load(std::memory_order_acquire) == QUEUE_SIZE) return false;
+
+            items[t & (QUEUE_SIZE - 1)] = item;
+            tail.store(t + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Only the producer can rely on it, a push after it returned false always works.
+        bool full() const {
+            return tail.load(std::memory_order_relaxed) - head.load(std::memory_order_acquire) == QUEUE_SIZE;
+        }
+
+        bool pop(T& out) {
+            u32 h = head.load(std::memory_order_relaxed);
+            if (h == tail.load(std::memory_order_acquire)) return false;
+
+            out = items[h & (QUEUE_SIZE - 1)];
+            head.store(h + 1, std::memory_order_release);
+            return true;
+        }
+    };
+
+    // A SoundEffect played by the software mixer, resampled to the DSP's rate.
+    struct MixVoice {
+        const dsge::_internal::PcmClip* clip = nullptr; // nullptr if it's unused.
+        const dsge::SoundEffect* effect = nullptr;
+        s32 gain;         // Volume, 256 is full.
+        u64 startTick;
+        u32 read;         // Next sample of the clip.
+        u32 frac;         // 16.16 position between `s0` and `s1`.
+        u32 step;         // How far every output sample moves it.
+        s32 s0[2], s1[2]; // Left and right of the samples it's between.
+        u8 ended;         // Samples read past the end, it's done once `s0` is past it too.
+        s16 hist1, hist2; // ADPCM clips are decoded a frame at a time.
+        s16 frame[dsge::_internal::ADPCM_FRAME_SAMPLES];
+    };
+
+    // Mixed by the audio thread, `lock` is held by whatever touches the voices or buffers.
+    struct {
+        int maxPriority = -1; // SoundEffects up to this priority are mixed, -1 while it's off. Game thread only.
+        LightLock lock;
+        bool started = false; // Playing on MIX_CHANNEL.
+        int16_t* buffer = nullptr;
+        ndspWaveBuf waveBufs[MIX_BUFFERS];
+        MixVoice voices[MIX_VOICES];
+        s32 sum[MIX_FRAMES * 2];
+    } mixer;
+
+    struct MixerLock {
+        MixerLock() { LightLock_Lock(&mixer.lock); }
+        ~MixerLock() { LightLock_Unlock(&mixer.lock); }
     };
 
-    AudioChannel channels[24];
+    AudioChannel channels[CHANNELS];
+    voiceSteal stealMode = STEAL_OLDEST;
+    voiceStats counters = {};
     LightEvent s_event;
     bool system_initialized = false;
 
-    void audioThread(void* arg);
-    bool fillBuffer(AudioChannel* channel);
-    bool audioInit(AudioChannel* channel);
-    void audioExit(AudioChannel* channel);
-    void stopChannel(AudioChannel* channel);
+    SpscQueue<Command> commands;      // Game thread to audio thread.
+    SpscQueue<SoundStream*> loads;    // Game thread to loader thread.
+
+    Thread serviceThreadId = nullptr;
+    std::atomic<bool> serviceQuit{false};
+
+    std::atomic<u32> dspFrames{0}; // Counted by the DSP callback.
+    int16_t* silence = nullptr;    // Played before a scheduled start.
+
+    Thread loaderThreadId = nullptr;
+    LightEvent loaderEvent;
+    std::atomic<bool> loaderQuit{false};
+
+    std::unordered_map<std::string, dsge::_internal::PcmClip>& clips() {
+        // Never freed so effects destroyed after main() can still release their clip.
+        static auto* c = new std::unordered_map<std::string, dsge::_internal::PcmClip>();
+        return *c;
+    }
+
+    // onComplete of Sounds that ended, run by the next Sound::_update(). Never freed either.
+    std::vector<std::function<void()>>& completions() {
+        static auto* c = new std::vector<std::function<void()>>();
+        return *c;
+    }
+
+    void initSystem() {
+        if (system_initialized) return;
+        LightEvent_Init(&s_event, RESET_ONESHOT);
+        LightLock_Init(&mixer.lock);
+        ndspSetCallback([](void*) {
+            dspFrames.fetch_add(1, std::memory_order_release);
+            LightEvent_Signal(&s_event);
+        }, nullptr);
+        system_initialized = true;
+    }
+
+    bool readStatus(const AudioChannel& ch, ChannelStatus& out) {
+        for (int tries = 0; tries < 16; tries++) {
+            u32 seq = ch.statusSeq.load(std::memory_order_acquire);
+            if (seq & 1) continue;
+
+            out = ch.status;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (ch.statusSeq.load(std::memory_order_relaxed) == seq) return true;
+        }
+        return false;
+    }
+
+    // A clip is done as soon as the DSP is done with it's only buffer, and a Sound as soon as the audio thread
+    // closed it's stream, so their channel can be reused right away.
+    bool isFree(int i) {
+        const AudioChannel& ch = channels[i];
+        if (ch.streaming.load(std::memory_order_acquire) != 0) return false;
+        return !ch.active || ch.owner || (ch.clip && ch.effectBuf.status == NDSP_WBUF_DONE);
+    }
+
+    int hardwareVoices() {
+        return mixer.maxPriority >= 0 ? MIX_CHANNEL : CHANNELS;
+    }
+
+    // Whatever plays on channel `i` stops, a Sound's stream is only closed by the next command for the channel.
+    void evict(int i) {
+        AudioChannel& ch = channels[i];
+        if (ch.owner && ch.owner->channel == i) {
+            ch.owner->channel = -1;
+            ch.owner->isPlaying = false;
+            ch.owner->isPaused = false;
+        }
+        if (ch.active && ch.clip) ndspChnWaveBufClear(i);
+
+        ch.active = false;
+        ch.owner = nullptr;
+        ch.clip = nullptr;
+        ch.effect = nullptr;
+    }
+
+    // A Sound whose stream the audio thread closed gives it's channel back. It's onComplete runs from the next
+    // Sound::_update(), only if it actually started, not if it failed to load.
+    void reclaim(int i) {
+        AudioChannel& ch = channels[i];
+        ChannelStatus p;
+        bool played = readStatus(ch, p) && p.serial == ch.serial && p.rate != 0;
+
+        dsge::Sound* owner = ch.owner;
+        evict(i);
+
+        // A copy, the callback may destroy the Sound.
+        if (played && owner->onComplete) completions().push_back(owner->onComplete);
+    }
+
+    int freeVoice() {
+        int voices = hardwareVoices();
+
+        // Idle channels first, ended clips and Sounds only when there's none left.
+        for (int i = 0; i < voices; i++) {
+            if (!channels[i].active && isFree(i)) return i;
+        }
+        for (int i = 0; i < voices; i++) {
+            if (!isFree(i)) continue;
+
+            if (channels[i].owner) {
+                reclaim(i);
+            } else {
+                evict(i);
+            }
+            return i;
+        }
+        return -1;
+    }
+
+    // The channel of the least important play up to `priority`, which is stopped for it. Only a Sound can take a
+    // channel that's still streaming, it's CMD_PLAY closes the old stream first.
+    int stealVoice(int priority, bool stream) {
+        int voices = hardwareVoices();
+        int victim = -1;
+        for (int i = 0; i < voices; i++) {
+            const AudioChannel& ch = channels[i];
+            bool stealable = ch.active && (ch.clip || (stream && ch.owner));
+            if (!stealable || ch.priority > priority) continue;
+            if (victim == -1) {
+                victim = i;
+                continue;
+            }
+
+            const AudioChannel& v = channels[victim];
+            if (ch.priority != v.priority) {
+                if (ch.priority < v.priority) victim = i;
+            } else if (stealMode == STEAL_QUIETEST && ch.level != v.level) {
+                if (ch.level < v.level) victim = i;
+            } else if (ch.startTick < v.startTick) {
+                victim = i;
+            }
+        }
+
+        if (victim == -1) return -1;
+
+        evict(victim);
+        counters.steals++;
+        return victim;
+    }
+
+    // Remembered for when something has to make room.
+    void claimVoice(int i, int priority, float level) {
+        AudioChannel& ch = channels[i];
+        ch.active = true;
+        ch.priority = priority;
+        ch.level = level;
+        ch.startTick = svcGetSystemTick();
+    }
+
+    // If the audio thread is that far behind the command is dropped.
+    bool sendCommand(const Command& cmd) {
+        if (!commands.push(cmd)) {
+            trace("[WARN] Sound: Command queue is full, dropped a command!");
+            return false;
+        }
+
+        LightEvent_Signal(&s_event);
+        return true;
+    }
+
+    void setVolume(int channel, float volume) {
+        float mix[12] = {volume, volume};
+        ndspChnSetMix(channel, mix);
+    }
+
+    dsge::_internal::PcmClip* decodeClip(const std::string& path) {
+        auto it = clips().find(path);
+        if (it != clips().end()) {
+            it->second.refs++;
+            return &it->second;
+        }
+
+        DSGE_PROFILE_ZONE("decodeClip");
+
+        FILE* fh = fopen(("romfs:/" + path).c_str(), "rb");
+        if (!fh) return nullptr;
+
+        dsge::_internal::PcmClip clip;
+        clip.path = path;
+        clip.refs = 1;
+
+        if (formatOf(path) == FORMAT_ADPCM) {
+            // Kept as it is in the file, the DSP decodes it while playing.
+            dsge::_internal::AdpcmHeader header;
+            bool ok = dsge::_internal::readAdpcmHeader(fh, header) && header.samples != 0;
+            u32 bytes = ok ? dsge::_internal::adpcmBytes(header.samples) : 0;
+            if (ok) clip.adpcm = (u8*)linearAlloc(bytes);
+
+            ok = clip.adpcm && fread(clip.adpcm, 1, bytes, fh) == bytes;
+            fclose(fh);
+            if (!ok) {
+                if (clip.adpcm) linearFree(clip.adpcm);
+                return nullptr;
+            }
+
+            memcpy(clip.coefs, header.coefs, sizeof(clip.coefs));
+            clip.context = {clip.adpcm[0], header.seekTable[0], header.seekTable[1]};
+            clip.frames = header.samples;
+            clip.rate = header.rate;
+            clip.channels = 1;
+            DSP_FlushDataCache(clip.adpcm, bytes);
+
+            dsge::_internal::PcmClip& entry = clips()[path];
+            entry = clip;
+            return &entry;
+        }
+
+        OggVorbis_File vf;
+        if (ov_open(fh, &vf, nullptr, 0) != 0) {
+            fclose(fh);
+            return nullptr;
+        }
+
+        vorbis_info* vi = ov_info(&vf, -1);
+        ogg_int64_t frames = ov_pcm_total(&vf, -1);
+        if (!vi || frames <= 0) {
+            ov_clear(&vf);
+            return nullptr;
+        }
+
+        size_t bytes = frames * vi->channels * sizeof(int16_t);
+        int16_t* samples = (int16_t*)linearAlloc(bytes);
+        if (!samples) {
+            ov_clear(&vf);
+            return nullptr;
+        }
+
+        size_t total = 0;
+        while (total < bytes) {
+            int read = ov_read(&vf, (char*)samples + total, bytes - total, nullptr);
+            if (read <= 0) break;
+            total += read;
+        }
+
+        clip.samples = samples;
+        clip.frames = total / (vi->channels * sizeof(int16_t));
+        clip.rate = vi->rate;
+        clip.channels = vi->channels;
+        ov_clear(&vf);
+
+        // Written by the CPU once, the DSP reads it from memory directly.
+        DSP_FlushDataCache(samples, total);
+
+        dsge::_internal::PcmClip& entry = clips()[path];
+        entry = clip;
+        return &entry;
+    }
+
+    void releaseClip(dsge::_internal::PcmClip* clip) {
+        if (!clip || --clip->refs != 0) return;
+
+        // The DSP can't be left reading freed memory.
+        for (int i = 0; i < CHANNELS; i++) {
+            if (channels[i].active && channels[i].clip == clip) {
+                ndspChnWaveBufClear(i);
+                channels[i].active = false;
+                channels[i].clip = nullptr;
+                channels[i].effect = nullptr;
+            }
+        }
+
+        // Mixed buffers are copies, only the voices need to go.
+        {
+            MixerLock lock;
+            for (MixVoice& v : mixer.voices) {
+                if (v.clip == clip) v.clip = nullptr;
+            }
+        }
+
+        if (clip->samples) linearFree(clip->samples);
+        if (clip->adpcm) linearFree(clip->adpcm);
+        clips().erase(clip->path);
+    }
+
+    // The next sample of the clip, false once it's past the end.
+    bool readMixSample(MixVoice& v, s32* out) {
+        const dsge::_internal::PcmClip* clip = v.clip;
+        if (v.read >= clip->frames) return false;
+
+        if (clip->adpcm) {
+            u32 i = v.read % dsge::_internal::ADPCM_FRAME_SAMPLES;
+            const u8* frame = clip->adpcm + v.read / dsge::_internal::ADPCM_FRAME_SAMPLES * dsge::_internal::ADPCM_FRAME_BYTES;
+            if (i == 0) dsge::_internal::decodeAdpcmFrame(frame, clip->coefs, v.hist1, v.hist2, v.frame);
+            out[0] = out[1] = v.frame[i];
+        } else if (clip->channels == 2) {
+            out[0] = clip->samples[v.read * 2];
+            out[1] = clip->samples[v.read * 2 + 1];
+        } else {
+            out[0] = out[1] = clip->samples[v.read];
+        }
+
+        v.read++;
+        return true;
+    }
+
+    // Adds the voice to the next MIX_FRAMES samples of `mixer.sum`, linearly interpolated.
+    void mixVoice(MixVoice& v) {
+        s32* sum = mixer.sum;
+        for (u32 n = 0; n < MIX_FRAMES; n++) {
+            s32 t = v.frac >> 1; // 15 bits, so the product fits.
+            sum[n * 2] += (v.s0[0] + (((v.s1[0] - v.s0[0]) * t) >> 15)) * v.gain >> 8;
+            sum[n * 2 + 1] += (v.s0[1] + (((v.s1[1] - v.s0[1]) * t) >> 15)) * v.gain >> 8;
+
+            v.frac += v.step;
+            while (v.frac >= 0x10000) {
+                v.frac -= 0x10000;
+                v.s0[0] = v.s1[0];
+                v.s0[1] = v.s1[1];
+                if (readMixSample(v, v.s1)) continue;
+
+                v.s1[0] = v.s1[1] = 0;
+                if (++v.ended > 1) {
+                    v.clip = nullptr;
+                    return;
+                }
+            }
+        }
+    }
+
+    // Mixes into every buffer the DSP is done with, while anything is playing. Called by the audio thread every DSP
+    // frame, so a slow frame of the game doesn't starve it. Only with `mixer.lock` held.
+    void fillMixer() {
+        if (!mixer.started) return;
+
+        DSGE_PROFILE_ZONE("fillMixer");
+
+        for (int b = 0; b < MIX_BUFFERS; b++) {
+            ndspWaveBuf& waveBuf = mixer.waveBufs[b];
+            if (waveBuf.status != NDSP_WBUF_DONE) continue;
+
+            bool playing = false;
+            for (const MixVoice& v : mixer.voices) playing |= v.clip != nullptr;
+            if (!playing) return;
+
+            memset(mixer.sum, 0, sizeof(mixer.sum));
+            for (MixVoice& v : mixer.voices) {
+                if (v.clip) mixVoice(v);
+            }
+
+            int16_t* out = mixer.buffer + b * MIX_FRAMES * 2;
+            for (u32 i = 0; i < MIX_FRAMES * 2; i++) {
+                s32 value = mixer.sum[i];
+                out[i] = value > 32767 ? 32767 : value < -32768 ? -32768 : value;
+            }
+            DSP_FlushDataCache(out, MIX_FRAMES * 2 * sizeof(int16_t));
+
+            memset(&waveBuf, 0, sizeof(waveBuf));
+            waveBuf.data_pcm16 = out;
+            waveBuf.nsamples = MIX_FRAMES;
+            ndspChnWaveBufAdd(MIX_CHANNEL, &waveBuf);
+        }
+    }
+
+    // Takes MIX_CHANNEL once whatever was on it is done. Only with `mixer.lock` held.
+    void startMixer() {
+        if (mixer.started || mixer.maxPriority < 0 || !isFree(MIX_CHANNEL)) return;
+
+        if (!mixer.buffer) {
+            mixer.buffer = (int16_t*)linearAlloc(MIX_BUFFERS * MIX_FRAMES * 2 * sizeof(int16_t));
+            if (!mixer.buffer) {
+                trace("[WARN] Sound::setSoftwareMix: Could not allocate the mixer!");
+                mixer.maxPriority = -1;
+                return;
+            }
+        }
+
+        evict(MIX_CHANNEL);
+        channels[MIX_CHANNEL].active = true;
+        for (ndspWaveBuf& waveBuf : mixer.waveBufs) waveBuf.status = NDSP_WBUF_DONE;
+
+        // Already at the DSP's rate, nothing to interpolate.
+        ndspChnReset(MIX_CHANNEL);
+        ndspChnSetInterp(MIX_CHANNEL, NDSP_INTERP_NONE);
+        ndspChnSetRate(MIX_CHANNEL, dsge::_internal::DSP_SAMPLE_RATE);
+        ndspChnSetFormat(MIX_CHANNEL, NDSP_FORMAT_STEREO_PCM16);
+        setVolume(MIX_CHANNEL, 1);
+        mixer.started = true;
+    }
+
+    void stopMixer() {
+        MixerLock lock;
+        if (mixer.started) {
+            ndspChnWaveBufClear(MIX_CHANNEL);
+            channels[MIX_CHANNEL].active = false;
+            mixer.started = false;
+        }
+
+        for (MixVoice& v : mixer.voices) v.clip = nullptr;
+    }
+
+    // Plays the clip on the mixer, false if all of it's voices are busy.
+    bool mixClip(const dsge::_internal::PcmClip* clip, const dsge::SoundEffect* effect, float volume) {
+        MixerLock lock;
+        MixVoice* voice = nullptr;
+        for (MixVoice& v : mixer.voices) {
+            if (!v.clip) {
+                voice = &v;
+                break;
+            }
+        }
+        if (!voice) return false;
+
+        voice->clip = clip;
+        voice->effect = effect;
+        voice->gain = (s32)(volume * 256);
+        voice->startTick = svcGetSystemTick();
+        voice->read = 0;
+        voice->frac = 0;
+        voice->step = (u32)(clip->rate * 65536.0 / dsge::_internal::DSP_SAMPLE_RATE);
+        voice->ended = 0;
+        voice->hist1 = clip->context.history0;
+        voice->hist2 = clip->context.history1;
+
+        voice->s0[0] = voice->s0[1] = voice->s1[0] = voice->s1[1] = 0;
+        readMixSample(*voice, voice->s0);
+        if (!readMixSample(*voice, voice->s1)) voice->ended = 1;
+
+        // Started right away if a buffer's free, the DSP is usually a few frames into the queued ones.
+        startMixer();
+        fillMixer();
+        return true;
+    }
+
+    // Stops the oldest plays of `clip` until it plays less than `limit` times.
+    void limitInstances(const dsge::_internal::PcmClip* clip, int limit) {
+        MixerLock lock;
+        while (true) {
+            int count = 0;
+            int channel = -1;
+            MixVoice* voice = nullptr;
+            u64 oldest = UINT64_MAX;
+
+            for (int i = 0; i < CHANNELS; i++) {
+                if (channels[i].clip != clip || isFree(i)) continue;
+
+                count++;
+                if (channels[i].startTick < oldest) {
+                    oldest = channels[i].startTick;
+                    channel = i;
+                }
+            }
+
+            for (MixVoice& v : mixer.voices) {
+                if (v.clip != clip) continue;
+
+                count++;
+                if (v.startTick < oldest) {
+                    oldest = v.startTick;
+                    voice = &v;
+                    channel = -1;
+                }
+            }
+
+            if (count < limit) return;
+
+            if (voice) voice->clip = nullptr;
+            else evict(channel);
+            counters.steals++;
+        }
+    }
+
+    // From what the loader read, it's only valid once the stream is ready.
+    int lengthOf(const SoundStream& stream) {
+        return stream.rate != 0 ? (int)((u64)stream.total * 1000 / stream.rate) : 0;
+    }
+
+    void startService();
+    void serviceThread(void* arg);
+    void runCommands();
+    bool fillBuffer(SoundStream* stream, int channel, bool emptied = false);
+    void startLoader();
+    void loaderThread(void* arg);
+    void loadStream(SoundStream* stream);
+    void releaseStream(SoundStream* stream);
 }
 
 namespace dsge {
@@ -36,228 +739,1028 @@ Sound::Sound(const std::string& path)
     , time(0)
     , volume(1.0f)
     , loop(false)
+    , priority(0)
     , filePath("romfs:/" + path)
     , channel(-1)
     , isPlaying(false)
     , isPaused(false)
+    , stream(nullptr)
+    , seekTo(0)
+    , buffers(3)
+    , bufferMs(120)
+    , adaptive(false)
 {
-    if (!system_initialized) {
-        LightEvent_Init(&s_event, RESET_ONESHOT);
-        ndspSetCallback([](void*) { LightEvent_Signal(&s_event); }, nullptr);
-        system_initialized = true;
+    initSystem();
+}
+
+// Copies don't share the preloaded stream or the channel.
+Sound::Sound(const Sound& other)
+    : length(other.length)
+    , time(0)
+    , volume(other.volume)
+    , loop(other.loop)
+    , priority(other.priority)
+    , onComplete(other.onComplete)
+    , channel(-1)
+    , isPlaying(false)
+    , isPaused(false)
+    , filePath(other.filePath)
+    , stream(nullptr)
+    , seekTo(0)
+    , buffers(other.buffers)
+    , bufferMs(other.bufferMs)
+    , adaptive(other.adaptive)
+{
+}
+
+Sound& Sound::operator=(const Sound& other) {
+    if (this == &other) return *this;
+
+    stop();
+    if (stream) releaseStream(stream);
+    stream = nullptr;
+
+    length = other.length;
+    volume = other.volume;
+    loop = other.loop;
+    priority = other.priority;
+    onComplete = other.onComplete;
+    filePath = other.filePath;
+    buffers = other.buffers;
+    bufferMs = other.bufferMs;
+    adaptive = other.adaptive;
+    return *this;
+}
+
+Sound::~Sound() {
+    stop();
+    if (stream) releaseStream(stream);
+}
+
+void Sound::setLatency(soundLatency profile) {
+    switch (profile) {
+        case LATENCY_LOW: setLatency(4, 20); break;
+        case LATENCY_NORMAL: setLatency(3, 120); break;
+        case LATENCY_SAFE: setLatency(4, 250); break;
+        case LATENCY_AUTO: setLatency(3, 40, true); break;
     }
-    calculateLength();
 }
 
-void Sound::calculateLength() {
-    FILE* fh = fopen(filePath.c_str(), "rb");
-    if (fh) {
-        OggVorbis_File vf;
-        if (ov_open(fh, &vf, nullptr, 0) == 0) {
-            length = static_cast<int>(ov_time_total(&vf, -1)); // seconds to ms
-            ov_clear(&vf);
-            // ov_clear closes fh for us
-            return;
-        }
-        fclose(fh);
+void Sound::setLatency(u8 count, u16 ms, bool grow) {
+    if (count < 2) count = 2;
+    if (count > MAX_BUFFERS) count = MAX_BUFFERS;
+    if (ms < 10) ms = 10;
+    if (count == buffers && ms == bufferMs && grow == adaptive) return;
+
+    buffers = count;
+    bufferMs = ms;
+    adaptive = grow;
+
+    // A preloaded stream has the old buffers, it's loaded again on the next play.
+    if (stream) releaseStream(stream);
+    stream = nullptr;
+}
+
+void Sound::preload() {
+    if (stream) return;
+
+    stream = new _internal::SoundStream();
+    stream->path = filePath;
+    stream->loop = loop;
+    stream->buffers = buffers;
+    stream->capacity = adaptive ? MAX_BUFFERS : buffers;
+    stream->bufferMs = bufferMs;
+    stream->adaptive = adaptive;
+
+    startLoader();
+    if (loaderThreadId && loads.push(stream)) {
+        LightEvent_Signal(&loaderEvent);
+        return;
     }
+
+    // No loader to give it to, so it's loaded right here.
+    loadStream(stream);
+}
+
+bool Sound::isReady() {
+    if (!stream || stream->state.load(std::memory_order_acquire) != STREAM_READY) return false;
+
+    length = lengthOf(*stream);
+    return true;
+}
+
+float Sound::loadProgress() const {
+    return stream ? stream->progress.load(std::memory_order_relaxed) : 0;
 }
 
 void Sound::play() {
-    // If we have an active channel, completely nuke it
-    if (channel != -1) {
-        // Force stop everything
-        ndspChnReset(channel);
-        
-        // Free all resources
-        if (channels[channel].audioBuffer) {
-            linearFree(channels[channel].audioBuffer);
-            channels[channel].audioBuffer = nullptr;
-        }
-        
-        // Clear Vorbis file
-        ov_clear(&channels[channel].vorbisFile);
-        
-        // Kill the thread if it exists
-        if (channels[channel].threadId) {
-            threadJoin(channels[channel].threadId, UINT64_MAX);
-            threadFree(channels[channel].threadId);
-        }
-        
-        // Mark as inactive
-        channels[channel].active = false;
-        channel = -1;
-    }
+    playAt(0);
+}
 
-    if (channel != -1 && channels[channel].active) {
-        ndspChnReset(channel);
-        channels[channel].active = false;
-    }
+void Sound::playAt(u64 clockTime) {
+    DSGE_PROFILE_ZONE("Sound::play");
 
-    // Find a free channel
-    int found = -1;
-    for (int i = 0; i < 24; i++) {
-        if (!channels[i].active) {
-            found = i;
-            break;
-        }
-    }
-    if (found == -1) return; // No free channel
+    // Restarting leaves the old stream to the audio thread, nothing here waits on it.
+    stop();
+    startService();
+    preload();
 
-    channel = found;
-    AudioChannel* ch = &channels[channel];
-    ch->owner = this;
-    ch->active = true;
-    ch->channel_id = channel; // Set channel ID
-    ch->loop = loop;
-    ch->timePtr = &time;
-    ch->quit = false;
-
-    FILE* fh = fopen(filePath.c_str(), "rb");
-    if (!fh) {
-        ch->active = false;
-        channel = -1;
+    u8 state = stream->state.load(std::memory_order_acquire);
+    if (state == STREAM_FAILED) {
+        releaseStream(stream);
+        stream = nullptr;
         return;
     }
+    if (state == STREAM_READY) length = lengthOf(*stream);
 
-    if (ov_open(fh, &ch->vorbisFile, nullptr, 0) != 0) {
-        fclose(fh);
-        ch->active = false;
-        channel = -1;
+    // Checked first, a channel taken from another Sound can't be given back.
+    if (commands.full()) {
+        trace("[WARN] Sound::play: Command queue is full, dropped a play!");
+        counters.drops++;
         return;
     }
 
-    if (!audioInit(ch)) {
-        ov_clear(&ch->vorbisFile);
-        ch->active = false;
-        channel = -1;
+    int found = freeVoice();
+    if (found == -1) found = stealVoice(priority, true);
+    if (found == -1) {
+        // Everything playing is more important, it stays preloaded.
+        counters.drops++;
         return;
     }
 
-    ndspChnSetMix(channel, (float[12]){volume, volume, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0});
-
-    int32_t priority = 0x30;
-    svcGetThreadPriority(&priority, CUR_THREAD_HANDLE);
-    priority = (priority - 1 < 0x18) ? 0x18 : priority - 1;
+    AudioChannel& ch = channels[found];
+    claimVoice(found, priority, volume);
+    ch.owner = this;
+    if (++ch.serial == 0) ch.serial = 1;
+    ch.loggedBuffers = 0;
+    ch.streaming.store(ch.serial, std::memory_order_release);
 
-    ch->threadId = threadCreate(audioThread, ch, 32 * 1024, priority, -1, false);
-    if (!ch->threadId) {
-        audioExit(ch);
-        ov_clear(&ch->vorbisFile);
-        ch->active = false;
-        channel = -1;
-        return;
-    }
+    // Starts once the loader is done with it, right away if it was preloaded.
+    sendCommand({CMD_PLAY, (s8)found, loop, volume, stream, clockTime, (u32)seekTo, ch.serial});
 
+    stream = nullptr;
+    channel = found;
     isPlaying = true;
     isPaused = false;
-    time = 0;
+    time = seekTo;
+    seekTo = 0;
 }
 
 void Sound::pause() {
     if (!isPlaying || isPaused || channel == -1) return;
-    ndspChnSetPaused(channel, true);
+    sendCommand({CMD_PAUSE, (s8)channel, false, 0, nullptr});
     isPaused = true;
 }
 
 void Sound::resume() {
     if (!isPlaying || !isPaused || channel == -1) return;
-    ndspChnSetPaused(channel, false);
+    sendCommand({CMD_RESUME, (s8)channel, false, 0, nullptr});
     isPaused = false;
 }
 
 void Sound::stop() {
-    if (!isPlaying || channel == -1) return;
-    stopChannel(&channels[channel]);
-    channels[channel].active = false;
+    if (channel == -1) return;
+
+    // The channel is only given to something else once the audio thread closed the stream.
+    if (channels[channel].owner == this) {
+        sendCommand({CMD_STOP, (s8)channel, false, 0, nullptr});
+        channels[channel].active = false;
+        channels[channel].owner = nullptr;
+    }
+
     channel = -1;
     isPlaying = false;
     isPaused = false;
     time = 0;
 }
 
+void Sound::setVolume(float value) {
+    volume = value;
+    if (channel == -1) return;
+
+    channels[channel].level = volume;
+    sendCommand({CMD_VOLUME, (s8)channel, false, volume, nullptr});
+}
+
+void Sound::seek(int ms) {
+    if (ms < 0) ms = 0;
+    if (length > 0 && ms > length) ms = length;
+
+    // Not playing, the next play() starts there.
+    if (channel == -1 || channels[channel].streaming.load(std::memory_order_acquire) == 0) {
+        seekTo = ms;
+        return;
+    }
+
+    sendCommand({CMD_SEEK, (s8)channel, false, 0, nullptr, 0, (u32)ms, 0});
+    time = ms;
+}
+
+u64 Sound::getSamplesPlayed() const {
+    ChannelStatus p;
+    if (channel == -1 || !readStatus(channels[channel], p) || p.serial != channels[channel].serial) return 0;
+
+    if (!p.running || isPaused) return p.played;
+    return p.played + _internal::samplesSince(p.tick, svcGetSystemTick(), p.rate);
+}
+
+double Sound::getPosition() const {
+    ChannelStatus p;
+    if (channel == -1 || !readStatus(channels[channel], p) || p.serial != channels[channel].serial || p.rate == 0) {
+        return (channel == -1 ? seekTo : time) / 1000.0;
+    }
+
+    u64 file = p.file;
+    if (p.running && !isPaused) file += _internal::samplesSince(p.tick, svcGetSystemTick(), p.rate);
+    if (p.total != 0) file = loop ? file % p.total : std::min<u64>(file, p.total);
+
+    return (double)file / p.rate;
+}
+
+float Sound::getBeat(float bpm, float offset) const {
+    return (float)((getPosition() * 1000 - offset) * bpm / 60000);
+}
+
+soundStats Sound::getStats() const {
+    ChannelStatus p;
+    if (channel == -1 || !readStatus(channels[channel], p) || p.serial != channels[channel].serial || p.rate == 0) return {};
+
+    soundStats stats;
+    stats.decodeMs = (float)((double)p.decodeTicks * 1000 / SYSCLOCK_ARM11);
+    stats.audioSeconds = (float)p.decoded / p.rate;
+    stats.bufferMs = p.filled != 0 ? stats.decodeMs / p.filled : 0;
+    stats.worstBufferMs = (float)((double)p.worstTicks * 1000 / SYSCLOCK_ARM11);
+    stats.underruns = p.underruns;
+    stats.buffers = p.buffers;
+    stats.queued = p.queued;
+    stats.minQueued = p.minQueued;
+    stats.avgQueued = p.avgQueued;
+    return stats;
+}
+
+u64 Sound::clock() {
+    return (u64)dspFrames.load(std::memory_order_acquire) * _internal::DSP_FRAME_SAMPLES;
+}
+
+void Sound::setStealMode(voiceSteal mode) {
+    stealMode = mode;
+}
+
+void Sound::setSoftwareMix(int maxPriority) {
+    if (maxPriority < 0) {
+        stopMixer();
+        mixer.maxPriority = -1;
+        return;
+    }
+
+    // Whatever plays on the mixer's channel makes room, it starts once a stream there is closed.
+    if (mixer.maxPriority < 0 && channels[MIX_CHANNEL].active) {
+        if (channels[MIX_CHANNEL].owner) sendCommand({CMD_STOP, (s8)MIX_CHANNEL, false, 0, nullptr});
+        evict(MIX_CHANNEL);
+    }
+
+    mixer.maxPriority = maxPriority;
+    startService(); // Fills the mixer.
+
+    MixerLock lock;
+    startMixer();
+}
+
+voiceStats Sound::getVoiceStats() {
+    voiceStats stats = counters;
+    stats.active = 0;
+    stats.mixed = 0;
+
+    for (int i = 0; i < hardwareVoices(); i++) {
+        if (!isFree(i)) stats.active++;
+    }
+    MixerLock lock;
+    for (const MixVoice& v : mixer.voices) {
+        if (v.clip) stats.mixed++;
+    }
+    return stats;
+}
+
+void Sound::_init() {
+    // Right after ndspInit(), so clock() counts from dsge::init() and not from the first Sound.
+    initSystem();
+}
+
+void Sound::_update() {
+    for (int i = 0; i < CHANNELS; i++) {
+        Sound* owner = channels[i].owner;
+        if (!owner || owner->channel != i) continue;
+
+        owner->time = (int)(owner->getPosition() * 1000);
+
+        ChannelStatus p;
+        AudioChannel& ch = channels[i];
+        if (!readStatus(ch, p) || p.serial != ch.serial || p.rate == 0) continue;
+
+        // Played without waiting for isReady(), it's known once the audio thread started it.
+        if (owner->length == 0) {
+            owner->length = (int)((u64)p.total * 1000 / p.rate);
+        }
+
+        // The audio thread doesn't log, it's way behind already when it grows the buffers.
+        if (p.buffers > ch.loggedBuffers) {
+            if (ch.loggedBuffers != 0) trace("[WARN] Sound: Ran out of buffers, now using " + std::to_string(p.buffers) + ": " + owner->filePath);
+            ch.loggedBuffers = p.buffers;
+        }
+    }
+
+    // Streams the audio thread closed give their channel back right away.
+    for (int i = 0; i < CHANNELS; i++) {
+        AudioChannel& ch = channels[i];
+        if (!ch.active || !ch.owner || ch.streaming.load(std::memory_order_acquire) != 0) continue;
+        reclaim(i);
+    }
+
+    // Also the ones play() reclaimed since the last frame. Taken out first, a callback may play something again.
+    std::vector<std::function<void()>> done;
+    done.swap(completions());
+    for (auto &&callback : done) callback();
+
+    if (mixer.maxPriority >= 0) {
+        MixerLock lock;
+        startMixer();
+    }
+}
+
+void Sound::exit() {
+    stopMixer();
+    mixer.maxPriority = -1;
+    if (mixer.buffer) {
+        MixerLock lock;
+        linearFree(mixer.buffer);
+        mixer.buffer = nullptr;
+    }
+
+    // The audio thread first, streams it drops while they're loading are freed by the loader.
+    if (serviceThreadId) {
+        serviceQuit.store(true, std::memory_order_release);
+        LightEvent_Signal(&s_event);
+        threadJoin(serviceThreadId, UINT64_MAX);
+        threadFree(serviceThreadId);
+        serviceThreadId = nullptr;
+    }
+
+    if (loaderThreadId) {
+        loaderQuit.store(true, std::memory_order_release);
+        LightEvent_Signal(&loaderEvent);
+        threadJoin(loaderThreadId, UINT64_MAX);
+        threadFree(loaderThreadId);
+        loaderThreadId = nullptr;
+    }
+}
+
+SoundEffect::SoundEffect(const std::string& path) :
+    length(0),
+    volume(1),
+    priority(0),
+    maxInstances(0)
+{
+    initSystem();
+    _private.clip = decodeClip(path);
+
+    if (!_private.clip) {
+        trace("[WARN] SoundEffect::SoundEffect: Failed to decode: romfs:/" + path);
+        return;
+    }
+
+    length = (u64)_private.clip->frames * 1000 / _private.clip->rate;
+}
+
+SoundEffect::SoundEffect(const SoundEffect& other) :
+    length(other.length),
+    volume(other.volume),
+    priority(other.priority),
+    maxInstances(other.maxInstances)
+{
+    _private.clip = other._private.clip;
+    if (_private.clip) _private.clip->refs++;
+}
+
+SoundEffect& SoundEffect::operator=(const SoundEffect& other) {
+    if (this == &other) return *this;
+
+    // Plays of the old clip are this effect's no more.
+    stop();
+    if (other._private.clip) other._private.clip->refs++;
+    releaseClip(_private.clip);
+
+    length = other.length;
+    volume = other.volume;
+    priority = other.priority;
+    maxInstances = other.maxInstances;
+    _private.clip = other._private.clip;
+    return *this;
+}
+
+SoundEffect::~SoundEffect() {
+    stop();
+    releaseClip(_private.clip);
+}
+
+int SoundEffect::play() {
+    DSGE_PROFILE_ZONE("SoundEffect::play");
+
+    const _internal::PcmClip* clip = _private.clip;
+    if (!clip) return -1;
+
+    if (maxInstances > 0) limitInstances(clip, maxInstances);
+
+    // Low priority ones go to the mixer rather than taking the channel of something else.
+    int id = freeVoice();
+    if (id == -1 && mixer.maxPriority >= 0 && priority <= mixer.maxPriority && mixClip(clip, this, volume)) return MIX_CHANNEL;
+    if (id == -1) id = stealVoice(priority, false);
+
+    if (id == -1) {
+        counters.drops++;
+        return -1;
+    }
+
+    AudioChannel& ch = channels[id];
+    claimVoice(id, priority, volume);
+    ch.channel_id = id;
+    ch.owner = nullptr;
+    ch.clip = clip;
+    ch.effect = this;
+
+    ndspChnReset(id);
+    ndspChnSetInterp(id, NDSP_INTERP_POLYPHASE);
+    ndspChnSetRate(id, clip->rate);
+    setVolume(id, volume);
+
+    // The whole clip in a single buffer, straight from the shared samples.
+    memset(&ch.effectBuf, 0, sizeof(ch.effectBuf));
+    ch.effectBuf.nsamples = clip->frames;
+
+    if (clip->adpcm) {
+        ch.effectContext = clip->context;
+        ndspChnSetFormat(id, NDSP_FORMAT_MONO_ADPCM);
+        ndspChnSetAdpcmCoefs(id, const_cast<u16*>(clip->coefs)); // Only read.
+        ch.effectBuf.data_adpcm = clip->adpcm;
+        ch.effectBuf.adpcm_data = &ch.effectContext;
+    } else {
+        ndspChnSetFormat(id, clip->channels == 1 ? NDSP_FORMAT_MONO_PCM16 : NDSP_FORMAT_STEREO_PCM16);
+        ch.effectBuf.data_vaddr = clip->samples;
+    }
+    ndspChnWaveBufAdd(id, &ch.effectBuf);
+    return id;
+}
+
+void SoundEffect::stop() {
+    for (int i = 0; i < CHANNELS; i++) {
+        if (channels[i].active && channels[i].effect == this) evict(i);
+    }
+
+    MixerLock lock;
+    for (MixVoice& v : mixer.voices) {
+        if (v.effect == this) v.clip = nullptr;
+    }
+}
+
+int SoundEffect::playing() const {
+    int count = 0;
+    for (int i = 0; i < CHANNELS; i++) {
+        if (channels[i].effect == this && !isFree(i)) count++;
+    }
+    MixerLock lock;
+    for (const MixVoice& v : mixer.voices) {
+        if (v.clip && v.effect == this) count++;
+    }
+    return count;
+}
+
+bool SoundEffect::isLoaded() const {
+    return _private.clip != nullptr;
+}
+
 } // namespace dsge
 
 // Internal implementation
 namespace {
 
-bool fillBuffer(AudioChannel* channel) {
-    for (size_t i = 0; i < 3; ++i) {
-        if (channel->waveBufs[i].status != NDSP_WBUF_DONE) continue;
+void startService() {
+    if (serviceThreadId) return;
 
-        int totalBytes = 0;
-        while ((size_t)totalBytes < channel->waveBufs[i].nsamples * sizeof(int16_t)) {
-            int16_t* buffer = channel->waveBufs[i].data_pcm16 + (totalBytes / sizeof(int16_t));
-            size_t bufferSize = (channel->waveBufs[i].nsamples * sizeof(int16_t) - totalBytes);
+    // Above the game thread, so a slow frame can't starve the DSP.
+    s32 priority = 0x30;
+    svcGetThreadPriority(&priority, CUR_THREAD_HANDLE);
+    priority = (priority - 1 < 0x18) ? 0x18 : priority - 1;
 
-            int bytesRead = ov_read(&channel->vorbisFile, (char*)buffer, bufferSize, nullptr);
-            if (bytesRead <= 0) {
-                if (bytesRead == 0 && channel->loop) {
-                    ov_time_seek(&channel->vorbisFile, 0);
-                    continue;
-                }
-                break;
+    // The system core is mostly idle, decoding there leaves the game it's whole core. The Old 3DS only lets
+    // applications use it after giving them some of it's time, if that doesn't work it shares the game's core.
+    u32 limit = 0;
+    APT_GetAppCpuTimeLimit(&limit);
+    if (limit == 0) APT_SetAppCpuTimeLimit(30);
+
+    if (!silence) {
+        silence = (int16_t*)linearAlloc(LEAD_IN_FRAMES * 2 * sizeof(int16_t));
+        if (silence) {
+            memset(silence, 0, LEAD_IN_FRAMES * 2 * sizeof(int16_t));
+            DSP_FlushDataCache(silence, LEAD_IN_FRAMES * 2 * sizeof(int16_t));
+        }
+    }
+
+    serviceQuit.store(false, std::memory_order_release);
+    serviceThreadId = threadCreate(serviceThread, nullptr, 32 * 1024, priority, 1, false);
+    if (!serviceThreadId) serviceThreadId = threadCreate(serviceThread, nullptr, 32 * 1024, priority, -2, false);
+    if (!serviceThreadId) trace("[WARN] Sound::play: Could not start the audio thread!");
+}
+
+void startLoader() {
+    if (loaderThreadId) return;
+
+    // Below the game thread on it's core, so it only runs while the game waits for the screen.
+    s32 priority = 0x30;
+    svcGetThreadPriority(&priority, CUR_THREAD_HANDLE);
+    priority = (priority + 1 > 0x3F) ? 0x3F : priority + 1;
+
+    LightEvent_Init(&loaderEvent, RESET_ONESHOT);
+    loaderQuit.store(false, std::memory_order_release);
+    loaderThreadId = threadCreate(loaderThread, nullptr, 32 * 1024, priority, -2, false);
+}
+
+void freeStream(SoundStream* stream) {
+    if (stream->opened) ov_clear(&stream->vorbisFile);
+    if (stream->file) fclose(stream->file);
+    if (stream->audioBuffer) linearFree(stream->audioBuffer);
+    delete stream;
+}
+
+// Called by whoever owns the stream, if the loader is still on it the loader frees it once it's done.
+void releaseStream(SoundStream* stream) {
+    if (stream->state.exchange(STREAM_DISCARDED, std::memory_order_acq_rel) != STREAM_LOADING) freeStream(stream);
+}
+
+// Decodes into wave buffer `i`, returns false at the end of the file.
+bool decodeVorbis(SoundStream* stream, int i) {
+    char* buffer = (char*)stream->audioBuffer + i * stream->bufferSize;
+    size_t bufferSize = stream->bufferSize;
+    size_t totalBytes = 0;
+    bool rewound = false; // An empty file would loop forever otherwise.
+    u32 fileStart = (u32)ov_pcm_tell(&stream->vorbisFile);
+
+    while (totalBytes < bufferSize) {
+        int bytesRead = ov_read(&stream->vorbisFile, buffer + totalBytes, bufferSize - totalBytes, nullptr);
+        if (bytesRead <= 0) {
+            if (bytesRead == 0 && stream->loop && !rewound) {
+                ov_pcm_seek(&stream->vorbisFile, 0);
+                rewound = true;
+                continue;
             }
-            totalBytes += bytesRead;
+            break;
         }
+        totalBytes += bytesRead;
+        rewound = false;
+    }
+
+    if (totalBytes == 0) {
+        stream->eof = true;
+        return false;
+    }
+
+    ndspWaveBuf& waveBuf = stream->waveBufs[i];
+    waveBuf.data_vaddr = buffer;
+    waveBuf.nsamples = totalBytes / stream->frameSize;
+    DSP_FlushDataCache(buffer, totalBytes);
 
-        if (totalBytes == 0) return false;
+    // Buffers are always queued in the order they're decoded.
+    stream->starts[i] = stream->queued;
+    stream->fileStarts[i] = fileStart;
+    stream->queued += waveBuf.nsamples;
+    return true;
+}
 
-        channel->waveBufs[i].nsamples = totalBytes / sizeof(int16_t);
-        ndspChnWaveBufAdd(channel->channel_id, &channel->waveBufs[i]);
-        DSP_FlushDataCache(channel->waveBufs[i].data_pcm16, totalBytes);
+// Reads the next frames into wave buffer `i` as they are, the DSP decodes them. Returns false at the end of the file.
+bool readAdpcm(SoundStream* stream, int i) {
+    const dsge::_internal::AdpcmHeader& header = stream->adpcm;
+    bool loopPoints = stream->loop && header.loopEnd != 0;
+    u32 end = loopPoints ? header.loopEnd : header.samples;
+
+    if (stream->next >= end) {
+        if (!stream->loop || end == 0) {
+            stream->eof = true;
+            return false;
+        }
+
+        // Jumps back, the DSP can't guess the samples before the loop start so it gets them.
+        stream->next = loopPoints ? header.loopStart : 0;
+        stream->context = stream->loopContext;
+        stream->discontinuity = true;
+    }
+
+    u32 count = std::min(stream->bufferFrames, end - stream->next);
+    u32 bytes = dsge::_internal::adpcmBytes(count);
+    long offset = header.dataOffset + stream->next / dsge::_internal::ADPCM_FRAME_SAMPLES * dsge::_internal::ADPCM_FRAME_BYTES;
+    u8* buffer = (u8*)stream->audioBuffer + i * stream->bufferSize;
+
+    // Usually right where the last read left it.
+    if (ftell(stream->file) != offset) fseek(stream->file, offset, SEEK_SET);
+    if (fread(buffer, 1, bytes, stream->file) != bytes) {
+        trace("[WARN] Sound: Could not read from: " + stream->path);
+        stream->eof = true;
+        return false;
+    }
+
+    ndspWaveBuf& waveBuf = stream->waveBufs[i];
+    waveBuf.data_adpcm = buffer;
+    waveBuf.nsamples = count;
+    waveBuf.adpcm_data = nullptr;
+    if (stream->discontinuity) {
+        stream->contexts[i] = stream->context;
+        waveBuf.adpcm_data = &stream->contexts[i];
+        stream->discontinuity = false;
     }
+    DSP_FlushDataCache(buffer, bytes);
+
+    stream->starts[i] = stream->queued;
+    stream->fileStarts[i] = stream->next;
+    stream->queued += count;
+    stream->next += count;
     return true;
 }
 
-void audioThread(void* arg) {
-    AudioChannel* channel = (AudioChannel*)arg;
-    while (!channel->quit && fillBuffer(channel)) {
-        LightEvent_Wait(&s_event);
+bool decodeBuffer(SoundStream* stream, int i) {
+    u64 start = svcGetSystemTick();
+    bool filled = stream->format == FORMAT_ADPCM ? readAdpcm(stream, i) : decodeVorbis(stream, i);
+
+    u64 ticks = svcGetSystemTick() - start;
+    stream->decodeTicks += ticks;
+    if (ticks > stream->worstTicks) stream->worstTicks = ticks;
+    if (filled) {
+        stream->decoded += stream->waveBufs[i].nsamples;
+        stream->filled++;
     }
+    return filled;
 }
 
-bool audioInit(AudioChannel* channel) {
-    vorbis_info* vi = ov_info(&channel->vorbisFile, -1);
+// Goes back to the start of the file or the loop start, for a stream that ended before it was set to loop.
+void rewindStream(SoundStream* stream) {
+    if (stream->format == FORMAT_ADPCM) {
+        stream->next = stream->adpcm.loopEnd != 0 ? stream->adpcm.loopStart : 0;
+        stream->context = stream->loopContext;
+        stream->discontinuity = true;
+    } else {
+        ov_pcm_seek(&stream->vorbisFile, 0);
+    }
+    stream->eof = false;
+}
 
-    ndspChnReset(channel->channel_id);
-    ndspChnSetInterp(channel->channel_id, NDSP_INTERP_POLYPHASE);
-    ndspChnSetRate(channel->channel_id, vi->rate);
-    ndspChnSetFormat(channel->channel_id, vi->channels == 1 ? NDSP_FORMAT_MONO_PCM16 : NDSP_FORMAT_STEREO_PCM16);
+// Decodes every buffer again from `ms` into the file, nothing of the stream may be queued.
+void seekStream(SoundStream* stream, u32 ms) {
+    u64 sample = (u64)ms * stream->rate / 1000;
+    if (stream->total != 0 && sample >= stream->total) sample = stream->total - 1;
 
-    const size_t SAMPLES_PER_BUF = vi->rate * 120 / 1000;
-    const size_t CHANNELS_PER_SAMPLE = vi->channels;
-    const size_t WAVEBUF_SIZE = SAMPLES_PER_BUF * CHANNELS_PER_SAMPLE * sizeof(int16_t);
-    const size_t bufferSize = WAVEBUF_SIZE * 3;
+    if (stream->format == FORMAT_ADPCM) {
+        // Only to the start of a frame, 14 samples at most before it.
+        u32 frame = (u32)sample / dsge::_internal::ADPCM_FRAME_SAMPLES;
+        stream->next = frame * dsge::_internal::ADPCM_FRAME_SAMPLES;
+        stream->discontinuity = true;
+        if (!dsge::_internal::adpcmContext(stream->file, stream->adpcm, frame, stream->context)) stream->next = stream->total;
+    } else {
+        ov_pcm_seek(&stream->vorbisFile, sample);
+    }
+    stream->eof = false;
+    stream->primed = 0;
+    for (int i = 0; i < MAX_BUFFERS; i++) stream->waveBufs[i].status = NDSP_WBUF_DONE;
+}
 
-    channel->audioBuffer = (int16_t*)linearAlloc(bufferSize);
-    if (!channel->audioBuffer) return false;
+// Everything that reads the SD card or parses the file, done before the stream gets near the DSP.
+void loadStream(SoundStream* stream) {
+    DSGE_PROFILE_ZONE("loadStream");
 
-    memset(&channel->waveBufs, 0, sizeof(channel->waveBufs));
-    int16_t* buffer = channel->audioBuffer;
+    auto done = [&](u8 result) {
+        if (stream->state.exchange(result, std::memory_order_acq_rel) == STREAM_DISCARDED) freeStream(stream);
+    };
 
-    for (size_t i = 0; i < 3; ++i) {
-        channel->waveBufs[i].data_vaddr = buffer;
-        channel->waveBufs[i].nsamples = WAVEBUF_SIZE / sizeof(buffer[0]);
-        channel->waveBufs[i].status = NDSP_WBUF_DONE;
-        buffer += WAVEBUF_SIZE / sizeof(buffer[0]);
+    if (stream->state.load(std::memory_order_acquire) == STREAM_DISCARDED) {
+        freeStream(stream);
+        return;
     }
 
-    return true;
+    FILE* fh = fopen(stream->path.c_str(), "rb");
+    if (!fh) {
+        trace("[WARN] Sound::preload: Could not open file: " + stream->path);
+        done(STREAM_FAILED);
+        return;
+    }
+
+    stream->format = formatOf(stream->path);
+    if (stream->format == FORMAT_ADPCM) {
+        stream->file = fh;
+        dsge::_internal::AdpcmHeader& header = stream->adpcm;
+        bool ok = dsge::_internal::readAdpcmHeader(fh, header) && header.samples != 0;
+        u32 loopFrame = header.loopEnd != 0 ? header.loopStart / dsge::_internal::ADPCM_FRAME_SAMPLES : 0;
+        ok = ok && dsge::_internal::adpcmContext(fh, header, 0, stream->context);
+        ok = ok && dsge::_internal::adpcmContext(fh, header, loopFrame, stream->loopContext);
+        if (!ok) {
+            trace("[WARN] Sound::preload: Not a valid ADPCM file: " + stream->path);
+            done(STREAM_FAILED);
+            return;
+        }
+
+        stream->rate = header.rate;
+        stream->channels = 1;
+        stream->total = header.samples;
+
+        // Whole frames, so only the last buffer of the file ends in the middle of one.
+        u32 frames = header.rate * stream->bufferMs / 1000 / dsge::_internal::ADPCM_FRAME_SAMPLES;
+        stream->bufferFrames = std::max<u32>(frames, 1) * dsge::_internal::ADPCM_FRAME_SAMPLES;
+        stream->bufferSize = dsge::_internal::adpcmBytes(stream->bufferFrames);
+    } else {
+        if (ov_open(fh, &stream->vorbisFile, nullptr, 0) != 0) {
+            trace("[WARN] Sound::preload: Not an Ogg Vorbis file: " + stream->path);
+            fclose(fh);
+            done(STREAM_FAILED);
+            return;
+        }
+        stream->opened = true;
+
+        vorbis_info* vi = ov_info(&stream->vorbisFile, -1);
+        stream->rate = vi->rate;
+        stream->channels = vi->channels;
+        stream->total = (u32)ov_pcm_total(&stream->vorbisFile, -1);
+
+        // nsamples counts sample frames, not values.
+        stream->bufferFrames = std::max<u32>(vi->rate * stream->bufferMs / 1000, 1);
+        stream->frameSize = vi->channels * sizeof(int16_t);
+        stream->bufferSize = stream->bufferFrames * stream->frameSize;
+    }
+
+    stream->audioBuffer = (int16_t*)linearAlloc(stream->bufferSize * stream->capacity);
+    if (!stream->audioBuffer) {
+        done(STREAM_FAILED);
+        return;
+    }
+
+    memset(stream->waveBufs, 0, sizeof(stream->waveBufs));
+    for (int i = 0; i < MAX_BUFFERS; i++) stream->waveBufs[i].status = NDSP_WBUF_DONE;
+
+    stream->progress.store(1.0f / (stream->buffers + 1), std::memory_order_relaxed);
+
+    for (int i = 0; i < stream->buffers; i++) {
+        if (loaderQuit.load(std::memory_order_relaxed)) break;
+        if (stream->state.load(std::memory_order_relaxed) == STREAM_DISCARDED) break;
+        if (!decodeBuffer(stream, i)) break;
+
+        stream->primed++;
+        stream->progress.store((float)(i + 2) / (stream->buffers + 1), std::memory_order_relaxed);
+    }
+
+    stream->progress.store(1, std::memory_order_relaxed);
+    done(stream->primed != 0 ? STREAM_READY : STREAM_FAILED);
 }
 
-void stopChannel(AudioChannel* channel) {
-    if (!channel) return;
-    channel->quit = true;
-    LightEvent_Signal(&s_event);
+void loaderThread(void*) {
+    DSGE_PROFILE_THREAD("Loader");
+
+    while (true) {
+        LightEvent_Wait(&loaderEvent);
+
+        SoundStream* stream;
+        while (loads.pop(stream)) loadStream(stream);
+
+        if (loaderQuit.load(std::memory_order_acquire)) break;
+    }
 }
 
-void audioExit(AudioChannel* channel) {
-    ndspChnReset(channel->channel_id);
-    if (channel->audioBuffer) {
-        linearFree(channel->audioBuffer);
-        channel->audioBuffer = nullptr;
+void publishStatus(AudioChannel* channel, const ChannelStatus& status) {
+    u32 seq = channel->statusSeq.load(std::memory_order_relaxed);
+    channel->statusSeq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    channel->status = status;
+    channel->statusSeq.store(seq + 2, std::memory_order_release);
+}
+
+// Reads what the DSP actually played, from the buffer it's on and how far into it it is.
+void updateStatus(AudioChannel* channel) {
+    SoundStream* stream = channel->stream;
+    int id = channel->channel_id;
+
+    ChannelStatus p = channel->status;
+    p.rate = stream->rate;
+    p.total = stream->total;
+    p.tick = svcGetSystemTick();
+    p.running = dsge::_internal::bufferPosition(stream->waveBufs, stream->starts, stream->fileStarts, MAX_BUFFERS,
+        ndspChnGetWaveBufSeq(id), ndspChnGetSamplePos(id), stream->total, p.played, p.file) && !channel->paused;
+    p.decodeTicks = stream->decodeTicks;
+    p.decoded = stream->decoded;
+    p.worstTicks = stream->worstTicks;
+    p.filled = stream->filled;
+    p.underruns = stream->underruns;
+    p.buffers = stream->buffers;
+    p.queued = stream->queuedNow;
+    p.minQueued = stream->looks != 0 ? stream->minQueued : stream->queuedNow;
+    p.avgQueued = stream->looks != 0 ? (float)stream->queuedSum / stream->looks : stream->queuedNow;
+
+    publishStatus(channel, p);
+}
+
+// Queues what the loader decoded, from then on the audio thread keeps it going. `frameStart` is the DSP clock at
+// the start of the frame the channel starts on.
+void startStream(AudioChannel* channel, u64 frameStart) {
+    SoundStream* stream = channel->stream;
+    int id = channel->channel_id;
+
+    // Everything the loader decoded is thrown away, but it was opened and parsed already.
+    if (channel->startFrom != 0) {
+        seekStream(stream, channel->startFrom);
+        stream->queued = 0;
+        for (int i = 0; i < stream->buffers && decodeBuffer(stream, i); i++) stream->primed++;
+    }
+
+    ndspChnReset(id);
+    ndspChnSetInterp(id, NDSP_INTERP_POLYPHASE);
+    ndspChnSetRate(id, stream->rate);
+    if (stream->format == FORMAT_ADPCM) {
+        ndspChnSetFormat(id, NDSP_FORMAT_MONO_ADPCM);
+        ndspChnSetAdpcmCoefs(id, stream->adpcm.coefs);
+    } else {
+        ndspChnSetFormat(id, stream->channels == 1 ? NDSP_FORMAT_MONO_PCM16 : NDSP_FORMAT_STEREO_PCM16);
+    }
+    ndspChnSetPaused(id, channel->paused);
+    setVolume(id, channel->volume);
+
+    // The loader stops at the end of the file, a loop goes on from the start.
+    stream->loop = channel->loop;
+    if (stream->eof && stream->loop) rewindStream(stream);
+
+    // Silence up to the exact sample it was scheduled for, every sound scheduled for the same time starts in
+    // the same DSP frame after the same amount of it.
+    if (channel->startAt != 0 && silence) {
+        memset(&channel->leadIn, 0, sizeof(channel->leadIn));
+        channel->leadIn.data_vaddr = silence;
+        channel->leadIn.nsamples = dsge::_internal::leadInSamples(channel->startAt, frameStart, stream->rate);
+        if (channel->leadIn.nsamples > LEAD_IN_FRAMES) channel->leadIn.nsamples = LEAD_IN_FRAMES;
+        ndspChnWaveBufAdd(id, &channel->leadIn);
+    }
+
+    for (int i = 0; i < stream->primed; i++) ndspChnWaveBufAdd(id, &stream->waveBufs[i]);
+    channel->started = true;
+
+    ChannelStatus p = channel->status;
+    p.file = (u64)channel->startFrom * stream->rate / 1000;
+    p.running = false;
+    publishStatus(channel, p);
+    updateStatus(channel);
+}
+
+void closeStream(AudioChannel* channel) {
+    if (!channel->stream) return;
+
+    if (channel->started) ndspChnReset(channel->channel_id);
+    releaseStream(channel->stream);
+    channel->stream = nullptr;
+    channel->started = false;
+
+    u32 serial = channel->playSerial;
+    channel->streaming.compare_exchange_strong(serial, 0, std::memory_order_acq_rel);
+}
+
+void runCommands() {
+    Command cmd;
+    while (commands.pop(cmd)) {
+        AudioChannel* channel = &channels[(int)cmd.channel];
+
+        switch (cmd.type) {
+            case CMD_PLAY: {
+                closeStream(channel);
+                channel->playSerial = cmd.serial;
+                channel->channel_id = cmd.channel;
+                channel->stream = cmd.stream;
+                channel->started = false;
+                channel->loop = cmd.loop;
+                channel->paused = false;
+                channel->volume = cmd.volume;
+                channel->startAt = cmd.at;
+                channel->startFrom = cmd.time;
+
+                // Nothing played yet, the rate is only known once it's loaded.
+                ChannelStatus p = {};
+                p.serial = cmd.serial;
+                publishStatus(channel, p);
+                break;
+            }
+            case CMD_SEEK: {
+                if (!channel->stream) break;
+                if (!channel->started) {
+                    channel->startFrom = cmd.time;
+                    break;
+                }
+
+                // Keeps counting from what was played, the new buffers just come from somewhere else in the file.
+                updateStatus(channel);
+                ndspChnWaveBufClear(cmd.channel);
+                seekStream(channel->stream, cmd.time);
+                channel->stream->queued = channel->status.played;
+                fillBuffer(channel->stream, cmd.channel, true);
+
+                ChannelStatus p = channel->status;
+                p.file = (u64)cmd.time * channel->stream->rate / 1000;
+                p.running = false;
+                publishStatus(channel, p);
+                break;
+            }
+            case CMD_STOP:
+                closeStream(channel);
+                break;
+            // The rest only apply to a stream that's still open, the channel may belong to a SoundEffect by now.
+            case CMD_PAUSE:
+            case CMD_RESUME:
+                channel->paused = cmd.type == CMD_PAUSE;
+                if (channel->started) ndspChnSetPaused(cmd.channel, channel->paused);
+                break;
+            case CMD_VOLUME:
+                channel->volume = cmd.volume;
+                if (channel->started) setVolume(cmd.channel, cmd.volume);
+                break;
+        }
+    }
+}
+
+u8 queuedBuffers(SoundStream* stream) {
+    u8 queued = 0;
+    for (int b = 0; b < MAX_BUFFERS; b++) queued += stream->waveBufs[b].status != NDSP_WBUF_DONE;
+    return queued;
+}
+
+// Queue depth as the audio thread wakes up, before it tops the stream up.
+void sampleQueue(SoundStream* stream) {
+    u8 queued = queuedBuffers(stream);
+    stream->queuedNow = queued;
+    stream->minQueued = std::min(stream->minQueued, queued);
+    stream->queuedSum += queued;
+    stream->looks++;
+}
+
+// `emptied` is for a queue that got cleared on purpose, like by a seek, so it isn't counted as an underrun.
+bool fillBuffer(SoundStream* stream, int channel, bool emptied) {
+    DSGE_PROFILE_ZONE("fillBuffer");
+
+    for (int i = 0; i < stream->buffers && !stream->eof; ++i) {
+        if (stream->waveBufs[i].status != NDSP_WBUF_DONE) continue;
+        if (!decodeBuffer(stream, i)) continue;
+
+        // Nothing left queued once it's ready means the DSP played silence waiting for it. A slow decode shows up
+        // here and not in `sampleQueue()`, as the buffers it waited on get refilled right after it.
+        if (!emptied && queuedBuffers(stream) == 0) {
+            stream->underruns++;
+            if (stream->adaptive && stream->buffers < stream->capacity) {
+                stream->buffers++; // Logged by Sound::_update(), nothing gets allocated here.
+            }
+        }
+        emptied = false;
+        ndspChnWaveBufAdd(channel, &stream->waveBufs[i]);
     }
+    return !stream->eof;
+}
+
+void serviceThread(void*) {
+    DSGE_PROFILE_THREAD("Audio");
+
+    // Woken up by every DSP frame and every command, all streams get topped up each time.
+    while (!serviceQuit.load(std::memory_order_acquire)) {
+        LightEvent_Wait(&s_event);
+        runCommands();
+
+        // Buffers queued now are first played in the next DSP frame.
+        u64 nextFrame = dsge::Sound::clock() + dsge::_internal::DSP_FRAME_SAMPLES;
+
+        for (int i = 0; i < CHANNELS; i++) {
+            AudioChannel* channel = &channels[i];
+            SoundStream* stream = channel->stream;
+            if (!stream) continue;
+
+            if (!channel->started) {
+                u8 state = stream->state.load(std::memory_order_acquire);
+                if (state == STREAM_READY && channel->startAt < nextFrame + dsge::_internal::DSP_FRAME_SAMPLES) {
+                    startStream(channel, nextFrame);
+                }
+                else if (state != STREAM_LOADING && state != STREAM_READY) closeStream(channel);
+                continue;
+            }
+
+            if (!stream->eof && !channel->paused) sampleQueue(stream);
+            if (!stream->eof) fillBuffer(stream, i);
+            updateStatus(channel);
+            if (!stream->eof) continue;
+
+            // Done once the DSP played what was queued.
+            bool done = true;
+            for (int b = 0; b < MAX_BUFFERS; b++) done &= stream->waveBufs[b].status == NDSP_WBUF_DONE;
+            if (done) closeStream(channel);
+        }
+
+        MixerLock lock;
+        fillMixer();
+    }
+
+    runCommands();
+    for (int i = 0; i < CHANNELS; i++) closeStream(&channels[i]);
 }
 
-} // namespace
\ No newline at end of file
+} // namespace
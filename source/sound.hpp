@@ -2,12 +2,50 @@
 #define DSGE_SOUND_HPP
 
 #include "dsge.hpp"
+#include "soundclock.hpp"
+
+typedef enum {
+    STEAL_OLDEST = 0,   // The play that started first makes room.
+    STEAL_QUIETEST = 1  // The play with the lowest volume makes room.
+} voiceSteal;
+
+// Counters of the voice allocator, see dsge::Sound::getVoiceStats().
+struct voiceStats {
+    u8  active; // Hardware channels playing something.
+    u8  mixed;  // SoundEffects playing on the software mixer.
+    u32 steals; // Plays that took the channel of another one.
+    u32 drops;  // Plays that got no channel and weren't played.
+};
+
+typedef enum {
+    LATENCY_LOW = 0,    // 4 buffers of 20ms, starts the soonest when it isn't preloaded.
+    LATENCY_NORMAL = 1, // 3 buffers of 120ms (default)
+    LATENCY_SAFE = 2,   // 4 buffers of 250ms, for music while the game reads a lot from the SD card.
+    LATENCY_AUTO = 3    // 3 buffers of 40ms, one more after every underrun, up to 8.
+} soundLatency;
+
+// What playing a Sound cost so far and how close it got to running out, see dsge::Sound::getStats().
+struct soundStats {
+    float decodeMs;      // Time the CPU spent decoding or reading it's buffers, in milliseconds.
+    float audioSeconds;  // Audio those buffers hold, in seconds.
+    float bufferMs;      // Average time per buffer, in milliseconds.
+    float worstBufferMs; // Slowest buffer, in milliseconds.
+    u32   underruns;     // Times the DSP played every buffer before the next one was ready.
+    u8    buffers;       // Buffers it uses, grows after underruns with LATENCY_AUTO.
+    u8    queued;        // Buffers waiting for the DSP right now, 0 is an underrun.
+    u8    minQueued;     // Fewest of them since it started.
+    float avgQueued;     // Average of them since it started.
+};
 
 namespace dsge {
+namespace _internal {
+    struct PcmClip;
+    struct SoundStream;
+}
 
 /**
  * @class Sound
- * @brief Handles audio playback for Ogg Vorbis files on the Nintendo 3DS
+ * @brief Handles audio playback for Ogg Vorbis and DSP-ADPCM files on the Nintendo 3DS
  * 
  * This class provides a simple interface for loading and playing sound files,
  * with support for playback control, volume adjustment, and looping.
@@ -21,6 +59,16 @@ namespace dsge {
  *   - Channels: 1 (mono) or 2 (stereo)
  * 
  *   - Bitrate: ANY
+ * 
+ * - DSGE ADPCM (.adpcm), made with `adpcm.py` in the root of this repo:
+ * 
+ *   - Decoded by the DSP itself, so it takes no CPU time besides reading the file. About 3.5 times bigger than Ogg.
+ * 
+ *   - Channels: 1 (mono) only
+ * 
+ *   - Loop points from the file are used when `loop` is true.
+ * 
+ * The format is picked from the file extension.
  */
 class Sound {
 public:
@@ -32,6 +80,10 @@ public:
      * 
      * `ffmpeg -i input.ogg -c:a libvorbis -ar 44100 -ac 1 output.ogg`
      * 
+     * #### ADPCM Conversion Command:
+     * 
+     * `python adpcm.py input.wav output.adpcm --rate 32000 --loop 44100 882000`
+     * 
      * #### Example Usage:
      * ```
      * // Load a sound from romfs:/sounds/effect.ogg
@@ -41,6 +93,68 @@ public:
      */
     Sound(const std::string& path);
 
+    // Copies don't share the channel or a preloaded stream.
+    Sound(const Sound& other);
+    Sound& operator=(const Sound& other);
+
+    /**
+     * @brief Opens the file and decodes the first buffers on a background thread, so `play()` starts right away
+     * 
+     * Reading and parsing the Ogg headers from romfs takes about 100ms, do it during a loading screen or a
+     * transition instead. Does nothing if it's already preloaded.
+     * 
+     * #### Example Usage:
+     * ```
+     * dsge::Sound bgm("music/level2.ogg");
+     * bgm.preload();
+     * 
+     * while (dsge::render() && !bgm.isReady()) {
+     *     loadingBar.scale.x = bgm.loadProgress();
+     * }
+     * 
+     * bgm.play(); // Starts on the next DSP frame.
+     * ```
+     */
+    void preload();
+
+    /**
+     * @brief Checks if `preload()` is done and `play()` will start right away.
+     *
+     * The file is only read by the loader, so `length` is set from here on.
+     */
+    bool isReady();
+
+    /**
+     * @brief How far `preload()` got, from 0.0 to 1.0, 0.0 if it isn't preloading.
+     */
+    float loadProgress() const;
+
+    /**
+     * @brief Picks how much is decoded ahead of the DSP, from the next `preload()` or `play()` on
+     * @param profile One of `soundLatency`, `LATENCY_NORMAL` by default
+     * 
+     * Fewer and shorter buffers start sooner when the sound isn't preloaded and take less memory, but run out
+     * quicker when the audio thread can't keep up. Check `getStats().underruns` to tune it.
+     * 
+     * #### Example Usage:
+     * ```
+     * dsge::Sound hit("sounds/hit.ogg");
+     * hit.setLatency(LATENCY_LOW);
+     * 
+     * dsge::Sound bgm("music/stage1.ogg");
+     * bgm.setLatency(LATENCY_AUTO); // Grows it's buffering if it ever runs out.
+     * ```
+     */
+    void setLatency(soundLatency profile);
+
+    /**
+     * @brief Same as above but with the buffers given directly
+     * @param buffers Wave buffers, from 2 to 8
+     * @param bufferMs Milliseconds of audio per buffer
+     * @param adaptive Adds a buffer after every underrun, up to 8
+     */
+    void setLatency(u8 buffers, u16 bufferMs, bool adaptive = false);
+
     /**
      * @brief Starts playback of the sound
      * 
@@ -48,9 +162,7 @@ public:
      * 
      * If the sound is at the end, it will restart from the beginning.
      * 
-     * #### Warning:
-     * 
-     * Will cause slight stutters but it's for like 100ms.
+     * Never waits on the file, if it isn't preloaded it's loaded in the background and starts once it's ready.
      * 
      * #### Example Usage:
      * ```
@@ -59,6 +171,23 @@ public:
      * ```
      */
     void play();
+
+    /**
+     * @brief Starts playback at an exact time of the DSP clock, so sounds can start in sync with each other
+     * @param clockTime When to start, from `Sound::clock()`. 0 or a time that already passed starts right away.
+     * 
+     * Every sound given the same time starts on the same sample, as long as they're loaded by then and the time
+     * is at least 2 DSP frames (about 10ms) away. `preload()` them first.
+     * 
+     * #### Example Usage:
+     * ```
+     * // Drums and bass start together half a second from now.
+     * u64 start = dsge::Sound::clock() + 32728 / 2;
+     * drums.playAt(start);
+     * bass.playAt(start);
+     * ```
+     */
+    void playAt(u64 clockTime);
     
     /**
      * @brief Pauses the sound playback
@@ -98,19 +227,204 @@ public:
      */
     void stop();
 
-    int length;   // Total duration of the sound in milliseconds (read-only)
-    int time;     // Current playback position in milliseconds (read-only)
-    float volume; // Playback volume (0.0 = silent, 1.0 = full volume)
+    /**
+     * @brief Changes the volume, also while it's playing
+     * @param value 0.0 = silent, 1.0 = full volume
+     * 
+     * #### Example Usage:
+     * ```
+     * bgm.setVolume(0.5); // Half as loud.
+     * ```
+     */
+    void setVolume(float value);
+
+    /**
+     * @brief Jumps to a position, while playing or for the next `play()`
+     * @param ms Milliseconds into the file
+     * 
+     * Seeking doesn't decode everything up to it, it only takes a few reads even in long files.
+     * 
+     * #### Example Usage:
+     * ```
+     * song.seek(30000); // Practice from the chorus.
+     * song.play();
+     * ```
+     */
+    void seek(int ms);
+
+    /**
+     * @brief Where it is in the file in seconds, from the samples the DSP actually played
+     * 
+     * Read from the DSP once per DSP frame (about 5ms) and moved on by the time since then, so it's smooth between
+     * frames. Use it to place notes in a rhythm game, `time` is the same but only updated once per frame in
+     * milliseconds.
+     */
+    double getPosition() const;
+
+    /**
+     * @brief Samples played since it started, loops and seeks don't reset it
+     */
+    u64 getSamplesPlayed() const;
+
+    /**
+     * @brief The beat it's on, with it's fraction
+     * @param bpm Beats per minute of the song
+     * @param offset Milliseconds into the file where beat 0 is
+     * 
+     * #### Example Usage:
+     * ```
+     * float beat = song.getBeat(128, 250);
+     * metronome.scale.set(1 + 0.2 * (1 - (beat - floorf(beat))), 1); // Pops on every beat.
+     * ```
+     */
+    float getBeat(float bpm, float offset = 0) const;
+
+    /**
+     * @brief How much CPU time the current play took so far and how close it got to running out of audio
+     * 
+     * Counts decoding for Ogg Vorbis and reading the file for ADPCM, zeroes if it isn't playing. `queued` is read
+     * once per DSP frame, read it every frame to see it over time.
+     * 
+     * #### Example Usage:
+     * ```
+     * soundStats s = bgm.getStats();
+     * trace(TSA(s.decodeMs / s.audioSeconds) + " ms of CPU per second of audio");
+     * trace(TSA(s.underruns) + " underruns, worst buffer took " + TSA(s.worstBufferMs) + " ms");
+     * ```
+     */
+    soundStats getStats() const;
+
+    /**
+     * @brief Samples the DSP played since `dsge::init()`, at 32728 Hz, see `playAt()`
+     */
+    static u64 clock();
+
+    /**
+     * @brief What makes room for a new play once all 24 channels are busy, `STEAL_OLDEST` by default
+     * 
+     * Only plays of the same or a lower `priority` are ever stopped for it, a play that finds none is dropped.
+     * SoundEffects only take the channels of other SoundEffects.
+     */
+    static void setStealMode(voiceSteal mode);
+
+    /**
+     * @brief Mixes SoundEffects on the CPU into one shared channel once the others are all busy
+     * @param maxPriority SoundEffects of this `priority` or lower go to the mixer before stealing a channel, -1 turns it off (default)
+     * 
+     * The mixer takes the last channel, whatever plays on it stops. It plays up to 16 SoundEffects at once, about 60ms
+     * later than a channel of their own would, so it's made for footsteps, bullets and other sounds that are played a lot.
+     * It's mixed on the audio thread, slow frames of the game don't make it run out.
+     * 
+     * #### Example Usage:
+     * ```
+     * dsge::Sound::setSoftwareMix(0);
+     * 
+     * dsge::SoundEffect step("sounds/step.ogg");  // priority 0, mixed once the channels run out.
+     * dsge::SoundEffect alarm("sounds/alarm.ogg");
+     * alarm.priority = 10;                          // Always gets a channel, stealing one if it has to.
+     * ```
+     */
+    static void setSoftwareMix(int maxPriority);
+
+    /**
+     * @brief Counters of the voice allocator.
+     */
+    static voiceStats getVoiceStats();
+
+    static void _init();
+    static void _update();
+
+    /**
+     * @brief Stops every sound and the audio thread, called by `dsge::exit()`.
+     */
+    static void exit();
+
+    ~Sound();
+
+    int length;   // Total duration of the sound in milliseconds, 0 until `isReady()` is true or it started playing (read-only)
+    int time;     // Current playback position in milliseconds, updated every frame (read-only)
+    float volume; // Playback volume (0.0 = silent, 1.0 = full volume), use setVolume() while it's playing
     bool loop;    // Whether the sound should loop automatically (default: false)
-    std::function<void()> onComplete = nullptr; // If audio is completed, it triggers this variable.
+    int priority; // Higher ones steal the channels of lower ones once all are busy (default: 0)
+    std::function<void()> onComplete = nullptr; // Called from `dsge::render()` once it played to the end, never if it loops.
     
     int channel;
     bool isPlaying;
     bool isPaused;
 private:
     std::string filePath;
-    
-    void calculateLength();
+    _internal::SoundStream* stream; // Preloaded, given to the audio thread once it plays.
+    int seekTo;                     // Where the next play starts, in milliseconds.
+    u8 buffers;                     // Latency profile, see `setLatency()`.
+    u16 bufferMs;
+    bool adaptive;
+};
+
+/**
+ * @class SoundEffect
+ * @brief A short sound that's decoded once and kept in memory, for sounds played over and over again.
+ *
+ * Unlike `Sound`, playing doesn't read the file, start a thread or allocate anything, it only queues the already
+ * decoded clip on a free channel. So it's made for hits, jumps, coins and anything under a few seconds.
+ *
+ * Every SoundEffect of the same file shares the decoded clip, it's freed once the last one is destroyed.
+ *
+ * #### Example Usage:
+ * ```
+ * dsge::SoundEffect coin("sounds/coin.ogg"); // Decoded here, while loading.
+ *
+ * while (dsge::render()) {
+ *     if (dsge::Input::isDown(KEY_A)) {
+ *         coin.play(); // Can be played again before the last one is done.
+ *     }
+ * }
+ * ```
+ */
+class SoundEffect {
+public:
+    int   length;       // Duration of the clip in milliseconds (read-only)
+    float volume;       // Volume of the next plays (0.0 = silent, 1.0 = full volume)
+    int   priority;     // Higher ones steal the channels of lower ones once all are busy (default: 0)
+    int   maxInstances; // Most plays of the clip at once, the oldest one stops for a new one. 0 for no limit (default)
+
+    struct {
+        _internal::PcmClip* clip; // Shared decoded clip, nullptr if it failed to load.
+    } _private;
+
+    /**
+     * @brief Decodes an Ogg Vorbis file or reads an ADPCM file, unless another SoundEffect already did.
+     * @param path Path to the .ogg or .adpcm file in romfs (e.g., "sounds/effect.ogg")
+     *
+     * Decoding takes about as long as the clip plays, do it while loading. A 1 second mono clip at 44100 Hz takes 86KB of linear memory,
+     * or 25KB as ADPCM which is only read and never decoded by the CPU.
+     */
+    SoundEffect(const std::string& path);
+
+    // Copies share the clip.
+    SoundEffect(const SoundEffect& other);
+    SoundEffect& operator=(const SoundEffect& other);
+    ~SoundEffect();
+
+    /**
+     * @brief Plays the clip once on a free channel, even if it's already playing.
+     * @return The channel it's playing on, -1 if it isn't loaded or every channel is busy with more important sounds.
+     */
+    int play();
+
+    /**
+     * @brief Stops every play of this SoundEffect that's still going.
+     */
+    void stop();
+
+    /**
+     * @brief Amount of plays of this SoundEffect that are still going.
+     */
+    int playing() const;
+
+    /**
+     * @brief Checks if the clip got decoded.
+     */
+    bool isLoaded() const;
 };
 
 } // namespace dsge
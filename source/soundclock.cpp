@@ -0,0 +1,34 @@
+#include "soundclock.hpp"
+
+namespace dsge {
+namespace _internal {
+bool bufferPosition(const ndspWaveBuf* waveBufs, const u64* starts, const u32* fileStarts, int count, u16 sequence, u32 offset, u32 total, u64& played, u32& file) {
+    for (int i = 0; i < count; i++) {
+        if (waveBufs[i].sequence_id != sequence || waveBufs[i].status == NDSP_WBUF_DONE) continue;
+        if (offset > waveBufs[i].nsamples) offset = waveBufs[i].nsamples;
+
+        // A buffer can go past the end of a looping file, it went on from the start then.
+        played = starts[i] + offset;
+        file = total != 0 ? (u32)(((u64)fileStarts[i] + offset) % total) : fileStarts[i] + offset;
+        return true;
+    }
+    return false;
+}
+
+u64 samplesSince(u64 tick, u64 now, u32 rate) {
+    if (now <= tick) return 0;
+
+    // The DSP is only read once per frame, guessing further than two frames would run past an underrun.
+    u64 ticks = now - tick;
+    u64 most = (u64)(SYSCLOCK_ARM11 * 2 * DSP_FRAME_SAMPLES / DSP_SAMPLE_RATE);
+    if (ticks > most) ticks = most;
+
+    return ticks * rate / (u64)SYSCLOCK_ARM11;
+}
+
+u32 leadInSamples(u64 target, u64 frameStart, u32 rate) {
+    if (target <= frameStart) return 0;
+    return (u32)((double)(target - frameStart) * rate / DSP_SAMPLE_RATE + 0.5);
+}
+} // namespace _internal
+} // namespace dsge
@@ -0,0 +1,24 @@
+#ifndef DSGE_SOUNDCLOCK_HPP
+#define DSGE_SOUNDCLOCK_HPP
+
+#include <3ds.h>
+
+namespace dsge {
+namespace _internal {
+    constexpr u32 DSP_FRAME_SAMPLES = 160;         // Samples the DSP outputs per frame.
+    constexpr double DSP_SAMPLE_RATE = 32728.4980; // Output rate of the DSP, the clock of `Sound::clock()`.
+
+    // Samples played of a stream and where in the file that is, from the sequence id of the wave buffer the DSP
+    // is on and the sample it's at in it. `starts` and `fileStarts` are where every buffer begins. False if the
+    // DSP isn't on any of them.
+    bool bufferPosition(const ndspWaveBuf* waveBufs, const u64* starts, const u32* fileStarts, int count, u16 sequence, u32 offset, u32 total, u64& played, u32& file);
+
+    // Samples played at `rate` since `tick`, at most two DSP frames worth.
+    u64 samplesSince(u64 tick, u64 now, u32 rate);
+
+    // Samples of silence at `rate` from `frameStart` up to `target`, both in DSP clock samples.
+    u32 leadInSamples(u64 target, u64 frameStart, u32 rate);
+}
+} // namespace dsge
+
+#endif
@@ -9,30 +9,105 @@ Sprite::Sprite(int x, int y):
     flipX(false),
     flipY(false),
     height(0),
+    layer(0),
     visible(true),
     width(0),
     x(x), y(y),
+    z(0),
     scale{1, 1},
     acceleration{0, 0}
 {
     _private.image  = { NULL, NULL };
     _private.sprite = NULL;
+    _private.mask = nullptr;
     _private.destroyed = false;
+    _private.handle = {};
+    _private.tweens = 0;
+    _private.groups = 0;
+    _private.touchTarget = false;
+    _private.previous = {0, 0, 0, 0};
+    _private.transform.bind(this, [](void* owner) { static_cast<Sprite*>(owner)->_updateTransform(); });
+}
+
+Sprite::Sprite(const Sprite& other) {
+    _private.handle = {};
+    _private.tweens = 0;
+    _private.groups = 0;
+    _private.touchTarget = false;
+    _private.sprite = NULL;
+    _private.transform.bind(this, [](void* owner) { static_cast<Sprite*>(owner)->_updateTransform(); });
+    *this = other;
+}
+
+Sprite& Sprite::operator=(const Sprite& other) {
+    if (this == &other) return *this;
+
+    MemberHandle handle = _private.handle;
+    u16 tweens = _private.tweens;
+    u16 groups = _private.groups;
+    bool touchTarget = _private.touchTarget;
+    C2D_SpriteSheet sheet = _private.sprite;
+
+    alpha = other.alpha;
+    angle = other.angle;
+    bottom = other.bottom;
+    color = other.color;
+    flipX = other.flipX;
+    flipY = other.flipY;
+    height = other.height;
+    layer = other.layer;
+    visible = other.visible;
+    width = other.width;
+    x = other.x;
+    y = other.y;
+    z = other.z;
+    scale = other.scale;
+    acceleration = other.acceleration;
+    _private = other._private;
+
+    _private.handle = handle;
+    _private.tweens = tweens;
+    _private.groups = groups;
+    _private.touchTarget = touchTarget;
+    _private.previous.tick = 0;
+
+    // Both sprites share the cached sheet now.
+    if (_private.sprite) TextureCache::_retain(_private.sprite);
+    if (sheet) TextureCache::_release(sheet);
+    return *this;
+}
+
+Sprite::~Sprite() {
+    dsge::remove(_private.handle);
+    if (_private.tweens != 0) Tween::_cancelOwner(&_private.tweens);
+    if (_private.groups != 0) Group::_removeEverywhere(this);
+    if (_private.touchTarget) Touch::_removeTarget(this);
+
+    if (_private.sprite) {
+        TextureCache::_release(_private.sprite);
+    }
 }
 
 bool Sprite::loadGraphic(const std::string& file) {
     if (_private.destroyed) return false;
 
-    std::string filePath = "romfs:/" + file;
+    // Shared with every other sprite using the same file, only the first load reads it.
+    C2D_SpriteSheet sheet = TextureCache::_acquire(file);
+    if (_private.sprite) {
+        TextureCache::_release(_private.sprite);
+    }
 
-    _private.sprite = C2D_SpriteSheetLoad(filePath.c_str());
+    _private.sprite = sheet;
     if (!_private.sprite) {
+        _private.image = {NULL, NULL}; // The old sheet may get evicted from now on.
+        _private.mask = nullptr;
         trace("[WARN] Sprite::loadGraphic: Failed to load Sprite sheet: " + file);
         return false;
     }
 
     C2D_Image ret = C2D_SpriteSheetGetImage(_private.sprite, 0);
     _private.image = ret;
+    _private.mask = _private.hitbox.pixels ? TextureCache::_mask(_private.sprite, 0) : nullptr;
     width = ret.subtex->width;
     height = ret.subtex->height;
 
@@ -67,51 +142,155 @@ bool Sprite::isOnScreen() {
         return false;
     }
 
-    return !(x + (width * scale.x) < 0 || x > dsge::WIDTH || y + (height * scale.y) < 0 || y > dsge::HEIGHT);
+    _updateTransform();
+    const _internal::Bounds& b = _private.transform.bounds;
+    return !(b.right < 0 || b.left > dsge::WIDTH || b.bottom < 0 || b.top > dsge::HEIGHT);
 }
 
-void Sprite::_render() {
-    if (_private.destroyed || !visible || (width == 0 && height == 0) || !isOnScreen()) return;
+void Sprite::_updateTransform() {
+    float scX = flipX ? -scale.x : scale.x;
+    float scY = flipY ? -scale.y : scale.y;
+
+    // In between fixed steps, drawing uses a blend of the previous and current position.
+    float drawX = x, drawY = y, drawAngle = angle;
+    _private.previous.blend(drawX, drawY, drawAngle);
+
+    // Rotates around the center of the scaled sprite, like it always did. Touch targets only get indexed again when they moved.
+    if (_private.transform.update({drawX, drawY, drawAngle, scX, scY, width * scX / 2, height * scY / 2, width / 2, height / 2, width, height}) && _private.touchTarget) {
+        Touch::_markDirty();
+    }
+}
+
+_internal::Bounds Sprite::_hitBox() {
+    if (_private.hitbox.enabled) return _collider().bounds;
+
+    // The cached world box, so it's wherever the sprite is drawn: attached, flipped or rotated.
+    _updateTransform();
+    return _private.transform.bounds;
+}
+
+bool Sprite::_isPlainBox() {
+    if (_private.hitbox.enabled) return false;
+
+    _updateTransform();
+    return _private.transform.world.b == 0 && _private.transform.world.c == 0;
+}
+
+_internal::Collider& Sprite::_collider() {
+    // Without a shape it's the sprite's own box, and pixel hitboxes are tested as that box first. Both are placed
+    // through the world transform like any other shape, so every test compares world coordinates.
+    if (!_private.hitbox.enabled || _private.hitbox.pixels) {
+        _private.hitbox.shape.width = width;
+        _private.hitbox.shape.height = height;
+    }
+
+    _updateTransform();
+    _private.hitbox.update(_private.transform, width / 2, height / 2);
+    return _private.hitbox;
+}
+
+void Sprite::setHitbox(const Shape& shape) {
+    _private.hitbox.set(shape);
+
+    // Only made now, most sheets never need a mask.
+    if (_private.hitbox.pixels && _private.sprite && !_private.mask) {
+        _private.mask = TextureCache::_mask(_private.sprite, 0);
+    }
+}
+
+void Sprite::clearHitbox() {
+    _private.hitbox = _internal::Collider(); // Back to a plain box, placed again on the next test.
+}
+
+void Sprite::attach(Sprite& child) {
+    _private.transform.attach(child._private.transform);
+}
+
+void Sprite::attach(Text& child) {
+    _private.transform.attach(child._private.transform);
+}
+
+void Sprite::detach() {
+    _private.transform.detach();
+}
+
+bool Sprite::_prepare() {
+    if (_private.destroyed || !visible || (width == 0 && height == 0) || !isOnScreen()) return false;
 
     // Crash prevention(?)
     if (width < 0) width = -width;
     if (height < 0) height = -height;
 
-    float scX = flipX ? -scale.x : scale.x;
-    float scY = flipY ? -scale.y : scale.y;
+    return true;
+}
+
+void Sprite::_integrate(float steps) {
+    if (_private.destroyed) return;
 
-    x += acceleration.x;
-    y += acceleration.y;
-    angle += acceleration.angle;
+    x += acceleration.x * steps;
+    y += acceleration.y * steps;
+    angle += acceleration.angle * steps;
+}
 
-    C2D_ViewSave(&_private.matrix);
+void Sprite::_snapshot() {
+    if (_private.destroyed) return;
+
+    _private.previous.take(x, y, angle);
+}
 
-    C2D_ViewTranslate(x, y);
-    C2D_ViewTranslate(width * scX / 2, height * scY / 2);
-    C2D_ViewRotate(Math::angleToRadians(angle));
-    C2D_ViewScale(scX, scY);
+void Sprite::_draw() {
+    DSGE_PROFILE_ZONE("Sprite::_draw");
 
+    _updateTransform(); // Parents may have moved since this sprite got prepared.
+
+    const _internal::Transform& t = _private.transform;
+
+    // The quad is transformed on the CPU from the cached world transform, so the view matrix never
+    // changes and sprites using the same graphic can be drawn in a single batch.
     if (_private.image.tex != NULL) {
         C2D_PlainImageTint(&_private.tint, C2D_Color32((color >> 16) & 0xFF, (color >> 8) & 0xFF, color & 0xFF, ((color >> 24) & 0xFF) * (alpha >= 1 ? 1 : alpha <= 0 ? 0 : alpha)), 0);
-        C2D_DrawImageAt(_private.image, -width / 2, -height / 2, 0, &_private.tint, 1, 1);
-    } else {
-        u32 finalColor = color;
-        if (alpha < 1) {
-            u8 a = (color >> 24) & 0xFF;
-            a = (u8)(a * alpha);
-            finalColor = (color & 0x00FFFFFF) | (a << 24);
-        }
-        C2D_DrawRectSolid(-width / 2, -height / 2, 0, width * fabsf(scX), height * fabsf(scY), finalColor);
+
+        _internal::Transform::ImageQuad quad = t.imageQuad(width, height);
+        C2D_DrawParams params = {{quad.x, quad.y, quad.w, quad.h}, {0, 0}, 0, quad.angle};
+        C2D_DrawImage(_private.image, &params, &_private.tint);
+        return;
     }
 
-    C2D_ViewRestore(&_private.matrix);
+    u32 finalColor = color;
+    if (alpha < 1) {
+        u8 a = (color >> 24) & 0xFF;
+        a = (u8)(a * alpha);
+        finalColor = (color & 0x00FFFFFF) | (a << 24);
+    }
+
+    if (t.world.b == 0 && t.world.c == 0) {
+        const _internal::Bounds& b = t.bounds;
+        C2D_DrawRectSolid(b.left, b.top, 0, b.right - b.left, b.bottom - b.top, finalColor);
+        return;
+    }
+
+    // Corners: top left, top right, bottom left, bottom right.
+    float px[4], py[4];
+    t.world.apply(0, 0, px[0], py[0]);
+    t.world.apply(width, 0, px[1], py[1]);
+    t.world.apply(0, height, px[2], py[2]);
+    t.world.apply(width, height, px[3], py[3]);
+
+    C2D_DrawTriangle(px[0], py[0], finalColor, px[1], py[1], finalColor, px[2], py[2], finalColor, 0);
+    C2D_DrawTriangle(px[2], py[2], finalColor, px[1], py[1], finalColor, px[3], py[3], finalColor, 0);
+}
+
+void Sprite::_render() {
+    if (_prepare()) {
+        _draw();
+    }
 }
 
 void Sprite::destroy() {
     if (_private.destroyed) return;
 
     if (_private.sprite) {
-        C2D_SpriteSheetFree(_private.sprite);
+        TextureCache::_release(_private.sprite);
         _private.sprite = nullptr;
     }
     acceleration = {0, 0};
@@ -127,6 +306,13 @@ void Sprite::destroy() {
     y = 0;
 
     _private.image = {nullptr, nullptr};
+    _private.mask = nullptr;
+    _private.transform.detach();
+    _private.transform.detachChildren();
+    dsge::remove(_private.handle);
+    if (_private.tweens != 0) Tween::_cancelOwner(&_private.tweens);
+    if (_private.groups != 0) Group::_removeEverywhere(this);
+    if (_private.touchTarget) Touch::_removeTarget(this);
     _private.destroyed = true;
 }
 } // namespace dsge
\ No newline at end of file
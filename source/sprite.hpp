@@ -13,17 +13,26 @@ public:
     bool  flipX;    // Horizontal flip.
     bool  flipY;    // Vertical flip.
     float height;   // Sprite height.
+    u8    layer;    // Draw layer, higher layers are always drawn above lower ones.
     bool  visible;  // Sprite visibility.
     float width;    // Sprite width.
     float x;        // X Position of Sprite.
     float y;        // Y Position of Sprite.
+    int   z;        // Draw order inside of the layer, higher is drawn above.
 
     struct {
         C2D_Image image;
         C2D_SpriteSheet sprite;
         bool destroyed;
         C2D_ImageTint tint;
-        C3D_Mtx matrix;
+        MemberHandle handle; // Handle from dsge::add(), copies of the sprite are never added.
+        u16 tweens;          // Running tweens on this sprite, copies don't take them over.
+        u16 groups;          // Collision groups this sprite is in, copies aren't in any.
+        bool touchTarget;    // Added with Touch::addTarget(), copies aren't.
+        _internal::Transform transform; // Cached world transform and bounds.
+        _internal::Snapshot previous;   // State before the last fixed step, see dsge::Loop.
+        _internal::Collider hitbox;     // Shape from setHitbox(), placed on the sprite.
+        const _internal::PixelMask* mask; // Collision mask of the graphic, owned by the texture cache.
     } _private;
 
     struct {
@@ -68,6 +77,11 @@ public:
      */
     Sprite(int x = 0, int y = 0);
 
+    // Copies aren't added to members, even if the copied sprite is.
+    Sprite(const Sprite& other);
+    Sprite& operator=(const Sprite& other);
+    ~Sprite();
+
     /**
      * @brief Creates a rectangular graphic for the Sprite.
      * @param width  Width of the graphic.
@@ -132,7 +146,66 @@ public:
      */
     void destroy();
 
+    /**
+     * @brief Attaches a sprite or text to this sprite, the child then moves, rotates and scales along with it.
+     * @param child The sprite or text to attach, it's `x` and `y` becomes relative to this sprite's top left corner.
+     * 
+     * #### Note:
+     * 
+     * The child still needs to be added with `dsge::add()` to be rendered.
+     * 
+     * #### Example Usage:
+     * ```
+     * dsge::Sprite panel(40, 40);
+     * panel.makeGraphic(200, 100);
+     * 
+     * dsge::Text label(8, 8, "Inventory");
+     * panel.attach(label);
+     * 
+     * panel.x += 10; // Moves the label too.
+     * ```
+     */
+    void attach(Sprite& child);
+    void attach(Text& child);
+
+    /**
+     * @brief Detaches this sprite from it's parent, it's `x` and `y` becomes relative to the screen again.
+     * 
+     * #### Example Usage:
+     * ```
+     * label.detach();
+     * ```
+     */
+    void detach();
+
+    /**
+     * @brief Gives the sprite a collision shape, used by `dsge::overlap()` and `dsge::collide()` instead of it's box.
+     * @param shape The shape, centered on the sprite, see `dsge::Shape`.
+     * 
+     * #### Example Usage:
+     * ```
+     * dsge::Sprite saw(100, 100);
+     * saw.loadGraphic("saw.t3x");
+     * saw.setHitbox(dsge::Shape::circle(14));
+     * saw.acceleration.angle = 8; // Spinning doesn't change the hitbox.
+     * ```
+     */
+    void setHitbox(const Shape& shape);
+
+    /**
+     * @brief Removes the collision shape, the sprite collides with it's box again.
+     */
+    void clearHitbox();
+
+    bool _prepare();
+    void _integrate(float steps);
+    void _snapshot();
+    void _draw();
     void _render();
+    void _updateTransform();
+    _internal::Bounds _hitBox();
+    bool _isPlainBox(); // No shape and not rotated, so it's hit box is all there is to test.
+    _internal::Collider& _collider();
 };
 } // namespace dsge
 
@@ -1,11 +1,59 @@
 #include "text.hpp"
 
-C2D_Text c2dText;
+namespace {
+    // Text buffers are pooled by power of two glyph capacities (32 to 4096), so making and
+    // destroying texts every frame doesn't go through C2D_TextBufNew/Delete all the time.
+    constexpr size_t POOL_MIN_GLYPHS = 32;
+    constexpr int    POOL_BUCKETS    = 8;
+
+    struct TextBufPool {
+        std::vector<C2D_TextBuf> free[POOL_BUCKETS];
+        bool closed = false; // Set on Text::exit(), released buffers gets deleted from then on.
+    };
+
+    TextBufPool& pool() {
+        static TextBufPool p; // Function static so global Texts can use it before main().
+        return p;
+    }
+
+    int bucketOf(size_t capacity) {
+        int bucket = 0;
+        for (size_t size = POOL_MIN_GLYPHS; size < capacity; size <<= 1) bucket++;
+        return bucket;
+    }
+
+    C2D_TextBuf acquireBuffer(size_t glyphs, size_t& capacity) {
+        capacity = POOL_MIN_GLYPHS;
+        while (capacity < glyphs) capacity <<= 1;
+
+        int bucket = bucketOf(capacity);
+        if (bucket < POOL_BUCKETS && !pool().free[bucket].empty()) {
+            C2D_TextBuf buf = pool().free[bucket].back();
+            pool().free[bucket].pop_back();
+            C2D_TextBufClear(buf);
+            return buf;
+        }
+
+        return C2D_TextBufNew(capacity);
+    }
+
+    void returnBuffer(C2D_TextBuf buf, size_t capacity) {
+        int bucket = bucketOf(capacity);
+        if (pool().closed || bucket >= POOL_BUCKETS) {
+            C2D_TextBufDelete(buf);
+            return;
+        }
+
+        pool().free[bucket].push_back(buf);
+    }
+}
+
 namespace dsge {
 
 // Static member initialization
 C2D_Font Text::defaultFont = NULL;
-C2D_TextBuf Text::g_staticBuf = NULL;
+u32 Text::parsesLastFrame = 0;
+u32 Text::parseCounter = 0;
 
 // Helper to combine alpha with color's alpha
 u32 Text::applyAlpha(u32 color, float alpha) {
@@ -15,23 +63,66 @@ u32 Text::applyAlpha(u32 color, float alpha) {
 
 void Text::exit() {
     C2D_FontFree(defaultFont);
-    C2D_TextBufDelete(g_staticBuf);
+    defaultFont = NULL;
+
+    for (auto &&bucket : pool().free) {
+        for (auto &&buf : bucket) {
+            C2D_TextBufDelete(buf);
+        }
+        bucket.clear();
+    }
+    pool().closed = true;
+}
+
+void Text::_endFrame() {
+    parsesLastFrame = parseCounter;
+    parseCounter = 0;
+}
+
+void Text::releaseBuffer() {
+    if (_private.buf) {
+        returnBuffer(_private.buf, _private.bufSize);
+    }
+
+    _private.buf = nullptr;
+    _private.bufSize = 0;
+    _private.parsed = false;
 }
 
 void Text::createText() {
-    // Clear and prepare Text buffer
-    if (g_staticBuf == NULL) { // Fuck you null
+    DSGE_PROFILE_ZONE("Text::createText");
+
+    if (defaultFont == NULL) {
         defaultFont = C2D_FontLoadSystem(CFG_REGION_USA);
-        g_staticBuf = C2D_TextBufNew(4096);
     }
-    C2D_TextBufClear(g_staticBuf);
-    
-    // Parse Text using selected font (default if none specified)
-    C2D_TextFontParse(&c2dText, font ? font : defaultFont, g_staticBuf, text.c_str());
-    C2D_TextOptimize(&c2dText);
 
-    // Update width and height.
-    C2D_TextGetDimensions(&c2dText, scale.x, scale.y, &width, &height);
+    // Only parse again if the text or font has been changed since the last time.
+    if (!_private.parsed || _private.parsedFont != font || _private.parsedText != text) {
+        size_t glyphs = text.size() + 1; // UTF-8 bytes, never less than the amount of glyphs.
+        if (_private.buf == nullptr || _private.bufSize < glyphs) {
+            releaseBuffer();
+            _private.buf = acquireBuffer(glyphs, _private.bufSize);
+        } else {
+            C2D_TextBufClear(_private.buf);
+        }
+
+        // Parse Text using selected font (default if none specified)
+        C2D_TextFontParse(&_private.glyphs, font ? font : defaultFont, _private.buf, text.c_str());
+        C2D_TextOptimize(&_private.glyphs);
+        parseCounter++;
+
+        _private.parsed = true;
+        _private.parsedFont = font;
+        _private.parsedText = text;
+        _private.parsedScaleX = scale.x + 1; // Force the measure below.
+    }
+
+    // Update width and height, only if the scale changed since it's already known otherwise.
+    if (_private.parsedScaleX != scale.x || _private.parsedScaleY != scale.y) {
+        C2D_TextGetDimensions(&_private.glyphs, scale.x, scale.y, &width, &height);
+        _private.parsedScaleX = scale.x;
+        _private.parsedScaleY = scale.y;
+    }
 }
 
 Text::Text(int x, int y, const std::string& Text) :
@@ -48,19 +139,120 @@ Text::Text(int x, int y, const std::string& Text) :
     flipY(false),
     font(nullptr),
     height(0),
+    layer(0),
     text(Text),
     underline(false),
     visible(true),
     width(0),
     x(x), y(y),
+    z(0),
     acceleration{0, 0},
     scale{1, 1}
 {
     _private.debug = false;
     _private.destroyed = false;
+    _private.buf = nullptr;
+    _private.bufSize = 0;
+    _private.parsed = false;
+    _private.parsedFont = nullptr;
+    _private.parsedScaleX = 0;
+    _private.parsedScaleY = 0;
+    _private.handle = {};
+    _private.tweens = 0;
+    _private.touchTarget = false;
+    _private.previous = {0, 0, 0, 0};
+    _private.transform.bind(this, [](void* owner) { static_cast<dsge::Text*>(owner)->_updateTransform(); });
     createText();
 }
 
+Text::Text(const Text& other) :
+    alignment(other.alignment),
+    alpha(other.alpha),
+    angle(other.angle),
+    borderStyle(other.borderStyle),
+    bold(other.bold),
+    borderColor(other.borderColor),
+    borderSize(other.borderSize),
+    bottom(other.bottom),
+    color(other.color),
+    flipX(other.flipX),
+    flipY(other.flipY),
+    font(other.font),
+    height(other.height),
+    layer(other.layer),
+    text(other.text),
+    underline(other.underline),
+    visible(other.visible),
+    width(other.width),
+    x(other.x), y(other.y),
+    z(other.z),
+    acceleration(other.acceleration),
+    scale(other.scale),
+    _private(other._private)
+{
+    // The glyph run points into the other text's buffer, so it has to be parsed again.
+    _private.buf = nullptr;
+    _private.bufSize = 0;
+    _private.parsed = false;
+    _private.handle = {};
+    _private.tweens = 0;
+    _private.touchTarget = false;
+    _private.previous = {0, 0, 0, 0};
+    _private.transform.bind(this, [](void* owner) { static_cast<dsge::Text*>(owner)->_updateTransform(); });
+}
+
+Text& Text::operator=(const Text& other) {
+    if (this == &other) return *this;
+
+    C2D_TextBuf buf = _private.buf;
+    size_t bufSize = _private.bufSize;
+    MemberHandle handle = _private.handle;
+    u16 tweens = _private.tweens;
+    bool touchTarget = _private.touchTarget;
+
+    alignment = other.alignment;
+    alpha = other.alpha;
+    angle = other.angle;
+    borderStyle = other.borderStyle;
+    bold = other.bold;
+    borderColor = other.borderColor;
+    borderSize = other.borderSize;
+    bottom = other.bottom;
+    color = other.color;
+    flipX = other.flipX;
+    flipY = other.flipY;
+    font = other.font;
+    height = other.height;
+    layer = other.layer;
+    text = other.text;
+    underline = other.underline;
+    visible = other.visible;
+    width = other.width;
+    x = other.x;
+    y = other.y;
+    z = other.z;
+    acceleration = other.acceleration;
+    scale = other.scale;
+    _private = other._private;
+
+    // Keep our own buffer, it's reused on the next parse.
+    _private.buf = buf;
+    _private.bufSize = bufSize;
+    _private.parsed = false;
+    _private.handle = handle;
+    _private.tweens = tweens;
+    _private.touchTarget = touchTarget;
+    _private.previous.tick = 0;
+    return *this;
+}
+
+Text::~Text() {
+    dsge::remove(_private.handle);
+    if (_private.tweens != 0) Tween::_cancelOwner(&_private.tweens);
+    if (_private.touchTarget) Touch::_removeTarget(this);
+    releaseBuffer();
+}
+
 void Text::screenCenter(axes pos) {
     if (_private.destroyed) return;
 
@@ -83,9 +275,69 @@ bool Text::isOnScreen() {
         return false;
     }
 
-    // Making the text for reasons.
-    createText();
-    return !(x + width < 0 || x > dsge::WIDTH || y + height < 0 || y > dsge::HEIGHT);
+    _updateTransform(); // Also makes the text if needed.
+    const _internal::Bounds& b = _private.transform.bounds;
+    return !(b.right < 0 || b.left > dsge::WIDTH || b.bottom < 0 || b.top > dsge::HEIGHT);
+}
+
+void Text::_updateTransform() {
+    createText(); // Only parses if the text or font changed
+
+    // In between fixed steps, drawing uses a blend of the previous and current position.
+    float newX = x, drawY = y, drawAngle = angle;
+    _private.previous.blend(newX, drawY, drawAngle);
+
+    if (!_private.debug) {
+        switch (alignment) {
+            case ALIGN_LEFT:   break; // No change
+            case ALIGN_CENTER: newX += bottom ? (dsge::WIDTH_BOTTOM - width) / 2 : (dsge::WIDTH - width) / 2; break;
+            case ALIGN_RIGHT:  newX += bottom ? dsge::WIDTH_BOTTOM - width : dsge::WIDTH - width; break;
+        }
+    }
+
+    // Width and height are already scaled, so only the flip is left for the matrix. Touch targets only get indexed again when they moved.
+    if (_private.transform.update({newX, drawY, _private.debug ? 0 : drawAngle, flipX ? -1.0f : 1.0f, flipY ? -1.0f : 1.0f, 0, 0, 0, 0, width, height}) && _private.touchTarget) {
+        Touch::_markDirty();
+    }
+}
+
+_internal::Collider& Text::_collider() {
+    _updateTransform();
+
+    if (!_private.hitbox.enabled) {
+        _private.hitbox.fromBounds(_private.transform.bounds);
+        return _private.hitbox;
+    }
+
+    // Texts have no mask, a pixel hitbox is just their box.
+    if (_private.hitbox.pixels) {
+        _private.hitbox.shape.width = width;
+        _private.hitbox.shape.height = height;
+    }
+
+    // Width and height are already scaled, the center is the same as the box's.
+    _private.hitbox.update(_private.transform, width / 2, height / 2);
+    return _private.hitbox;
+}
+
+void Text::setHitbox(const Shape& shape) {
+    _private.hitbox.set(shape);
+}
+
+void Text::clearHitbox() {
+    _private.hitbox.enabled = false;
+}
+
+void Text::attach(Sprite& child) {
+    _private.transform.attach(child._private.transform);
+}
+
+void Text::attach(Text& child) {
+    _private.transform.attach(child._private.transform);
+}
+
+void Text::detach() {
+    _private.transform.detach();
 }
 
 bool Text::loadFont(std::string filePath) {
@@ -101,31 +353,48 @@ bool Text::loadFont(std::string filePath) {
     return (font = C2D_FontLoad(fullPath.c_str())) != NULL;
 }
 
-void Text::_render() {
-    if (_private.destroyed || !visible || text.empty() || !isOnScreen()) return;
+bool Text::_prepare() {
+    if (_private.destroyed || !visible || text.empty() || !isOnScreen()) return false;
 
-    createText(); // Ensure text dimensions are updated
+    return true;
+}
 
-    float scX = flipX ? -scale.x : scale.x;
-    float scY = flipY ? -scale.y : scale.y;
-    bool debug = _private.debug;
+void Text::_integrate(float steps) {
+    if (_private.destroyed) return;
 
-    x += acceleration.x;
-    y += acceleration.y;
+    x += acceleration.x * steps;
+    y += acceleration.y * steps;
+}
 
-    float newX = x;
-    if (!debug) {
-        switch (alignment) {
-            case ALIGN_LEFT:   break; // No change
-            case ALIGN_CENTER: newX += bottom ? (dsge::WIDTH_BOTTOM - width) / 2 : (dsge::WIDTH - width) / 2; break;
-            case ALIGN_RIGHT:  newX += bottom ? dsge::WIDTH_BOTTOM - width : dsge::WIDTH - width; break;
-        }
-    }
+void Text::_snapshot() {
+    if (_private.destroyed) return;
+
+    _private.previous.take(x, y, angle);
+}
 
-    C2D_ViewSave(&_private.matrix);
-    C2D_ViewTranslate(newX, y);
-    C2D_ViewRotate(debug ? 0 : Math::angleToRadians(angle));
-    C2D_ViewScale(scX, scY);
+bool Text::_draw() {
+    DSGE_PROFILE_ZONE("Text::_draw");
+
+    _updateTransform(); // Parents may have moved since this text got prepared.
+
+    const _internal::Transform& t = _private.transform;
+
+    // Glyphs can't be rotated by citro2d, so only rotated or flipped texts go through the view matrix.
+    // Everything else is positioned and scaled directly, which keeps the batch going.
+    bool transformed = t.worldAngle != 0 || t.worldScaleX < 0 || t.worldScaleY < 0;
+
+    float ox = t.world.tx, oy = t.world.ty;
+    float sx = t.worldScaleX * scale.x, sy = t.worldScaleY * scale.y;
+    if (transformed) {
+        C2D_ViewSave(&_private.matrix);
+        C2D_ViewTranslate(t.world.tx, t.world.ty);
+        C2D_ViewRotate(t.worldAngle);
+        C2D_ViewScale(t.worldScaleX, t.worldScaleY);
+        ox = 0;
+        oy = 0;
+        sx = scale.x;
+        sy = scale.y;
+    }
 
     u32 col = applyAlpha(color, alpha);
 
@@ -138,13 +407,13 @@ void Text::_render() {
             case BS_BORDER: {
                 int offsets[8][2] = {{-1, -1}, {1, -1}, {-1, 1}, {1, 1}, {1, 0}, {-1, 0}, {0, 1}, {0, -1}};
                 for (int i = 0; i < 8; i++) {
-                    C2D_DrawText(&c2dText, C2D_WithColor, (offsets[i][0] * border), (offsets[i][1] * border), .5, 1, 1, bCol);
+                    C2D_DrawText(&_private.glyphs, C2D_WithColor, ox + (offsets[i][0] * border) * sx, oy + (offsets[i][1] * border) * sy, .5, sx, sy, bCol);
                 }
                 break;
             }
             case BS_SHADOW: {
                 for (int i = 1; i < (int)borderSize + 1; i++) {
-                    C2D_DrawText(&c2dText, C2D_WithColor, -i, i, .5, 1, 1, bCol);
+                    C2D_DrawText(&_private.glyphs, C2D_WithColor, ox - i * sx, oy + i * sy, .5, sx, sy, bCol);
                 }
                 break;
             }
@@ -154,19 +423,29 @@ void Text::_render() {
     // Bold
     if (bold) {
         for (int i = 1; i < 3; i++) {
-            C2D_DrawText(&c2dText, C2D_WithColor, i, 0, 0, 1, 1, col);
+            C2D_DrawText(&_private.glyphs, C2D_WithColor, ox + i * sx, oy, 0, sx, sy, col);
         }
     }
 
     // Underline
     if (underline) {
-        C2D_DrawRectSolid(width + 2, height, .5, width, 1, col);
+        C2D_DrawRectSolid(ox + (width + 2) * sx, oy + height * sy, .5, width * sx, sy, col);
     }
 
     // Main text
-    C2D_DrawText(&c2dText, C2D_WithColor, 0, 0, .5, 1, 1, col);
+    C2D_DrawText(&_private.glyphs, C2D_WithColor, ox, oy, .5, sx, sy, col);
 
-    C2D_ViewRestore(&_private.matrix);
+    if (transformed) {
+        C2D_ViewRestore(&_private.matrix);
+    }
+
+    return transformed;
+}
+
+void Text::_render() {
+    if (_prepare()) {
+        _draw();
+    }
 }
 
 void Text::destroy() {
@@ -189,6 +468,9 @@ void Text::destroy() {
     flipY = false;
     font = nullptr;
     height = 0;
+    releaseBuffer();
+    _private.transform.detach();
+    _private.transform.detachChildren();
     scale = {0, 0};
     text = "";
     underline = false;
@@ -197,6 +479,9 @@ void Text::destroy() {
     x = 0;
     y = 0;
 
+    dsge::remove(_private.handle);
+    if (_private.tweens != 0) Tween::_cancelOwner(&_private.tweens);
+    if (_private.touchTarget) Touch::_removeTarget(this);
     _private.destroyed = true;
 }
 }
\ No newline at end of file
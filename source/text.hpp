@@ -21,12 +21,14 @@ public:
     bool          flipY;       // Vertical flip.
     C2D_Font      font;        // Font to use
     float         height;      // Height of the text.
+    u8            layer;       // Draw layer, higher layers are always drawn above lower ones.
     std::string   text;        // Text content
     bool          underline;   // Underlined text
     bool          visible;     // Visibility flag
     float         width;       // Width of the text.
     float         x;           // X position
     float         y;           // Y position
+    int           z;           // Draw order inside of the layer, higher is drawn above.
 
     struct {
         float x; // X's Acceleration speed.
@@ -59,8 +61,38 @@ public:
         C3D_Mtx matrix;
         bool debug;
         bool destroyed;
+        C2D_Text glyphs;        // Retained glyph run, only re-parsed if `text` or `font` changes.
+        C2D_TextBuf buf;        // Pooled text buffer, owned by this text only.
+        size_t bufSize;         // Glyph capacity of `buf`.
+        bool parsed;            // Whetever `glyphs` holds a valid parse.
+        std::string parsedText; // `text` used on the last parse.
+        C2D_Font parsedFont;    // `font` used on the last parse.
+        float parsedScaleX;     // `scale.x` used on the last measure.
+        float parsedScaleY;     // `scale.y` used on the last measure.
+        MemberHandle handle;    // Handle from dsge::add(), copies of the text are never added.
+        u16 tweens;             // Running tweens on this text, copies don't take them over.
+        bool touchTarget;       // Added with Touch::addTarget(), copies aren't.
+        _internal::Transform transform; // Cached world transform and bounds.
+        _internal::Snapshot previous;   // State before the last fixed step, see dsge::Loop.
+        _internal::Collider hitbox;     // Shape from setHitbox(), placed on the text.
     } _private;
-    
+
+    /**
+     * @brief Amount of glyph parses done by every Text in the last frame.
+     * 
+     * Updated every `dsge::render()`, a Text is only parsed again if it's `text` or `font` has been changed.
+     * 
+     * #### Example Usage:
+     * ```
+     * dsge::Text hud(0, 0, "Score: 0");
+     * dsge::add(hud);
+     * 
+     * while (dsge::render()) {
+     *     trace(dsge::Text::parsesLastFrame); // 0 as long as the hud's text stays the same.
+     * }
+     * ```
+     */
+    static u32 parsesLastFrame;
 
     /**
      * @brief Constructor: Creates a new Text object
@@ -76,6 +108,11 @@ public:
      */
     Text(int x = 0, int y = 0, const std::string& Text = "");
 
+    // Copies never share the text buffer and aren't added to members, even if the copied text is.
+    Text(const Text& other);
+    Text& operator=(const Text& other);
+    ~Text();
+
     /**
      * @brief Centers the text on the screen.
      * @param pos Type of axes position to use, can be `AXES_X`, `AXES_Y`, `AXES_XY`.
@@ -132,16 +169,72 @@ public:
      */
     void destroy();
 
+    /**
+     * @brief Attaches a sprite or text to this text, the child then moves, rotates and scales along with it.
+     * @param child The sprite or text to attach, it's `x` and `y` becomes relative to this text's top left corner.
+     * 
+     * #### Note:
+     * 
+     * The child still needs to be added with `dsge::add()` to be rendered.
+     * 
+     * #### Example Usage:
+     * ```
+     * dsge::Text title(40, 40, "Game Over");
+     * 
+     * dsge::Text subtitle(0, 20, "Press START");
+     * title.attach(subtitle);
+     * 
+     * title.angle = 15; // Rotates the subtitle around the title too.
+     * ```
+     */
+    void attach(Sprite& child);
+    void attach(Text& child);
+
+    /**
+     * @brief Detaches this text from it's parent, it's `x` and `y` becomes relative to the screen again.
+     * 
+     * #### Example Usage:
+     * ```
+     * label.detach();
+     * ```
+     */
+    void detach();
+
+    /**
+     * @brief Gives the text a collision shape, used by `dsge::overlap()` and `dsge::collide()` instead of it's box.
+     * @param shape The shape, centered on the text, see `dsge::Shape`.
+     * 
+     * #### Example Usage:
+     * ```
+     * dsge::Text sign(100, 100, "DANGER");
+     * sign.setHitbox(dsge::Shape::box(sign.width, 4, 0, sign.height / 2)); // Only the bottom edge.
+     * ```
+     */
+    void setHitbox(const Shape& shape);
+
+    /**
+     * @brief Removes the collision shape, the text collides with it's box again.
+     */
+    void clearHitbox();
+
+    bool _prepare();
+    void _integrate(float steps);
+    void _snapshot();
+    bool _draw();
     void _render();
+    void _updateTransform();
+    _internal::Collider& _collider();
 
     static void init();
     static void exit();
+    static void _endFrame();
 
 private:
-    static C2D_Font defaultFont;    // Default system font
-    static C2D_TextBuf g_staticBuf; // Text buffer
+    static C2D_Font defaultFont; // Default system font
+    static u32 parseCounter;     // Parses done in the current frame
 
     void createText();
+    void releaseBuffer();
 
     // Helper to apply alpha to a color
     static u32 applyAlpha(u32 color, float alpha);
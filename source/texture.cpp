@@ -0,0 +1,193 @@
+#include "texture.hpp"
+#include <unordered_map>
+
+namespace {
+    struct CachedSheet {
+        C2D_SpriteSheet sheet;
+        u32 refs;     // Sprites using the sheet.
+        size_t bytes; // Texture memory of the sheet, and of it's masks once they're made.
+        u64 lastUsed; // Use tick, the lowest is evicted first.
+        std::vector<dsge::_internal::PixelMask> masks; // Collision mask of every image, empty until a sprite needs them.
+    };
+
+    struct Cache {
+        std::unordered_map<std::string, CachedSheet> byPath;
+        std::unordered_map<C2D_SpriteSheet, CachedSheet*> bySheet;
+        textureStats stats = {0, 0, 0, 0, 0, 8 * 1024 * 1024};
+        u64 tick = 0;
+    };
+
+    Cache& cache() {
+        // Never freed so sprites destroyed after main() can still release their sheet.
+        static Cache* c = new Cache();
+        return *c;
+    }
+
+    size_t sheetBytes(C2D_SpriteSheet sheet) {
+        // Every image of a t3x sheet lives in the same texture.
+        C2D_Image image = C2D_SpriteSheetGetImage(sheet, 0);
+        return image.tex ? image.tex->size : 0;
+    }
+
+    void freeSheet(std::unordered_map<std::string, CachedSheet>::iterator it) {
+        Cache& c = cache();
+        c.stats.bytes -= it->second.bytes;
+        c.stats.sheets--;
+        c.stats.evictions++;
+
+        C2D_SpriteSheetFree(it->second.sheet);
+        c.bySheet.erase(it->second.sheet);
+        c.byPath.erase(it);
+    }
+
+    void enforceBudget() {
+        Cache& c = cache();
+
+        while (c.stats.bytes > c.stats.budget) {
+            auto lru = c.byPath.end();
+            for (auto it = c.byPath.begin(); it != c.byPath.end(); ++it) {
+                if (it->second.refs == 0 && (lru == c.byPath.end() || it->second.lastUsed < lru->second.lastUsed)) {
+                    lru = it;
+                }
+            }
+
+            if (lru == c.byPath.end()) return; // Everything left is in use.
+            freeSheet(lru);
+        }
+    }
+
+    CachedSheet* load(const std::string& file) {
+        Cache& c = cache();
+
+        auto it = c.byPath.find(file);
+        if (it != c.byPath.end()) {
+            c.stats.hits++;
+            it->second.lastUsed = ++c.tick;
+            return &it->second;
+        }
+
+        c.stats.misses++;
+
+        std::string filePath = "romfs:/" + file;
+        C2D_SpriteSheet sheet = C2D_SpriteSheetLoad(filePath.c_str());
+        if (!sheet) return nullptr;
+
+        CachedSheet& entry = c.byPath[file];
+        entry = {sheet, 0, sheetBytes(sheet), ++c.tick, {}};
+        c.bySheet[sheet] = &entry;
+
+        c.stats.bytes += entry.bytes;
+        c.stats.sheets++;
+        return &entry;
+    }
+}
+
+namespace dsge {
+namespace TextureCache {
+bool preload(const std::string& file) {
+    if (!load(file)) {
+        trace("[WARN] TextureCache::preload: Failed to load Sprite sheet: " + file);
+        return false;
+    }
+
+    enforceBudget();
+    return true;
+}
+
+bool evict(const std::string& file) {
+    auto it = cache().byPath.find(file);
+    if (it == cache().byPath.end() || it->second.refs != 0) return false;
+
+    freeSheet(it);
+    return true;
+}
+
+void evictUnused() {
+    Cache& c = cache();
+    for (auto it = c.byPath.begin(); it != c.byPath.end();) {
+        auto next = std::next(it);
+        if (it->second.refs == 0) {
+            freeSheet(it);
+        }
+        it = next;
+    }
+}
+
+void setBudget(size_t bytes) {
+    cache().stats.budget = bytes;
+    enforceBudget();
+}
+
+textureStats getStats() {
+    return cache().stats;
+}
+
+C2D_SpriteSheet _acquire(const std::string& file) {
+    CachedSheet* entry = load(file);
+    if (!entry) return nullptr;
+
+    entry->refs++;
+    enforceBudget(); // Can't free this one, it's in use now.
+    return entry->sheet;
+}
+
+const _internal::PixelMask* _mask(C2D_SpriteSheet sheet, size_t image) {
+    Cache& c = cache();
+    auto it = c.bySheet.find(sheet);
+    if (it == c.bySheet.end()) return nullptr;
+
+    // Made for every image of the sheet the first time a sprite of it needs one, identical sprites share them.
+    CachedSheet& entry = *it->second;
+    if (entry.masks.empty()) {
+        size_t images = C2D_SpriteSheetCount(sheet);
+        entry.masks.resize(images);
+
+        size_t bytes = 0;
+        for (size_t i = 0; i < images; i++) {
+            _internal::PixelMask& mask = entry.masks[i];
+            if (!_internal::buildMask(mask, C2D_SpriteSheetGetImage(sheet, i))) {
+                mask.width = 0;
+                continue;
+            }
+            bytes += (mask.bits.size() + mask.mirrored.size()) * sizeof(u32);
+        }
+
+        entry.bytes += bytes;
+        c.stats.bytes += bytes;
+        enforceBudget(); // Can't free this one, a sprite is using it.
+    }
+
+    if (image >= entry.masks.size()) return nullptr;
+
+    const _internal::PixelMask& mask = entry.masks[image];
+    return mask.width != 0 ? &mask : nullptr;
+}
+
+void _retain(C2D_SpriteSheet sheet) {
+    auto it = cache().bySheet.find(sheet);
+    if (it != cache().bySheet.end()) {
+        it->second->refs++;
+    }
+}
+
+void _release(C2D_SpriteSheet sheet) {
+    // Unused sheets stay cached, they're only freed once the cache is over budget.
+    auto it = cache().bySheet.find(sheet);
+    if (it != cache().bySheet.end() && it->second->refs > 0) {
+        it->second->refs--;
+    }
+}
+
+void _clear() {
+    Cache& c = cache();
+    for (auto &&entry : c.byPath) {
+        C2D_SpriteSheetFree(entry.second.sheet);
+    }
+
+    c.byPath.clear();
+    c.bySheet.clear();
+    c.stats.bytes = 0;
+    c.stats.sheets = 0;
+}
+}
+} // namespace dsge
@@ -0,0 +1,94 @@
+#ifndef DSGE_TEXTURE_HPP
+#define DSGE_TEXTURE_HPP
+
+#include "dsge.hpp"
+#include <string>
+
+// Statistics of the texture cache, see dsge::TextureCache::getStats().
+struct textureStats {
+    u32    hits;      // Loads served from the cache.
+    u32    misses;    // Loads that had to read the sheet from romfs.
+    u32    evictions; // Sheets freed to stay under the budget, or by evict().
+    u32    sheets;    // Sheets currently cached.
+    size_t bytes;     // Texture memory used by the cached sheets, and by their collision masks.
+    size_t budget;    // Memory budget, see dsge::TextureCache::setBudget().
+};
+
+namespace dsge {
+namespace TextureCache {
+/**
+ * @brief Loads a .t3x sprite sheet into the cache without using it yet.
+ * @param file Path to the sheet (without "romfs:/" prefix).
+ * @returns `true` if the sheet is cached, `false` if it failed to load.
+ * 
+ * Every `Sprite::loadGraphic()` of the same file then shares that sheet, with no file reading or allocation.
+ * 
+ * The collision masks of it's images are only made once a sprite of the sheet gets a `dsge::Shape::pixels()` hitbox.
+ * 
+ * #### Example Usage:
+ * ```
+ * // While loading the level
+ * dsge::TextureCache::preload("enemy.t3x");
+ * 
+ * // Later on, costs nothing
+ * dsge::Sprite enemy(40, 40);
+ * enemy.loadGraphic("enemy.t3x");
+ * ```
+ */
+bool preload(const std::string& file);
+
+/**
+ * @brief Frees a cached sheet, only if no sprite is using it anymore.
+ * @param file Path to the sheet (without "romfs:/" prefix).
+ * @returns `true` if freed, `false` if it's still used or isn't cached.
+ * 
+ * #### Example Usage:
+ * ```
+ * dsge::TextureCache::evict("boss.t3x"); // Boss fight is over.
+ * ```
+ */
+bool evict(const std::string& file);
+
+/**
+ * @brief Frees every cached sheet that no sprite is using.
+ * 
+ * #### Example Usage:
+ * ```
+ * dsge::TextureCache::evictUnused(); // Changing levels
+ * ```
+ */
+void evictUnused();
+
+/**
+ * @brief Sets the texture memory budget of the cache, 8MB by default.
+ * @param bytes The budget in bytes.
+ * 
+ * Once the cache is over budget, the least recently used sheets that no sprite is using are freed. Sheets that are in use are never freed. Collision masks count towards it too, they go along with their sheet.
+ * 
+ * #### Example Usage:
+ * ```
+ * dsge::TextureCache::setBudget(4 * 1024 * 1024); // 4MB
+ * ```
+ */
+void setBudget(size_t bytes);
+
+/**
+ * @brief Returns the hit, miss and memory statistics of the cache.
+ * 
+ * #### Example Usage:
+ * ```
+ * textureStats stats = dsge::TextureCache::getStats();
+ * trace(TSA(stats.hits) + " hits, " + dsge::Utils::formatBytes(stats.bytes));
+ * ```
+ */
+textureStats getStats();
+
+C2D_SpriteSheet _acquire(const std::string& file);
+const _internal::PixelMask* _mask(C2D_SpriteSheet sheet, size_t image);
+void _retain(C2D_SpriteSheet sheet);
+void _release(C2D_SpriteSheet sheet);
+void _clear();
+}
+} // namespace dsge
+
+#endif
@@ -1,25 +1,266 @@
 #include "timer.hpp"
-#include <3ds.h>
-#include <thread>
+#include "dsge.hpp"
+#include <cmath>
+#include <vector>
+
+namespace {
+    // A hierarchical timer wheel in milliseconds, 4 levels of 64 slots.
+    // Level 0 holds timers due in the next 64ms, every level above covers 64 times more,
+    // and a slot is spread out to the level below once the wheel reaches it.
+    constexpr int LEVELS = 4;
+    constexpr int SLOT_BITS = 6;
+    constexpr u32 SLOTS = 1 << SLOT_BITS;
+    constexpr u32 SLOT_MASK = SLOTS - 1;
+    constexpr u64 WHEEL_SPAN = 1ull << (SLOT_BITS * LEVELS);
+    constexpr u32 NIL = 0xFFFFFFFF;
+
+    struct Entry {
+        std::function<void()> callback;
+        u64 base;        // Time the timer (re)started, every loop is timed from it.
+        double interval; // Milliseconds between calls.
+        u64 deadline;    // Time of the next call.
+        u64 pausedAt;
+        u32 fired;       // Loops done since `base`.
+        int loops;       // 0 is forever.
+        u32 generation;
+        u32 prev, next;  // Links inside of the wheel slot.
+        u8 level, slot;
+        bool linked, paused, firing, cancelled;
+    };
+
+    struct Wheel {
+        std::vector<Entry> entries;
+        std::vector<u32> freeEntries;
+        u32 heads[LEVELS][SLOTS];
+        u64 current = 0; // Last millisecond that has been run.
+        bool started = false;
+        size_t active = 0;
+
+        Wheel() {
+            for (int l = 0; l < LEVELS; l++) {
+                for (u32 s = 0; s < SLOTS; s++) heads[l][s] = NIL;
+            }
+        }
+
+        void link(u32 id) {
+            Entry& e = entries[id];
+
+            // Anything late goes in the next slot, it gets called on the next tick.
+            u64 deadline = e.deadline > current ? e.deadline : current + 1;
+            u64 delta = deadline - current;
+            if (delta >= WHEEL_SPAN) deadline = current + WHEEL_SPAN - 1;
+
+            int level = 0;
+            while (level < LEVELS - 1 && delta >= (1ull << (SLOT_BITS * (level + 1)))) level++;
+
+            e.level = level;
+            e.slot = (deadline >> (SLOT_BITS * level)) & SLOT_MASK;
+            e.prev = NIL;
+            e.next = heads[level][e.slot];
+            if (e.next != NIL) entries[e.next].prev = id;
+            heads[level][e.slot] = id;
+            e.linked = true;
+        }
+
+        void unlink(u32 id) {
+            Entry& e = entries[id];
+            if (!e.linked) return;
+
+            if (e.prev != NIL) entries[e.prev].next = e.next;
+            else heads[e.level][e.slot] = e.next;
+            if (e.next != NIL) entries[e.next].prev = e.prev;
+            e.linked = false;
+        }
+
+        void schedule(u32 id) {
+            Entry& e = entries[id];
+            e.deadline = e.base + (u64)llround(e.interval * (e.fired + 1));
+            link(id);
+        }
+
+        void release(u32 id) {
+            Entry& e = entries[id];
+            unlink(id);
+            e.callback = nullptr;
+            if (++e.generation == 0) e.generation = 1;
+            freeEntries.push_back(id);
+            active--;
+        }
+
+        // Spreads a slot of a higher level out to the levels below.
+        void cascade(int level, u32 slot) {
+            u32 id = heads[level][slot];
+            heads[level][slot] = NIL;
+            while (id != NIL) {
+                u32 next = entries[id].next;
+                entries[id].linked = false;
+                link(id);
+                id = next;
+            }
+        }
+
+        void fire(u32 id) {
+            Entry& e = entries[id];
+            e.firing = true;
+            e.fired++;
+
+            // Moved out while it runs, the callback may start timers and grow `entries`.
+            std::function<void()> callback = std::move(e.callback);
+            callback();
+
+            Entry& after = entries[id];
+            after.callback = std::move(callback);
+            after.firing = false;
+
+            if (after.cancelled || (after.loops > 0 && after.fired >= (u32)after.loops)) {
+                release(id);
+            } else if (!after.paused) {
+                schedule(id);
+            }
+        }
+
+        void tick() {
+            current++;
+
+            for (int level = 1; level < LEVELS; level++) {
+                u64 low = current >> (SLOT_BITS * (level - 1));
+                if ((low & SLOT_MASK) != 0) break;
+                cascade(level, (current >> (SLOT_BITS * level)) & SLOT_MASK);
+            }
+
+            u32 slot = current & SLOT_MASK;
+            while (heads[0][slot] != NIL) {
+                u32 id = heads[0][slot];
+                unlink(id);
+                fire(id);
+            }
+        }
+    };
+
+    Wheel& wheel() {
+        static Wheel w;
+        return w;
+    }
+
+    Entry* find(dsge::TimerHandle handle) {
+        Wheel& w = wheel();
+        if (handle.generation == 0 || handle.index >= w.entries.size()) return nullptr;
+
+        Entry& e = w.entries[handle.index];
+        if (e.generation != handle.generation || e.cancelled) return nullptr;
+        return &e;
+    }
+}
 
 namespace dsge {
 namespace Timer {
 
-void start(float seconds, std::function<void()> callback, int loops) {
-    if (loops <= 0) {
-        loops = 2147483647;
+TimerHandle start(float seconds, std::function<void()> callback, int loops) {
+    if (!callback) {
+        trace("[WARN] Timer::start: Callback is empty!");
+        return {};
     }
 
-    std::thread([seconds, callback, loops]() {
-        for (int i = 0; i < loops; i++) {
-            // Sleep for the specified duration
-            svcSleepThread(1000000000 * seconds);
-            
-            // Execute the callback
-            callback();
-        }
-    }).detach();
+    Wheel& w = wheel();
+    u64 now = Replay::_clockMs();
+    if (!w.started) {
+        w.current = now;
+        w.started = true;
+    }
+
+    u32 id;
+    if (!w.freeEntries.empty()) {
+        id = w.freeEntries.back();
+        w.freeEntries.pop_back();
+    } else {
+        id = w.entries.size();
+        w.entries.emplace_back();
+        w.entries[id].generation = 1;
+    }
+
+    Entry& e = w.entries[id];
+    e.callback = std::move(callback);
+    e.base = now;
+    e.interval = seconds > 0 ? seconds * 1000.0 : 0;
+    e.fired = 0;
+    e.loops = loops > 0 ? loops : 0;
+    e.linked = e.paused = e.firing = e.cancelled = false;
+    w.active++;
+    w.schedule(id);
+
+    return {id, e.generation};
+}
+
+bool cancel(TimerHandle handle) {
+    Entry* e = find(handle);
+    if (!e) return false;
+
+    // A running callback is freed once it returns.
+    if (e->firing) e->cancelled = true;
+    else wheel().release(handle.index);
+    return true;
+}
+
+bool pause(TimerHandle handle) {
+    Entry* e = find(handle);
+    if (!e || e->paused) return false;
+
+    e->paused = true;
+    e->pausedAt = Replay::_clockMs();
+    wheel().unlink(handle.index);
+    return true;
+}
+
+bool resume(TimerHandle handle) {
+    Entry* e = find(handle);
+    if (!e || !e->paused) return false;
+
+    e->paused = false;
+    e->base += Replay::_clockMs() - e->pausedAt;
+    if (!e->firing) wheel().schedule(handle.index);
+    return true;
+}
+
+bool reset(TimerHandle handle) {
+    Entry* e = find(handle);
+    if (!e) return false;
+
+    e->base = Replay::_clockMs();
+    e->fired = 0;
+    if (e->paused) {
+        e->pausedAt = e->base;
+    } else if (!e->firing) {
+        wheel().unlink(handle.index);
+        wheel().schedule(handle.index);
+    }
+    return true;
+}
+
+bool isActive(TimerHandle handle) {
+    return find(handle) != nullptr;
 }
 
+size_t activeCount() {
+    return wheel().active;
 }
-}
\ No newline at end of file
+
+void _update() {
+    DSGE_PROFILE_ZONE("Timer::_update");
+
+    Wheel& w = wheel();
+    u64 now = Replay::_clockMs();
+
+    // Nothing to run, no need to walk the wheel up to now.
+    if (w.active == 0 || !w.started) {
+        w.current = now;
+        w.started = true;
+        return;
+    }
+
+    while (w.current < now) {
+        w.tick();
+    }
+}
+
+} // namespace Timer
+} // namespace dsge
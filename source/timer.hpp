@@ -1,41 +1,90 @@
 #ifndef DSGE_TIMER_HPP
 #define DSGE_TIMER_HPP
 
+#include <3ds.h>
 #include <functional>
 
 namespace dsge {
+// A handle to a timer, stale once the timer has done all of it's loops or is cancelled.
+struct TimerHandle {
+    u32 index = 0;
+    u32 generation = 0; // 0 is never valid.
+};
+
 namespace Timer {
 
 /**
  * @brief Starts a timer that calls a function after a delay
  * @param seconds Delay in seconds before triggering
  * @param callback Function to call when timer completes
- * @param loops Number of times to repeat (default 1)
+ * @param loops Number of times to repeat (default 1), 0 or less repeats forever.
+ * @return A handle to cancel, pause or reset the timer.
  * 
  * #### Details:
  * 
- * The timer runs asynchronously without blocking the main thread.
- * 
- * The callback function will be called after the specified delay.
+ * The timer runs without blocking the main thread, callbacks are called from `dsge::render()` before anything is updated, so it's safe to touch sprites and texts in them.
  * 
- * If loops > 1, the timer will repeat after each interval.
+ * If loops > 1, the timer will repeat after each interval. Every loop is timed from when the timer started, so it doesn't drift.
  * 
  * #### Example Code:
  * ```
  * // One-time timer
- * DSGE::TIMER::start(2.5, []() {
+ * dsge::Timer::start(2.5, []() {
  *     trace("Timer done!");
  * });
  * 
  * // Repeating timer
- * DSGE::TIMER::start(1, []() {
+ * dsge::TimerHandle ping = dsge::Timer::start(1, []() {
  *     trace("Ping!");
  * }, 5); // Repeat 5 times
  * ```
  */
-void start(float seconds, std::function<void()> callback, int loops = 1);
+TimerHandle start(float seconds, std::function<void()> callback, int loops = 1);
+
+/**
+ * @brief Stops a timer, it's callback won't be called anymore.
+ * @param handle The handle from `Timer::start()`.
+ * @return `true` if the timer was still running.
+ */
+bool cancel(TimerHandle handle);
+
+/**
+ * @brief Pauses a timer, the time left is kept until `Timer::resume()`.
+ * @param handle The handle from `Timer::start()`.
+ * @return `true` if the timer got paused, `false` if it's already paused or not running.
+ */
+bool pause(TimerHandle handle);
+
+/**
+ * @brief Resumes a paused timer.
+ * @param handle The handle from `Timer::start()`.
+ * @return `true` if the timer got resumed, `false` if it wasn't paused or not running.
+ */
+bool resume(TimerHandle handle);
+
+/**
+ * @brief Starts the timer over from now, with all of it's loops.
+ * @param handle The handle from `Timer::start()`.
+ * @return `true` if the timer is still running.
+ * 
+ * A paused timer stays paused.
+ */
+bool reset(TimerHandle handle);
+
+/**
+ * @brief Checks if a timer is still running, paused ones count as running.
+ * @param handle The handle from `Timer::start()`.
+ */
+bool isActive(TimerHandle handle);
+
+/**
+ * @brief Amount of timers running right now, including paused ones.
+ */
+size_t activeCount();
+
+void _update();
 
-} // namespace TIMER
-} // namespace DSGE
+} // namespace Timer
+} // namespace dsge
 
-#endif
\ No newline at end of file
+#endif
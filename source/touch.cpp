@@ -1,31 +1,181 @@
 #include "touch.hpp"
 #include "sprite.hpp"
 #include "text.hpp"
+#include <algorithm>
 
-namespace dsge {
-void Touch::update() {
-    hidScanInput();
+namespace {
+    // The bottom screen is split into CELLS_X * CELLS_Y cells, a target is listed in every cell it's box touches.
+    constexpr int CELL_SIZE = 40;
+    constexpr int CELLS_X = 320 / CELL_SIZE;
+    constexpr int CELLS_Y = 240 / CELL_SIZE;
+
+    struct Target {
+        dsge::Sprite* sprite;
+        dsge::Text* text;
+        dsge::touchCallback callback;
+        u32 order;   // When it got added, ties of the same layer and z go to the last one.
+    };
+
+    struct Targets {
+        std::vector<Target> list;
+        u32 cellStart[CELLS_X * CELLS_Y + 1];
+        std::vector<u32> cellItems;          // Every target whose box touches the cell, shown or not.
+        u32 nextOrder = 0;
+        bool dirty = true;                   // A target got added, removed or moved since the grid got built.
+
+        void* pressed = nullptr;             // Object the current touch started on, gets the drags and release.
+        u16 lastX = 0, lastY = 0;
+
+        dsge::TouchTarget cached;            // getTarget() of `cachedFrame`.
+        u32 cachedFrame = 0;
+    };
+
+    // Never freed, sprites and texts remove themselves in their destructors, globals included.
+    Targets& touchTargets() {
+        static Targets* t = new Targets();
+        return *t;
+    }
+
+    void* objectOf(const Target& t) {
+        return t.sprite ? (void*)t.sprite : (void*)t.text;
+    }
+
+    const dsge::_internal::Transform& transformOf(const Target& t) {
+        return t.sprite ? t.sprite->_private.transform : t.text->_private.transform;
+    }
+
+    // Members are placed by drawing them, so the last drawn transform is what's on screen. Anything else is placed
+    // here, once per frame and when it's added. Moving marks the grid dirty.
+    template<typename T>
+    void placeObject(T& obj) {
+        if (!dsge::isValid(obj._private.handle)) obj._updateTransform();
+    }
+
+    void place(Target& t) {
+        if (t.sprite) placeObject(*t.sprite);
+        else placeObject(*t.text);
+    }
+
+    // Visibility, layer and z are read at every lookup, the grid only holds where the targets are.
+    bool isShown(const Target& t) {
+        if (t.sprite) return t.sprite->visible && t.sprite->bottom && !t.sprite->_private.destroyed;
+        return t.text->visible && t.text->bottom && !t.text->_private.destroyed;
+    }
+
+    bool isAbove(const Target& a, const Target& b) {
+        u8 layerA = a.sprite ? a.sprite->layer : a.text->layer;
+        u8 layerB = b.sprite ? b.sprite->layer : b.text->layer;
+        if (layerA != layerB) return layerA > layerB;
+
+        int zA = a.sprite ? a.sprite->z : a.text->z;
+        int zB = b.sprite ? b.sprite->z : b.text->z;
+        if (zA != zB) return zA > zB;
+        return a.order > b.order;
+    }
+
+    // Only rebuilds the grid if something changed since the last lookup.
+    void rebuild() {
+        auto& targets = touchTargets();
+        if (!targets.dirty) return;
+        targets.dirty = false;
+
+        DSGE_PROFILE_ZONE("Touch::rebuild");
+
+        auto& list = targets.list;
+        auto cellsOf = [&](u32 i, int& x0, int& y0, int& x1, int& y1) {
+            const dsge::_internal::Bounds& b = transformOf(list[i]).bounds;
+
+            x0 = std::max(0, (int)floorf(b.left / CELL_SIZE));
+            y0 = std::max(0, (int)floorf(b.top / CELL_SIZE));
+            x1 = std::min(CELLS_X - 1, (int)floorf(b.right / CELL_SIZE));
+            y1 = std::min(CELLS_Y - 1, (int)floorf(b.bottom / CELL_SIZE));
+            return x0 <= x1 && y0 <= y1;
+        };
+
+        // Counting sort into the cells, same as the collision groups.
+        std::fill(std::begin(targets.cellStart), std::end(targets.cellStart), 0);
+        int x0, y0, x1, y1;
+        for (u32 i = 0; i < list.size(); i++) {
+            if (!cellsOf(i, x0, y0, x1, y1)) continue;
+            for (int cy = y0; cy <= y1; cy++) {
+                for (int cx = x0; cx <= x1; cx++) targets.cellStart[cy * CELLS_X + cx]++;
+            }
+        }
+
+        for (int c = 1; c <= CELLS_X * CELLS_Y; c++) targets.cellStart[c] += targets.cellStart[c - 1];
+        targets.cellItems.resize(targets.cellStart[CELLS_X * CELLS_Y]);
+
+        for (u32 i = 0; i < list.size(); i++) {
+            if (!cellsOf(i, x0, y0, x1, y1)) continue;
+            for (int cy = y0; cy <= y1; cy++) {
+                for (int cx = x0; cx <= x1; cx++) targets.cellItems[--targets.cellStart[cy * CELLS_X + cx]] = i;
+            }
+        }
+    }
+
+    // Exact test in the object's own space, so rotated and flipped objects are hit where they're drawn.
+    bool contains(const Target& t, float x, float y) {
+        const dsge::_internal::Transform& tr = transformOf(t);
+        const dsge::_internal::Bounds& b = tr.bounds;
+        if (x < b.left || x >= b.right || y < b.top || y >= b.bottom) return false;
+
+        const dsge::_internal::Affine& m = tr.world;
+        float det = m.a * m.d - m.b * m.c;
+        if (det == 0) return false;
+
+        float dx = x - m.tx, dy = y - m.ty;
+        float lx = (m.d * dx - m.c * dy) / det;
+        float ly = (m.a * dy - m.b * dx) / det;
+
+        float w = t.sprite ? t.sprite->width : t.text->width;
+        float h = t.sprite ? t.sprite->height : t.text->height;
+        return lx >= 0 && lx < w && ly >= 0 && ly < h;
+    }
+
+    // Only looks at the targets of one cell, the topmost of them that's shown and hit wins.
+    Target* find(float x, float y) {
+        rebuild();
+        if (x < 0 || y < 0 || x >= CELLS_X * CELL_SIZE || y >= CELLS_Y * CELL_SIZE) return nullptr;
+
+        auto& targets = touchTargets();
+        int cell = (int)(y / CELL_SIZE) * CELLS_X + (int)(x / CELL_SIZE);
+        Target* top = nullptr;
+        for (u32 k = targets.cellStart[cell]; k < targets.cellStart[cell + 1]; k++) {
+            Target& t = targets.list[targets.cellItems[k]];
+            if ((!top || isAbove(t, *top)) && isShown(t) && contains(t, x, y)) top = &t;
+        }
+
+        return top;
+    }
+
+    template<typename T>
+    void insert(T& obj, dsge::Sprite* sprite, dsge::Text* text, dsge::touchCallback callback) {
+        if (obj._private.touchTarget) dsge::Touch::_removeTarget(&obj);
+
+        auto& targets = touchTargets();
+        targets.list.push_back({sprite, text, callback, targets.nextOrder++});
+        place(targets.list.back());
+        obj._private.touchTarget = true;
+        targets.dirty = true;
+        targets.cachedFrame = 0;
+    }
 }
 
+namespace dsge {
 touchPosition Touch::getTouchData() {
-    touchPosition t;
-    hidTouchRead(&t);
-    return t;
+    return Input::state().touch;
 }
 
 bool Touch::isTouchHeld() {
-    update();
-    return hidKeysHeld() & KEY_TOUCH;
+    return Input::isHeld(KEY_TOUCH);
 }
 
 bool Touch::isTouchDown() {
-    update();
-    return hidKeysDown() & KEY_TOUCH;
+    return Input::isDown(KEY_TOUCH);
 }
 
 bool Touch::isTouchUp() {
-    update();
-    return hidKeysUp() & KEY_TOUCH;
+    return Input::isUp(KEY_TOUCH);
 }
 
 u16 Touch::getTouchX() {
@@ -55,4 +205,122 @@ bool Touch::isTouching(dsge::Sprite& obj) {
 bool Touch::isTouching(dsge::Text& obj) {
     return isTouching_impl(obj);
 }
+
+void Touch::addTarget(dsge::Sprite& obj, touchCallback callback) {
+    insert(obj, &obj, nullptr, callback);
+}
+
+void Touch::addTarget(dsge::Text& obj, touchCallback callback) {
+    insert(obj, nullptr, &obj, callback);
+}
+
+bool Touch::removeTarget(dsge::Sprite& obj) {
+    if (!obj._private.touchTarget) return false;
+    _removeTarget(&obj);
+    return true;
+}
+
+bool Touch::removeTarget(dsge::Text& obj) {
+    if (!obj._private.touchTarget) return false;
+    _removeTarget(&obj);
+    return true;
+}
+
+TouchTarget Touch::hitTest(float x, float y) {
+    DSGE_PROFILE_ZONE("Touch::hitTest");
+
+    Target* t = find(x, y);
+    if (!t) return {};
+    return {t->sprite, t->text};
+}
+
+TouchTarget Touch::getTarget() {
+    const inputState& in = Input::state();
+    if (!(in.held & KEY_TOUCH)) return {};
+
+    auto& targets = touchTargets();
+    if (targets.cachedFrame != in.frame) {
+        targets.cached = hitTest(in.touch.px, in.touch.py);
+        targets.cachedFrame = in.frame;
+    }
+    return targets.cached;
+}
+
+bool Touch::isTouchingTop(dsge::Sprite& obj) {
+    return obj._private.touchTarget && getTarget().sprite == &obj;
+}
+
+bool Touch::isTouchingTop(dsge::Text& obj) {
+    return obj._private.touchTarget && getTarget().text == &obj;
+}
+
+void Touch::_dispatch() {
+    auto& targets = touchTargets();
+    if (targets.list.empty()) return;
+
+    for (auto &&t : targets.list) {
+        place(t);
+    }
+
+    const inputState& in = Input::state();
+    u16 x = in.touch.px, y = in.touch.py;
+
+    if (in.down & KEY_TOUCH) {
+        Target* t = find(x, y);
+        targets.pressed = t ? objectOf(*t) : nullptr;
+        targets.lastX = x;
+        targets.lastY = y;
+
+        // Copied, the callback may remove it's own target.
+        touchCallback callback = t ? t->callback : nullptr;
+        if (callback) callback({INPUT_PRESS, KEY_TOUCH, x, y, in.frame});
+        return;
+    }
+
+    if (!targets.pressed) return;
+
+    // Looked up every time, the target may have been removed since it got pressed.
+    auto callback = [&](inputEventType type) {
+        for (auto &&t : targets.list) {
+            if (objectOf(t) != targets.pressed) continue;
+
+            touchCallback copy = t.callback;
+            if (copy) copy({type, KEY_TOUCH, x, y, in.frame});
+            return;
+        }
+    };
+
+    if (in.up & KEY_TOUCH) {
+        callback(INPUT_RELEASE);
+        targets.pressed = nullptr;
+    } else if ((in.held & KEY_TOUCH) && (x != targets.lastX || y != targets.lastY)) {
+        targets.lastX = x;
+        targets.lastY = y;
+        callback(INPUT_DRAG);
+    }
+}
+
+void Touch::_removeTarget(void* obj) {
+    auto& targets = touchTargets();
+    auto& list = targets.list;
+    for (size_t i = 0; i < list.size(); i++) {
+        if (objectOf(list[i]) != obj) continue;
+
+        if (list[i].sprite) list[i].sprite->_private.touchTarget = false;
+        else list[i].text->_private.touchTarget = false;
+
+        list[i] = std::move(list.back());
+        list.pop_back();
+        break;
+    }
+
+    if (targets.pressed == obj) targets.pressed = nullptr;
+    targets.dirty = true;
+    targets.cachedFrame = 0;
+    targets.cached = {};
+}
+
+void Touch::_markDirty() {
+    touchTargets().dirty = true;
+}
 } // namespace dsge
\ No newline at end of file
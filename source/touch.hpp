@@ -4,6 +4,19 @@
 #include "dsge.hpp"
 
 namespace dsge {
+// Called with every press, drag and release of a touch target, see `Touch::addTarget()`.
+typedef std::function<void(const inputEvent& e)> touchCallback;
+
+/**
+ * @brief The target found by a hit test, at most one of both is set.
+ */
+struct TouchTarget {
+    Sprite* sprite = nullptr;
+    Text* text = nullptr;
+
+    explicit operator bool() const { return sprite || text; }
+};
+
 class Touch {
 public:
     /**
@@ -113,8 +126,90 @@ public:
     static bool isTouching(dsge::Sprite& obj);
     static bool isTouching(dsge::Text& obj);
 
+    /**
+     * @brief Makes a sprite or text a touch target, so it can be found by `Touch::hitTest()` and get touch callbacks.
+     * @param obj The object, has to be in the bottom screen to be hit.
+     * @param callback Called from `dsge::render()` when the object gets pressed, and then for every drag and the release of that touch.
+     *
+     * #### Details:
+     *
+     * Targets are kept in a coarse grid of the bottom screen, which is only rebuilt once one of them moved or got
+     * added. So finding what's under the stylus only looks at the few targets around it, no matter how many there are.
+     *
+     * Only the topmost visible target under the stylus is hit, in the same order they're drawn in: by layer, then z,
+     * then the order they got added as targets. Rotation, scale and flip are taken into account.
+     *
+     * The target is removed when the object is destroyed.
+     *
+     * #### Example Usage:
+     * ```
+     * dsge::Sprite button(20, 20);
+     * button.makeGraphic(60, 30);
+     * button.bottom = true;
+     * dsge::add(button);
+     *
+     * dsge::Touch::addTarget(button, [&](const dsge::inputEvent& e) {
+     *     if (e.type == INPUT_RELEASE) trace("Clicked!");
+     * });
+     * ```
+     */
+    static void addTarget(dsge::Sprite& obj, touchCallback callback = nullptr);
+    static void addTarget(dsge::Text& obj, touchCallback callback = nullptr);
+
+    /**
+     * @brief Stops an object from being a touch target.
+     * @return `true` if it was one.
+     */
+    static bool removeTarget(dsge::Sprite& obj);
+    static bool removeTarget(dsge::Text& obj);
+
+    /**
+     * @brief Finds the topmost touch target at a position of the bottom screen.
+     * @param x The X position, from 0 to 320.
+     * @param y The Y position, from 0 to 240.
+     * @return The target, empty if there's none.
+     *
+     * Objects added with `dsge::add()` are hit where they've been drawn last, so what's on screen is what gets touched.
+     *
+     * #### Example Usage:
+     * ```
+     * dsge::TouchTarget hit = dsge::Touch::hitTest(160, 120);
+     * if (hit.sprite == &button) {
+     *     trace("Button is in the middle!");
+     * }
+     * ```
+     */
+    static TouchTarget hitTest(float x, float y);
+
+    /**
+     * @brief The topmost touch target under the stylus, empty if the screen isn't touched.
+     *
+     * Looked up once per frame, any other call in the same frame returns the same target.
+     */
+    static TouchTarget getTarget();
+
+    /**
+     * @brief Like `Touch::isTouching()`, but only if the object is the topmost touch target under the stylus.
+     * @param obj The object, it has to be added with `Touch::addTarget()`.
+     * @returns `true` if it's touched and nothing is above it, `false` otherwise.
+     *
+     * #### Example Usage:
+     * ```
+     * for (auto &&slot : inventory) {
+     *     if (dsge::Touch::isTouchingTop(slot)) { // Doesn't test every slot, the target is found only once.
+     *         slot.alpha = 0.5;
+     *     }
+     * }
+     * ```
+     */
+    static bool isTouchingTop(dsge::Sprite& obj);
+    static bool isTouchingTop(dsge::Text& obj);
+
+    static void _dispatch();
+    static void _removeTarget(void* obj);
+    static void _markDirty(); // A target moved, the grid gets rebuilt by the next lookup.
+
 private:
-    static void update();
     static touchPosition getTouchData();
 
     template<typename T>
@@ -0,0 +1,148 @@
+#include "transform.hpp"
+#include <algorithm>
+#include <math.h>
+
+namespace dsge {
+namespace _internal {
+Transform::Transform() :
+    world{1, 0, 0, 1, 0, 0},
+    bounds{0, 0, 0, 0},
+    worldAngle(0),
+    worldScaleX(1),
+    worldScaleY(1),
+    version(0),
+    cached{},
+    local{1, 0, 0, 1, 0, 0},
+    valid(false),
+    parentVersion(0),
+    parent(nullptr),
+    owner(nullptr),
+    refresher(nullptr)
+{}
+
+Transform::Transform(const Transform& other) : Transform() {
+    (void)other;
+}
+
+Transform& Transform::operator=(const Transform& other) {
+    // Links and owner stays with the object, only force a rebuild.
+    (void)other;
+    valid = false;
+    return *this;
+}
+
+Transform::~Transform() {
+    detach();
+    detachChildren();
+}
+
+void Transform::bind(void* owner, refreshFunc refresh) {
+    this->owner = owner;
+    this->refresher = refresh;
+}
+
+void Transform::refresh() {
+    if (refresher) {
+        refresher(owner);
+    }
+}
+
+bool Transform::update(const Inputs& in) {
+    // Parents first, it's a simple compare if nothing changed.
+    if (parent) {
+        parent->refresh();
+    }
+
+    bool localDirty = !valid || !(in == cached);
+    bool parentDirty = parent && parent->version != parentVersion;
+    if (!localDirty && !parentDirty) return false;
+
+    if (localDirty) {
+        float rad = in.angle * (M_PI / 180);
+        float c = cosf(rad);
+        float s = sinf(rad);
+
+        // T(x + pivot) * R(angle) * S(scale) * T(-origin)
+        float ox = in.originX;
+        float oy = in.originY;
+
+        local.a = c * in.scaleX;
+        local.b = s * in.scaleX;
+        local.c = -s * in.scaleY;
+        local.d = c * in.scaleY;
+        local.tx = in.x + in.pivotX - (local.a * ox + local.c * oy);
+        local.ty = in.y + in.pivotY - (local.b * ox + local.d * oy);
+
+        cached = in;
+        valid = true;
+    }
+
+    world = parent ? parent->world * local : local;
+    parentVersion = parent ? parent->version : 0;
+
+    // Decomposed so it can be drawn with citro2d's position/angle/size parameters.
+    worldAngle = atan2f(world.b, world.a);
+    worldScaleX = sqrtf(world.a * world.a + world.b * world.b);
+    worldScaleY = worldScaleX != 0 ? (world.a * world.d - world.b * world.c) / worldScaleX : 0;
+
+    float px[4], py[4];
+    world.apply(0, 0, px[0], py[0]);
+    world.apply(in.width, 0, px[1], py[1]);
+    world.apply(0, in.height, px[2], py[2]);
+    world.apply(in.width, in.height, px[3], py[3]);
+
+    bounds = {px[0], py[0], px[0], py[0]};
+    for (int i = 1; i < 4; i++) {
+        bounds.left = fminf(bounds.left, px[i]);
+        bounds.top = fminf(bounds.top, py[i]);
+        bounds.right = fmaxf(bounds.right, px[i]);
+        bounds.bottom = fmaxf(bounds.bottom, py[i]);
+    }
+
+    version++;
+    return true;
+}
+
+Transform::ImageQuad Transform::imageQuad(float width, float height) const {
+    // citro2d only uses the sign of the size to swap the texture coordinates, the quad itself always goes from
+    // (x, y) along the rotated axes. A flipped side has to start from the opposite corner to stay in place.
+    ImageQuad quad;
+    world.apply(worldScaleX < 0 ? width : 0, worldScaleY < 0 ? height : 0, quad.x, quad.y);
+    quad.w = width * worldScaleX;
+    quad.h = height * worldScaleY;
+    quad.angle = worldAngle;
+    return quad;
+}
+
+void Transform::attach(Transform& child) {
+    if (&child == this || child.parent == this) return;
+
+    // Refuse cycles, a child can't become the parent of one of it's ancestors.
+    for (Transform* p = parent; p; p = p->parent) {
+        if (p == &child) return;
+    }
+
+    child.detach();
+    child.parent = this;
+    child.valid = false;
+    children.push_back(&child);
+}
+
+void Transform::detach() {
+    if (!parent) return;
+
+    auto& siblings = parent->children;
+    siblings.erase(std::remove(siblings.begin(), siblings.end(), this), siblings.end());
+    parent = nullptr;
+    valid = false;
+}
+
+void Transform::detachChildren() {
+    for (auto &&child : children) {
+        child->parent = nullptr;
+        child->valid = false;
+    }
+    children.clear();
+}
+}
+} // namespace dsge
@@ -0,0 +1,97 @@
+#ifndef DSGE_TRANSFORM_HPP
+#define DSGE_TRANSFORM_HPP
+
+#include <3ds.h>
+#include <vector>
+
+namespace dsge {
+namespace _internal {
+    // 2D affine matrix, maps (x, y) to (a * x + c * y + tx, b * x + d * y + ty).
+    struct Affine {
+        float a, b, c, d, tx, ty;
+
+        Affine operator*(const Affine& o) const {
+            return {
+                a * o.a + c * o.b, b * o.a + d * o.b,
+                a * o.c + c * o.d, b * o.c + d * o.d,
+                a * o.tx + c * o.ty + tx, b * o.tx + d * o.ty + ty
+            };
+        }
+
+        void apply(float x, float y, float& outX, float& outY) const {
+            outX = a * x + c * y + tx;
+            outY = b * x + d * y + ty;
+        }
+    };
+
+    struct Bounds {
+        float left, top, right, bottom;
+    };
+
+    /**
+     * Cached local and world transform of a sprite or text.
+     * 
+     * The matrices and world bounds are only rebuilt if the inputs (position, angle, scale, flip, size) or the parent's world transform changed since the last update.
+     * 
+     * Children are positioned in their parent's space, with (0, 0) being the parent's top left corner before rotation.
+     */
+    class Transform {
+    public:
+        struct Inputs {
+            float x, y;           // Position of the pivot, before the pivot offset.
+            float angle;          // Rotation in degrees, around the pivot.
+            float scaleX, scaleY; // Scale, negative if flipped.
+            float pivotX, pivotY; // Offset from (x, y) to the pivot.
+            float originX, originY; // The pivot in the object's own space.
+            float width, height;  // Size of the object, in it's own space.
+
+            bool operator==(const Inputs& other) const = default;
+        };
+
+        typedef void (*refreshFunc)(void* owner);
+
+        // What to give citro2d's C2D_DrawImage() for an image of the object's size to cover `bounds`.
+        struct ImageQuad {
+            float x, y;   // Corner the quad starts from.
+            float w, h;   // Size, negative to flip the texture.
+            float angle;  // In radians.
+        };
+
+        Affine world;        // Object space to screen space.
+        Bounds bounds;       // Screen space bounding box.
+        float  worldAngle;   // Rotation of `world`, in radians.
+        float  worldScaleX;  // Horizontal scale of `world`, negative if flipped.
+        float  worldScaleY;  // Vertical scale of `world`, negative if flipped.
+        u32    version;      // Bumped every time `world` changes.
+
+        Transform();
+        Transform(const Transform& other); // Copies are never attached to anything.
+        Transform& operator=(const Transform& other);
+        ~Transform();
+
+        void bind(void* owner, refreshFunc refresh);
+        bool update(const Inputs& in);
+        void refresh();
+        ImageQuad imageQuad(float width, float height) const;
+
+        void attach(Transform& child);
+        void detach();
+        void detachChildren();
+        Transform* getParent() const { return parent; }
+
+    private:
+        Inputs cached;
+        Affine local;
+        bool   valid;
+        u32    parentVersion;
+
+        Transform* parent;
+        std::vector<Transform*> children;
+
+        void* owner;
+        refreshFunc refresher;
+    };
+}
+} // namespace dsge
+
+#endif
@@ -0,0 +1,297 @@
+#include "tween.hpp"
+#include <vector>
+
+namespace {
+    // Easing tables, baked once and linearly interpolated.
+    constexpr int EASE_SAMPLES = 128;
+    float easeTables[EASE_COUNT][EASE_SAMPLES + 1];
+    bool tablesBaked = false;
+
+    float bounceOut(float t) {
+        const float n1 = 7.5625, d1 = 2.75;
+        if (t < 1 / d1) return n1 * t * t;
+        if (t < 2 / d1) { t -= 1.5 / d1; return n1 * t * t + 0.75; }
+        if (t < 2.5 / d1) { t -= 2.25 / d1; return n1 * t * t + 0.9375; }
+        t -= 2.625 / d1;
+        return n1 * t * t + 0.984375;
+    }
+
+    // The "in" curve of every family, "out" and "in out" are made from it.
+    float easeIn(int family, float t) {
+        switch (family) {
+            case 0: return t * t;
+            case 1: return t * t * t;
+            case 2: return t * t * t * t;
+            case 3: return t * t * t * t * t;
+            case 4: return 1 - cosf(t * M_PI / 2);
+            case 5: return t == 0 ? 0 : powf(2, 10 * t - 10);
+            case 6: return 1 - sqrtf(1 - t * t);
+            case 7: return 2.70158 * t * t * t - 1.70158 * t * t;
+            case 8: return t == 0 || t == 1 ? t : -powf(2, 10 * t - 10) * sinf((t * 10 - 10.75) * (2 * M_PI / 3));
+            case 9: return 1 - bounceOut(1 - t);
+        }
+        return t;
+    }
+
+    float easeExact(int type, float t) {
+        if (type == EASE_LINEAR) return t;
+
+        int family = (type - 1) / 3;
+        switch ((type - 1) % 3) {
+            case 0: return easeIn(family, t);
+            case 1: return 1 - easeIn(family, 1 - t);
+            default: return t < 0.5 ? easeIn(family, t * 2) / 2 : 1 - easeIn(family, 2 - t * 2) / 2;
+        }
+    }
+
+    void bakeTables() {
+        for (int type = 0; type < EASE_COUNT; type++) {
+            for (int i = 0; i <= EASE_SAMPLES; i++) {
+                easeTables[type][i] = easeExact(type, (float)i / EASE_SAMPLES);
+            }
+        }
+        tablesBaked = true;
+    }
+
+    // Every running tween, as a structure of arrays so the update loop only touches what it needs.
+    // Finished tweens are swap-removed, the arrays only grow so nothing is allocated once warmed up.
+    struct TweenPool {
+        std::vector<float*> target;
+        std::vector<float*> target2; // Second field for TWEEN_SCALE, nullptr otherwise.
+        std::vector<float> from;
+        std::vector<float> to;
+        std::vector<float> time;     // Seconds since the tween got made, including the delay.
+        std::vector<float> delay;
+        std::vector<float> invDuration;
+        std::vector<u8> easing;
+        std::vector<u8> started;     // The start value is taken once the delay is over.
+        std::vector<u16*> owner;     // Tween counter of the sprite or text.
+        std::vector<dsge::Tween::callback> onComplete;
+        std::vector<void*> userData;
+        std::vector<u32> slot;       // Handle slot of every tween.
+
+        // Handle slots, pointing to the dense arrays above.
+        std::vector<u32> slotDense;
+        std::vector<u32> slotGeneration;
+        std::vector<u32> freeSlots;
+
+        // Scratch space of the update, reused every frame.
+        std::vector<u32> finished;
+        std::vector<std::pair<dsge::Tween::callback, void*>> callbacks;
+
+        size_t size() const { return target.size(); }
+
+        void removeAt(size_t i) {
+            if (owner[i]) (*owner[i])--;
+
+            u32 s = slot[i];
+            if (++slotGeneration[s] == 0) slotGeneration[s] = 1;
+            freeSlots.push_back(s);
+
+            size_t last = size() - 1;
+            if (i != last) {
+                target[i] = target[last];
+                target2[i] = target2[last];
+                from[i] = from[last];
+                to[i] = to[last];
+                time[i] = time[last];
+                delay[i] = delay[last];
+                invDuration[i] = invDuration[last];
+                easing[i] = easing[last];
+                started[i] = started[last];
+                owner[i] = owner[last];
+                onComplete[i] = onComplete[last];
+                userData[i] = userData[last];
+                slot[i] = slot[last];
+                slotDense[slot[i]] = i;
+            }
+
+            target.pop_back();
+            target2.pop_back();
+            from.pop_back();
+            to.pop_back();
+            time.pop_back();
+            delay.pop_back();
+            invDuration.pop_back();
+            easing.pop_back();
+            started.pop_back();
+            owner.pop_back();
+            onComplete.pop_back();
+            userData.pop_back();
+            slot.pop_back();
+        }
+    };
+
+    TweenPool& pool() {
+        static TweenPool p;
+        return p;
+    }
+
+    dsge::TweenHandle addTween(float* target, float* target2, u16* owner, float value, float duration, easeType ease, dsge::Tween::callback onComplete, void* userData, float delay) {
+        TweenPool& p = pool();
+
+        u32 s;
+        if (!p.freeSlots.empty()) {
+            s = p.freeSlots.back();
+            p.freeSlots.pop_back();
+        } else {
+            s = p.slotDense.size();
+            p.slotDense.push_back(0);
+            p.slotGeneration.push_back(1);
+            p.freeSlots.reserve(p.slotDense.capacity());
+        }
+        p.slotDense[s] = p.size();
+
+        p.target.push_back(target);
+        p.target2.push_back(target2);
+        p.from.push_back(*target);
+        p.to.push_back(value);
+        p.time.push_back(0);
+        p.delay.push_back(delay > 0 ? delay : 0);
+        p.invDuration.push_back(duration > 0 ? 1 / duration : 0);
+        p.easing.push_back(ease < EASE_COUNT ? ease : EASE_LINEAR);
+        p.started.push_back(delay <= 0);
+        p.owner.push_back(owner);
+        p.onComplete.push_back(onComplete);
+        p.userData.push_back(userData);
+        p.slot.push_back(s);
+
+        // Room for every tween to finish in the same frame, so the scratch space only grows along with the pool.
+        if (p.finished.capacity() < p.target.capacity()) {
+            p.finished.reserve(p.target.capacity());
+            p.callbacks.reserve(p.target.capacity());
+        }
+
+        if (owner) (*owner)++;
+        return {s, p.slotGeneration[s]};
+    }
+
+    template<typename T>
+    dsge::TweenHandle addTo(T& obj, tweenProperty property, float value, float duration, easeType ease, dsge::Tween::callback onComplete, void* userData, float delay) {
+        if (obj._private.destroyed) return {};
+
+        float* target = nullptr;
+        float* target2 = nullptr;
+        switch (property) {
+            case TWEEN_X:       target = &obj.x; break;
+            case TWEEN_Y:       target = &obj.y; break;
+            case TWEEN_ALPHA:   target = &obj.alpha; break;
+            case TWEEN_ANGLE:   target = &obj.angle; break;
+            case TWEEN_SCALE:   target = &obj.scale.x; target2 = &obj.scale.y; break;
+            case TWEEN_SCALE_X: target = &obj.scale.x; break;
+            case TWEEN_SCALE_Y: target = &obj.scale.y; break;
+        }
+        if (!target) return {};
+
+        return addTween(target, target2, &obj._private.tweens, value, duration, ease, onComplete, userData, delay);
+    }
+}
+
+namespace dsge {
+TweenHandle Tween::to(Sprite& obj, tweenProperty property, float value, float duration, easeType ease, callback onComplete, void* userData, float delay) {
+    return addTo(obj, property, value, duration, ease, onComplete, userData, delay);
+}
+
+TweenHandle Tween::to(Text& obj, tweenProperty property, float value, float duration, easeType ease, callback onComplete, void* userData, float delay) {
+    return addTo(obj, property, value, duration, ease, onComplete, userData, delay);
+}
+
+TweenHandle Tween::value(float& field, float value, float duration, easeType ease, callback onComplete, void* userData, float delay) {
+    return addTween(&field, nullptr, nullptr, value, duration, ease, onComplete, userData, delay);
+}
+
+bool Tween::isActive(TweenHandle handle) {
+    TweenPool& p = pool();
+    return handle.generation != 0 && handle.index < p.slotGeneration.size() && p.slotGeneration[handle.index] == handle.generation;
+}
+
+bool Tween::cancel(TweenHandle handle) {
+    if (!isActive(handle)) return false;
+
+    pool().removeAt(pool().slotDense[handle.index]);
+    return true;
+}
+
+void Tween::_cancelOwner(u16* owner) {
+    TweenPool& p = pool();
+    for (size_t i = p.size(); i-- > 0 && *owner != 0;) {
+        if (p.owner[i] == owner) {
+            p.removeAt(i);
+        }
+    }
+}
+
+void Tween::cancelAll(Sprite& obj) {
+    if (obj._private.tweens != 0) _cancelOwner(&obj._private.tweens);
+}
+
+void Tween::cancelAll(Text& obj) {
+    if (obj._private.tweens != 0) _cancelOwner(&obj._private.tweens);
+}
+
+size_t Tween::activeCount() {
+    return pool().size();
+}
+
+float Tween::ease(easeType type, float t) {
+    if (!tablesBaked) bakeTables();
+    if (type >= EASE_COUNT) type = EASE_LINEAR;
+
+    if (t <= 0) return 0;
+    if (t >= 1) return 1;
+
+    float pos = t * EASE_SAMPLES;
+    int i = (int)pos;
+    const float* table = easeTables[type];
+    return table[i] + (table[i + 1] - table[i]) * (pos - i);
+}
+
+void Tween::_update(float ms) {
+    DSGE_PROFILE_ZONE("Tween::_update");
+
+    TweenPool& p = pool();
+    if (p.size() == 0) return;
+    if (!tablesBaked) bakeTables();
+
+    float dt = ms / 1000;
+    size_t count = p.size();
+
+    for (size_t i = 0; i < count; i++) {
+        float time = p.time[i] += dt;
+        if (time < p.delay[i]) continue;
+
+        if (!p.started[i]) {
+            p.from[i] = *p.target[i];
+            p.started[i] = true;
+        }
+
+        float t = p.invDuration[i] == 0 ? 1 : (time - p.delay[i]) * p.invDuration[i];
+        if (t >= 1) {
+            t = 1;
+            p.finished.push_back(i);
+        }
+
+        float value = p.from[i] + (p.to[i] - p.from[i]) * ease((easeType)p.easing[i], t);
+        *p.target[i] = value;
+        if (p.target2[i]) *p.target2[i] = value;
+    }
+
+    if (p.finished.empty()) return;
+
+    // Highest first, so swap-removing never moves a finished tween that isn't handled yet.
+    for (size_t n = p.finished.size(); n-- > 0;) {
+        u32 i = p.finished[n];
+        if (p.onComplete[i]) {
+            p.callbacks.push_back({p.onComplete[i], p.userData[i]});
+        }
+        p.removeAt(i);
+    }
+    p.finished.clear();
+
+    // Called last, callbacks are free to make or cancel tweens.
+    for (size_t i = 0; i < p.callbacks.size(); i++) {
+        p.callbacks[i].first(p.callbacks[i].second);
+    }
+    p.callbacks.clear();
+}
+} // namespace dsge
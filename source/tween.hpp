@@ -0,0 +1,144 @@
+#ifndef DSGE_TWEEN_HPP
+#define DSGE_TWEEN_HPP
+
+#include "dsge.hpp"
+
+typedef enum {
+    TWEEN_X = 0,       // X position
+    TWEEN_Y = 1,       // Y position
+    TWEEN_ALPHA = 2,   // Alpha transparency
+    TWEEN_ANGLE = 3,   // Rotation angle
+    TWEEN_SCALE = 4,   // Both horizontal and vertical scale
+    TWEEN_SCALE_X = 5, // Horizontal scale
+    TWEEN_SCALE_Y = 6  // Vertical scale
+} tweenProperty;
+
+typedef enum {
+    EASE_LINEAR = 0,
+    EASE_QUAD_IN, EASE_QUAD_OUT, EASE_QUAD_IN_OUT,
+    EASE_CUBE_IN, EASE_CUBE_OUT, EASE_CUBE_IN_OUT,
+    EASE_QUART_IN, EASE_QUART_OUT, EASE_QUART_IN_OUT,
+    EASE_QUINT_IN, EASE_QUINT_OUT, EASE_QUINT_IN_OUT,
+    EASE_SINE_IN, EASE_SINE_OUT, EASE_SINE_IN_OUT,
+    EASE_EXPO_IN, EASE_EXPO_OUT, EASE_EXPO_IN_OUT,
+    EASE_CIRC_IN, EASE_CIRC_OUT, EASE_CIRC_IN_OUT,
+    EASE_BACK_IN, EASE_BACK_OUT, EASE_BACK_IN_OUT,
+    EASE_ELASTIC_IN, EASE_ELASTIC_OUT, EASE_ELASTIC_IN_OUT,
+    EASE_BOUNCE_IN, EASE_BOUNCE_OUT, EASE_BOUNCE_IN_OUT,
+    EASE_COUNT
+} easeType;
+
+namespace dsge {
+// A handle to a running tween, stale once the tween completes or is cancelled.
+struct TweenHandle {
+    u32 index = 0;
+    u32 generation = 0; // 0 is never valid.
+};
+
+class Tween {
+public:
+    typedef void (*callback)(void* userData);
+
+    /**
+     * @brief Tweens a property of a sprite or text to a value.
+     * @param obj The sprite or text to tween.
+     * @param property The property to tween, see `tweenProperty`.
+     * @param value The value to end at.
+     * @param duration How long the tween takes, in seconds.
+     * @param ease The easing to use, linear by default.
+     * @param onComplete Called once the tween is done, lambdas without captures work too. Optional.
+     * @param userData Passed as is to `onComplete`. Optional.
+     * @param delay Seconds to wait before starting, the start value is taken once the delay is over. Optional.
+     * @return A handle to cancel the tween.
+     * 
+     * Tweens are updated once per `dsge::render()`, they're cancelled if the sprite or text gets destroyed.
+     * 
+     * #### Example Usage:
+     * ```
+     * dsge::Sprite box(0, 100);
+     * box.makeGraphic(20, 20);
+     * 
+     * // Slides to x 300 in 1.5 seconds.
+     * dsge::Tween::to(box, TWEEN_X, 300, 1.5, EASE_QUAD_OUT);
+     * 
+     * // Fades out, then traces.
+     * dsge::Tween::to(box, TWEEN_ALPHA, 0, 0.5, EASE_LINEAR, [](void*) {
+     *     trace("Faded out!");
+     * });
+     * ```
+     */
+    static TweenHandle to(Sprite& obj, tweenProperty property, float value, float duration, easeType ease = EASE_LINEAR, callback onComplete = nullptr, void* userData = nullptr, float delay = 0);
+    static TweenHandle to(Text& obj, tweenProperty property, float value, float duration, easeType ease = EASE_LINEAR, callback onComplete = nullptr, void* userData = nullptr, float delay = 0);
+
+    /**
+     * @brief Tweens any float to a value.
+     * @param field The float to tween, it must outlive the tween (or cancel it first).
+     * 
+     * The rest of the arguments are the same as `Tween::to()`.
+     * 
+     * #### Example Usage:
+     * ```
+     * float volume = 1;
+     * dsge::Tween::value(volume, 0, 2, EASE_SINE_IN);
+     * ```
+     */
+    static TweenHandle value(float& field, float value, float duration, easeType ease = EASE_LINEAR, callback onComplete = nullptr, void* userData = nullptr, float delay = 0);
+
+    /**
+     * @brief Stops a tween where it is, `onComplete` isn't called.
+     * @return `true` if cancelled, `false` if it already completed or got cancelled.
+     * 
+     * #### Example Usage:
+     * ```
+     * dsge::TweenHandle slide = dsge::Tween::to(box, TWEEN_X, 300, 1.5);
+     * dsge::Tween::cancel(slide);
+     * ```
+     */
+    static bool cancel(TweenHandle handle);
+
+    /**
+     * @brief Stops every tween of a sprite or text, `onComplete` isn't called.
+     * 
+     * #### Example Usage:
+     * ```
+     * dsge::Tween::cancelAll(box);
+     * ```
+     */
+    static void cancelAll(Sprite& obj);
+    static void cancelAll(Text& obj);
+
+    /**
+     * @brief Whetever or not a tween is still running.
+     * 
+     * #### Example Usage:
+     * ```
+     * if (!dsge::Tween::isActive(slide)) {
+     *     trace("Slide done!");
+     * }
+     * ```
+     */
+    static bool isActive(TweenHandle handle);
+
+    /**
+     * @brief Amount of running tweens.
+     */
+    static size_t activeCount();
+
+    /**
+     * @brief Returns the eased value of `t`, from the baked easing tables.
+     * @param type The easing to use.
+     * @param t The progress, from 0 to 1.
+     * 
+     * #### Example Usage:
+     * ```
+     * dsge::Tween::ease(EASE_QUAD_IN, 0.5); // Returns 0.25
+     * ```
+     */
+    static float ease(easeType type, float t);
+
+    static void _update(float ms);
+    static void _cancelOwner(u16* owner);
+};
+} // namespace dsge
+
+#endif
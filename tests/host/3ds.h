@@ -0,0 +1,36 @@
+/*
+    Just enough of libctru for the host tests, so the parts of dsge that are only math can be built with a plain g++.
+*/
+#ifndef DSGE_TEST_3DS_H
+#define DSGE_TEST_3DS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int8_t s8;
+typedef int16_t s16;
+typedef int32_t s32;
+typedef int64_t s64;
+
+#define SYSCLOCK_ARM11 268111856LL
+
+enum {
+    NDSP_WBUF_FREE = 0,
+    NDSP_WBUF_QUEUED = 1,
+    NDSP_WBUF_PLAYING = 2,
+    NDSP_WBUF_DONE = 3
+};
+
+// Only the fields the position math reads.
+typedef struct {
+    u32 nsamples;
+    u8  status;
+    u16 sequence_id;
+} ndspWaveBuf;
+
+#endif
@@ -0,0 +1,13 @@
+#!/bin/sh
+# Builds and runs every host test with the system's g++, from the root of the repo: sh tests/run.sh
+set -e
+mkdir -p tests/build
+
+g++ -std=gnu++20 -Wall -Itests/host -Isource tests/transform_test.cpp source/transform.cpp -o tests/build/transform_test
+tests/build/transform_test
+
+g++ -std=gnu++20 -Wall -Itests/host -Isource tests/shape_test.cpp source/shape.cpp source/transform.cpp -o tests/build/shape_test
+tests/build/shape_test
+
+g++ -std=gnu++20 -Wall -Itests/host -Isource tests/sound_position_test.cpp source/soundclock.cpp -o tests/build/sound_position_test
+tests/build/sound_position_test
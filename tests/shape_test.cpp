@@ -0,0 +1,196 @@
+/*
+    Host test of the box, circle and capsule kernels, against a brute force reference that samples a dense grid of
+    points in and around both shapes.
+
+    g++ -std=gnu++20 -Itests/host -Isource tests/shape_test.cpp source/shape.cpp source/transform.cpp -o shape_test && ./shape_test
+*/
+#include "shape.hpp"
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+
+using dsge::Penetration;
+using dsge::Shape;
+using dsge::_internal::Collider;
+using dsge::_internal::Transform;
+
+const float STEP = 0.2f;    // Grid spacing of the reference.
+const float MARGIN = 0.05f; // Points closer than this to an edge don't count, floats can go either way there.
+
+int failures = 0;
+int checks = 0;
+
+void check(bool ok, const char* what, int seed) {
+    checks++;
+    if (!ok) {
+        if (failures < 20) printf("FAIL %s (case %d)\n", what, seed);
+        failures++;
+    }
+}
+
+// Same numbers every run.
+u32 state = 1;
+float random(float min, float max) {
+    state = state * 1664525u + 1013904223u;
+    return min + (max - min) * (state >> 8) / (float)(1 << 24);
+}
+
+// Signed distance from the edge of a placed collider, negative inside. Only uses the collider's own placement.
+float distance(const Collider& c, float px, float py) {
+    float dx = px - c.cx, dy = py - c.cy;
+    float along = dx * c.ux + dy * c.uy;
+    float side = dy * c.ux - dx * c.uy;
+
+    switch (c.shape.type) {
+        case SHAPE_BOX: {
+            float ox = fabsf(along) - c.hx, oy = fabsf(side) - c.hy;
+            float outside = sqrtf(fmaxf(ox, 0) * fmaxf(ox, 0) + fmaxf(oy, 0) * fmaxf(oy, 0));
+            return outside + fminf(fmaxf(ox, oy), 0);
+        }
+        case SHAPE_CAPSULE: {
+            float t = std::clamp(along, -c.hx, c.hx);
+            return sqrtf((along - t) * (along - t) + side * side) - c.radius;
+        }
+        default:
+            return sqrtf(dx * dx + dy * dy) - c.radius;
+    }
+}
+
+// Whetever some point of the grid is inside both, by at least `margin`.
+bool overlapSampled(const Collider& a, const Collider& b, float margin) {
+    float left = fmaxf(a.bounds.left, b.bounds.left), right = fminf(a.bounds.right, b.bounds.right);
+    float top = fmaxf(a.bounds.top, b.bounds.top), bottom = fminf(a.bounds.bottom, b.bounds.bottom);
+
+    for (float y = top; y <= bottom; y += STEP) {
+        for (float x = left; x <= right; x += STEP) {
+            if (distance(a, x, y) < -margin && distance(b, x, y) < -margin) return true;
+        }
+    }
+    return false;
+}
+
+// Copies of a collider have to be placed again, so the placement is copied by hand.
+Collider moved(const Collider& c, float dx, float dy) {
+    Collider out;
+    out.set(c.shape);
+    out.cx = c.cx + dx;
+    out.cy = c.cy + dy;
+    out.ux = c.ux;
+    out.uy = c.uy;
+    out.hx = c.hx;
+    out.hy = c.hy;
+    out.radius = c.radius;
+    out.bounds = {c.bounds.left + dx, c.bounds.top + dy, c.bounds.right + dx, c.bounds.bottom + dy};
+    return out;
+}
+
+Shape randomShape(int type) {
+    switch (type) {
+        case SHAPE_BOX:    return Shape::box(random(2, 30), random(2, 30), random(-5, 5), random(-5, 5));
+        case SHAPE_CIRCLE: return Shape::circle(random(1, 15), random(-5, 5), random(-5, 5));
+        default:           return Shape::capsule(random(0, 30), random(1, 8), random(-5, 5), random(-5, 5));
+    }
+}
+
+// A shape on an object of random size, rotation, scale and flip, within reach of the center of the screen.
+Collider place(Transform& t, int type) {
+    float w = random(4, 40), h = random(4, 40), scale = random(0.5f, 2);
+    float sx = random(0, 1) < 0.25f ? -scale : scale;
+    float sy = random(0, 1) < 0.25f ? -scale : scale;
+    t.update({random(80, 120), random(80, 120), random(-180, 180), sx, sy, w / 2, h / 2, w / 2, h / 2, w, h});
+
+    Collider c;
+    c.set(randomShape(type));
+    c.update(t, w / 2, h / 2);
+    return c;
+}
+
+// Every point inside has to be inside the bounds too, or the box pretest would miss it.
+void checkBounds(const Collider& c, int seed) {
+    float reach = 80;
+    bool inside = true;
+    for (float y = c.cy - reach; y <= c.cy + reach && inside; y += 1) {
+        for (float x = c.cx - reach; x <= c.cx + reach && inside; x += 1) {
+            if (distance(c, x, y) < -MARGIN) {
+                inside = x >= c.bounds.left && x <= c.bounds.right && y >= c.bounds.top && y <= c.bounds.bottom;
+            }
+        }
+    }
+    check(inside, "bounds don't hold the whole shape", seed);
+}
+
+int main() {
+    const char* names[] = {"box", "circle", "capsule"};
+    int seed = 0;
+
+    for (int ta = SHAPE_BOX; ta <= SHAPE_CAPSULE; ta++) {
+        for (int tb = SHAPE_BOX; tb <= SHAPE_CAPSULE; tb++) {
+            int hits = 0;
+            int before = failures;
+
+            for (int i = 0; i < 300; i++, seed++) {
+                Transform ta_, tb_;
+                Collider a = place(ta_, ta);
+                Collider b = place(tb_, tb);
+                checkBounds(a, seed);
+
+                Penetration pen = {0, 0, 0};
+                bool hit = dsge::_internal::intersect(a, b, &pen);
+                check(hit == dsge::_internal::intersect(b, a, nullptr), "not symmetric", seed);
+
+                // Clearly overlapping has to hit, a hit has to overlap unless it's too thin to sample.
+                if (overlapSampled(a, b, MARGIN)) check(hit, "missed an overlap", seed);
+                if (hit && pen.depth > 2 * STEP) check(overlapSampled(a, b, -MARGIN), "hit without overlapping", seed);
+                if (!hit) continue;
+                hits++;
+
+                check(fabsf(sqrtf(pen.x * pen.x + pen.y * pen.y) - pen.depth) < 0.01f, "depth isn't the length of the vector", seed);
+
+                // Moving a by the vector (plus a bit) separates them...
+                float nx = pen.depth > 0 ? pen.x / pen.depth : 0, ny = pen.depth > 0 ? pen.y / pen.depth : 0;
+                Collider out = moved(a, pen.x + nx * 0.1f, pen.y + ny * 0.1f);
+                check(!overlapSampled(out, b, MARGIN), "moving by the penetration doesn't separate", seed);
+
+                // ...and it's not much more than needed, three quarters of the way still overlaps.
+                if (pen.depth > 4) {
+                    Collider part = moved(a, pen.x * 0.75f, pen.y * 0.75f);
+                    check(overlapSampled(part, b, MARGIN), "penetration is longer than needed", seed);
+                }
+            }
+
+            printf("%s vs %s: %d of 300 overlapping, %s\n", names[ta], names[tb], hits, failures == before ? "OK" : "FAILED");
+        }
+    }
+
+    // A sprite without a shape is a box of it's own size, placed like it's drawn. Attached, flipped or rotated, it has
+    // to cover it's bounds, and meet a shape on another sprite in the same space.
+    int before = failures;
+    for (int i = 0; i < 300; i++, seed++) {
+        Transform parent, child, other;
+        parent.attach(child);
+        float w = random(4, 40), h = random(4, 40), angle = random(0, 1) < 0.5f ? 0 : random(-180, 180);
+        float sx = random(0, 1) < 0.5f ? -1 : 1, sy = random(0, 1) < 0.5f ? -1 : 1;
+        parent.update({random(60, 140), random(60, 140), random(-180, 180), 1, 1, 10, 10, 10, 10, 20, 20});
+        child.update({random(-20, 20), random(-20, 20), angle, sx, sy, w * sx / 2, h * sy / 2, w / 2, h / 2, w, h});
+
+        Collider box;
+        box.shape.width = w;
+        box.shape.height = h;
+        box.update(child, w / 2, h / 2);
+        const dsge::_internal::Bounds& b = child.bounds;
+        check(fabsf(box.bounds.left - b.left) < 0.01f && fabsf(box.bounds.top - b.top) < 0.01f && fabsf(box.bounds.right - b.right) < 0.01f && fabsf(box.bounds.bottom - b.bottom) < 0.01f, "plain box isn't over the sprite's bounds", seed);
+
+        // A small circle right on the middle of the drawn sprite.
+        float mx, my;
+        child.world.apply(w / 2, h / 2, mx, my);
+        other.update({mx + 2, my - 2, 0, -1, 1, -2, 2, 2, 2, 4, 4});
+        Collider dot;
+        dot.set(Shape::circle(1));
+        dot.update(other, 2, 2);
+        check(dsge::_internal::intersect(box, dot, nullptr), "plain box misses a shape on it's middle", seed);
+    }
+    printf("plain box on an attached sprite: %s\n", failures == before ? "OK" : "FAILED");
+
+    printf("shape_test: %d checks, %d failed\n", checks, failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,57 @@
+/*
+    Host test of the math behind Sound::getPosition(), Sound::getSamplesPlayed() and the sample accurate starts:
+    which wave buffer the DSP is on, how far to guess in between DSP frames and the silence before a start.
+
+    g++ -std=gnu++20 -Itests/host -Isource tests/sound_position_test.cpp source/soundclock.cpp -o sound_position_test && ./sound_position_test
+*/
+#include "soundclock.hpp"
+#include <stdio.h>
+
+using namespace dsge::_internal;
+
+int failures = 0;
+
+void check(bool ok, const char* what) {
+    if (!ok) {
+        printf("FAIL %s\n", what);
+        failures++;
+    }
+}
+
+int main() {
+    // Three buffers of 100 samples queued back to back, the last one went past the end of a 1050 sample file.
+    ndspWaveBuf bufs[3] = {{100, NDSP_WBUF_DONE, 10}, {100, NDSP_WBUF_PLAYING, 11}, {100, NDSP_WBUF_QUEUED, 12}};
+    u64 starts[3] = {0, 100, 200};
+    u32 fileStarts[3] = {900, 1000, 0};
+    u64 played;
+    u32 file;
+
+    check(bufferPosition(bufs, starts, fileStarts, 3, 11, 40, 1050, played, file) && played == 140 && file == 1040, "position inside of the playing buffer");
+    check(bufferPosition(bufs, starts, fileStarts, 3, 11, 70, 1050, played, file) && played == 170 && file == 20, "loops back to the start of the file");
+    check(bufferPosition(bufs, starts, fileStarts, 3, 12, 500, 1050, played, file) && played == 300 && file == 100, "offset clamped to the end of the buffer");
+    check(bufferPosition(bufs, starts, fileStarts, 3, 12, 30, 0, played, file) && played == 230 && file == 30, "no wrap without a total");
+    check(!bufferPosition(bufs, starts, fileStarts, 3, 9, 0, 1050, played, file), "unknown sequence");
+    check(!bufferPosition(bufs, starts, fileStarts, 3, 10, 0, 1050, played, file), "finished buffer");
+
+    // Guessed from the time since the DSP got read, never back in time and at most two DSP frames.
+    u64 ms = SYSCLOCK_ARM11 / 1000;
+    check(samplesSince(100, 50, 32000) == 0, "time going backwards");
+    check(samplesSince(100, 100, 32000) == 0, "no time passed");
+    u64 one = samplesSince(0, ms, 32000);
+    check(one >= 31 && one <= 32, "1ms at 32000Hz");
+    u64 capped = samplesSince(0, SYSCLOCK_ARM11, 32728);
+    check(capped >= 319 && capped <= 320, "capped at two DSP frames");
+    check(samplesSince(0, SYSCLOCK_ARM11, 44100) == samplesSince(0, 2 * SYSCLOCK_ARM11, 44100), "the cap doesn't depend on how late it is");
+
+    // Silence before a start, at the stream's rate and rounded to the nearest sample.
+    check(leadInSamples(100, 200, 44100) == 0, "target already passed");
+    check(leadInSamples(200, 200, 44100) == 0, "target at the start of the frame");
+    check(leadInSamples(360, 200, 32728) == 160, "a whole frame at the DSP rate");
+    check(leadInSamples(280, 200, 44100) == 108, "rounded, 80 * 44100 / 32728.498 is 107.8");
+    check(leadInSamples(201, 200, 16000) == 0, "half a sample or less rounds down");
+
+    if (failures == 0) {
+        printf("sound_position_test: OK\n");
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,112 @@
+/*
+    Host test of the cached transforms, checks that the quad citro2d draws for a sprite's image is the one `bounds`
+    and the hitboxes use, flipped, rotated and parented.
+
+    g++ -std=gnu++20 -Itests/host -Isource tests/transform_test.cpp source/transform.cpp -o transform_test && ./transform_test
+*/
+#include "transform.hpp"
+#include <math.h>
+#include <stdio.h>
+
+using dsge::_internal::Transform;
+
+int failures = 0;
+
+void check(bool ok, const char* name, const char* what) {
+    if (!ok) {
+        printf("FAIL %s: %s\n", name, what);
+        failures++;
+    }
+}
+
+bool near(float a, float b) {
+    return fabsf(a - b) < 0.01f;
+}
+
+// Inputs the way Sprite sets them, rotating and scaling around the center.
+Transform::Inputs inputs(float x, float y, float angle, bool flipX, bool flipY, float scale = 1) {
+    float w = 40, h = 20;
+    return {x, y, angle, flipX ? -scale : scale, flipY ? -scale : scale, w / 2, h / 2, w / 2, h / 2, w, h};
+}
+
+/*
+    Same as C2D_DrawImage() with a center of (0, 0): the quad is (0, 0) to (|w|, |h|) rotated around and moved to
+    (x, y), a negative size only swaps the texture coordinates. Returns where texture corner (u, v) ends up.
+*/
+void drawnCorner(const Transform::ImageQuad& q, float u, float v, float& outX, float& outY) {
+    float w = fabsf(q.w), h = fabsf(q.h);
+    float lx = (q.w < 0 ? 1 - u : u) * w;
+    float ly = (q.h < 0 ? 1 - v : v) * h;
+    float c = cosf(q.angle), s = sinf(q.angle);
+    outX = q.x + lx * c - ly * s;
+    outY = q.y + lx * s + ly * c;
+}
+
+void checkQuad(const char* name, const Transform& t, float width, float height) {
+    Transform::ImageQuad q = t.imageQuad(width, height);
+
+    float left = 1e9, top = 1e9, right = -1e9, bottom = -1e9;
+    for (int i = 0; i < 4; i++) {
+        float u = i & 1, v = i >> 1;
+        float dx, dy, wx, wy;
+        drawnCorner(q, u, v, dx, dy);
+        t.world.apply(u * width, v * height, wx, wy);
+        check(near(dx, wx) && near(dy, wy), name, "texture corner drawn away from where the world transform puts it");
+
+        left = fminf(left, dx);
+        top = fminf(top, dy);
+        right = fmaxf(right, dx);
+        bottom = fmaxf(bottom, dy);
+    }
+
+    check(near(left, t.bounds.left) && near(top, t.bounds.top) && near(right, t.bounds.right) && near(bottom, t.bounds.bottom), name, "drawn quad doesn't match bounds");
+}
+
+int main() {
+    struct { const char* name; Transform::Inputs in; } cases[] = {
+        {"plain", inputs(100, 50, 0, false, false)},
+        {"flipX", inputs(100, 50, 0, true, false)},
+        {"flipY", inputs(100, 50, 0, false, true)},
+        {"flipXY", inputs(100, 50, 0, true, true)},
+        {"rotated", inputs(100, 50, 30, false, false)},
+        {"rotated flipX", inputs(100, 50, 30, true, false)},
+        {"rotated flipY", inputs(100, 50, -75, false, true)},
+        {"scaled flipY", inputs(10, 200, 0, false, true, 2.5f)},
+    };
+
+    for (auto &&c : cases) {
+        Transform t;
+        t.update(c.in);
+        checkQuad(c.name, t, c.in.width, c.in.height);
+    }
+
+    // Flips and rotations of the parent carry over to the child.
+    Transform parent, child;
+    parent.attach(child);
+    parent.update(inputs(200, 120, 45, true, false));
+    child.update(inputs(10, 5, -20, false, true));
+    checkQuad("parent flipX, child flipY", child, 40, 20);
+
+    parent.update(inputs(200, 120, 0, false, true));
+    child.update(inputs(10, 5, 0, false, false));
+    checkQuad("parent flipY", child, 40, 20);
+
+    // The bounds follow a flip, flipY of an unrotated sprite covers the same area.
+    Transform a, b;
+    a.update(inputs(100, 50, 0, false, false));
+    b.update(inputs(100, 50, 0, false, true));
+    check(near(a.bounds.top, b.bounds.top) && near(a.bounds.bottom, b.bounds.bottom), "flipY bounds", "flipping moved the bounds");
+
+    // Sprites collide with their bounds, so an attached and flipped sprite's box is where it's drawn, not at it's own x/y.
+    Transform holder, held;
+    holder.attach(held);
+    holder.update(inputs(200, 120, 0, false, false));
+    held.update({10, 5, 0, -1, -1, -20, -10, 20, 10, 40, 20}); // Exactly like Sprite, flipping grows it to the left/top.
+    checkQuad("attached flipXY", held, 40, 20);
+    check(near(held.bounds.left, 170) && near(held.bounds.top, 105) && near(held.bounds.right, 210) && near(held.bounds.bottom, 125), "attached flipXY bounds", "hit box isn't where the sprite is drawn");
+
+    if (failures == 0) {
+        printf("transform_test: OK\n");
+    }
+    return failures == 0 ? 0 : 1;
+}